@@ -7,7 +7,7 @@
 
 #include "stm32f10x.h"
 #include "mem_manage.h"
-#include <time.h>
+#include "mem_workload.h"
 
 static void __NVIC_CONFIG(void)
 {
@@ -32,60 +32,56 @@ static void __rcc_clock_config(void)
 }
  
 /************** 内存碎片测试程序 ************
- * 利用 rand 产生指定范围内的伪随机数，然后申请对应大小的内存
- * 释放内存时，也随机释放
+ * 用 mem_workload 按阶段产生负载: 先复现原来的 1~210 字节均匀随机申请/随机释放，
+ * 再切换到双峰尺寸 + FIFO 释放、2 的幂尺寸 + LIFO 释放，首次申请失败时停止
 *******************************************/
 #define TEST_BLOCK_NUM  210
-static uint8_t *(user[TEST_BLOCK_NUM + 1]) = {NULL};
+static MemWorkloadSlot_t xTestSlots[TEST_BLOCK_NUM];
+static const MemWorkloadPhase_t xTestPhases[] = {
+	{ 20000, MEM_WL_SIZE_UNIFORM, 1, 210,  0, 0,  0,   0,  MEM_WL_LIFE_RANDOM, 60, 0 },
+	{ 20000, MEM_WL_SIZE_BIMODAL, 8, 1024, 0, 32, 512, 10, MEM_WL_LIFE_FIFO,   60, 64 },
+	{ 20000, MEM_WL_SIZE_POW2,    8, 512,  0, 0,  0,   0,  MEM_WL_LIFE_LIFO,   65, 0 },
+};
 
-static uint32_t __build_rand_value(void)
-{
-	uint32_t rand_value = 0;
-	rand_value = rand() % TEST_BLOCK_NUM;
-	if(rand_value == 0)
-		rand_value = rand_value + 1;
-	
-	return rand_value;
-}
+extern uint32_t SysTickCount;
 
-static uint32_t calcate_used_mem_size(void)
+static uint32_t get_tick_ms(void)
 {
-    uint32_t i = 0,usedMemSize = 0;
-    for ( i = 0; i < TEST_BLOCK_NUM + 1; i++){
-        if (user[i] != NULL){
-            usedMemSize += i;
-        }
-    }
-    return usedMemSize;
+    return *(volatile uint32_t *)&SysTickCount;
 }
 
-static int mem_manage_test(void)
+static void mem_manage_test(void)
 {
-    uint32_t rand_value = 0, size = 0;
-    static uint32_t count = 0;
-
-    if (count == 0){
-        srand(125);
-        count = 1;
-    }
-
-    rand_value = __build_rand_value();
-
-    size = rand_value;
-    if (user[rand_value] == NULL){
-        user[rand_value] = (uint8_t *)MEM_MALLOC(size);
-        if (user[rand_value] == NULL){
-            return -1;
-        }
-    }
-
-    rand_value = __build_rand_value();
-    if (user[rand_value] != NULL){
-        MEM_FREE(user[rand_value]);
-        user[rand_value] = NULL;
+    MemWorkload_t xWorkload;
+    MemWorkloadConfig_t xConfig;
+    const MemWorkloadResult_t *pxResult = &xWorkload.xResult;
+
+    memset(&xConfig, 0, sizeof(xConfig));
+    xConfig.pfMalloc = MEM_MALLOC;
+    xConfig.pfFree = MEM_FREE;
+    xConfig.pfFreeBytes = memGetFreeHeapSize;
+    xConfig.pfFreeBlockNum = memGetFreeBlockNum;
+    xConfig.pfTick = get_tick_ms;
+    xConfig.ulTickHz = 1000;
+    xConfig.pxPhases = xTestPhases;
+    xConfig.ulPhaseNum = sizeof(xTestPhases) / sizeof(xTestPhases[0]);
+    xConfig.pxSlots = xTestSlots;
+    xConfig.ulSlotNum = TEST_BLOCK_NUM;
+    xConfig.ulSeed = 125;
+    xConfig.ucStopOnFail = 1;
+    memWorkloadInit(&xWorkload, &xConfig);
+
+    memWorkloadRun(&xWorkload);
+
+    SEGGER_RTT_printf(0,"test complete,ops:%d,ops/s:%d.\n",pxResult->ulOps,pxResult->ulOpsPerSec);
+    if (pxResult->ulFirstFailOp != 0){
+        SEGGER_RTT_printf(0,"first fail:op %d,phase %d,size %d,usage rate:%d%c,free blocks:%d\n",pxResult->ulFirstFailOp,\
+                            pxResult->ulFirstFailPhase,pxResult->ulFirstFailSize,pxResult->ulUtilizationAtFail / 10,37,\
+                            pxResult->ulFreeBlocksAtFail);
     }
+    memPrintfFreeListLayout();
 
-    return 0;
+    memWorkloadRelease(&xWorkload);
 }
 
 static void malloc_fail_handle(size_t xWantedSize)
@@ -101,9 +97,6 @@ static MemHeapRegion_t xHeapRegions[] ={
 
 int main(void)
 {
-    uint32_t freeMemBlockMaxNum = 0, freeNum = 0, testCount = 0;
-    uint32_t usedMemSize = 0, freeMemSize = 0;
-
     mem_manage_t mem_manage;
     memset(&mem_manage,0,sizeof(mem_manage_t));
     mem_manage.malloc_fail_cb = malloc_fail_handle;
@@ -114,28 +107,11 @@ int main(void)
 
 	SEGGER_RTT_printf(0,"mem test start.....\n");
 
+    mem_manage_test();
+
     while(1)
     {
-		// SysTick_delay_ms(5);
-		
-        freeNum = memGetFreeBlockNum();
-		if( freeNum > freeMemBlockMaxNum ){
-            freeMemBlockMaxNum = freeNum;
-        }
-
-        if( mem_manage_test() != 0){
-            SEGGER_RTT_printf(0,"test complete,count:%d.\n",testCount);
-            usedMemSize = calcate_used_mem_size();
-            freeMemSize = memGetFreeHeapSize();
-            SEGGER_RTT_printf(0,"used size:%d,free size:%d,usage rate:%d%c\n",usedMemSize,freeMemSize,\
-                                (usedMemSize * 100) / (freeMemSize + usedMemSize),37);
-            memPrintfFreeListLayout();
-            break;
-        }
-		testCount++;
     }
-
-
 }
 
 
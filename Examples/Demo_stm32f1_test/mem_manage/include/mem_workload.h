@@ -0,0 +1,180 @@
+/************************************
+ * @file: mem_workload.h
+ * @author: LinusZhao
+ * @brief: 合成负载生成器，按配置的尺寸分布、生命周期模型和阶段序列调用申请/释放接口
+ * @version: 1.0.0
+ * @date: 2021-01-01
+ * @attention: 不依赖 mem_manage 内部实现，目标板与主机通用；申请/释放及统计接口通过函数指针传入，
+ * 同一份配置可用于比较不同引擎或编译配置。随机数为内置 xorshift32，同一种子在各平台上序列一致。
+ * 使用代码参考:
+	static MemWorkloadSlot_t xSlots[ 128 ];
+	static const MemWorkloadPhase_t xPhases[] = {
+		// 操作数  尺寸分布                 min max  mean small large large%  生命周期             申请%  存活上限
+		{ 20000, MEM_WL_SIZE_UNIFORM,     1,  210, 0,   0,    0,    0,      MEM_WL_LIFE_RANDOM,   60,    0 },
+		{ 20000, MEM_WL_SIZE_BIMODAL,     8,  1024, 0,  32,   512,  10,     MEM_WL_LIFE_FIFO,     55,    64 },
+	};
+
+	int main(void)
+	{
+		MemWorkload_t xWorkload;
+		MemWorkloadConfig_t xConfig;
+
+		memset(&xConfig, 0, sizeof(xConfig));
+		xConfig.pfMalloc = memMalloc;
+		xConfig.pfFree = memFree;
+		xConfig.pfFreeBytes = memGetFreeHeapSize;
+		xConfig.pfFreeBlockNum = memGetFreeBlockNum;
+		xConfig.pxPhases = xPhases;
+		xConfig.ulPhaseNum = sizeof(xPhases) / sizeof(xPhases[0]);
+		xConfig.pxSlots = xSlots;
+		xConfig.ulSlotNum = sizeof(xSlots) / sizeof(xSlots[0]);
+		xConfig.ulSeed = 125;
+		memWorkloadInit(&xWorkload, &xConfig);
+		memWorkloadRun(&xWorkload);
+		// 结果见 xWorkload.xResult
+		memWorkloadRelease(&xWorkload);
+	}
+*************************************/
+
+#ifndef __MEM_WORKLOAD_H__
+#define __MEM_WORKLOAD_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+/* 申请尺寸分布，结果均截断到 [ulSizeMin, ulSizeMax] */
+typedef enum
+{
+	MEM_WL_SIZE_UNIFORM = 0,		// [ulSizeMin, ulSizeMax] 均匀分布
+	MEM_WL_SIZE_EXPONENTIAL = 1,	// 均值为 ulSizeMean 的指数分布
+	MEM_WL_SIZE_BIMODAL = 2,		// ucLargePercent% 的概率取 [ulSizeLarge, ulSizeMax]，否则取 [ulSizeMin, ulSizeSmall]
+	MEM_WL_SIZE_POW2 = 3			// [ulSizeMin, ulSizeMax] 内的 2 的幂，各幂次等概率
+} MemWlSizeDist_t;
+
+/* 生命周期模型: 决定释放哪一个存活块 */
+typedef enum
+{
+	MEM_WL_LIFE_FIFO = 0,				// 最早申请的先释放
+	MEM_WL_LIFE_LIFO = 1,				// 最后申请的先释放
+	MEM_WL_LIFE_RANDOM = 2,				// 随机释放一个存活块
+	MEM_WL_LIFE_PRODUCER_CONSUMER = 3	// 生产者申请、消费者按先后顺序释放；
+										// memWorkloadRun 中两者在同一线程内交替，跨线程见 memWorkloadProducer
+} MemWlLifetime_t;
+
+/* 一个负载阶段，阶段切换时已存活的内存块保留，由新阶段的生命周期模型释放 */
+typedef struct MemWorkloadPhase
+{
+	uint32_t ulOps;				// 本阶段操作数(申请与释放各算一次)
+	MemWlSizeDist_t eSizeDist;
+	uint32_t ulSizeMin;
+	uint32_t ulSizeMax;
+	uint32_t ulSizeMean;		// MEM_WL_SIZE_EXPONENTIAL 使用
+	uint32_t ulSizeSmall;		// MEM_WL_SIZE_BIMODAL 使用
+	uint32_t ulSizeLarge;		// MEM_WL_SIZE_BIMODAL 使用
+	uint8_t ucLargePercent;		// MEM_WL_SIZE_BIMODAL 使用
+	MemWlLifetime_t eLifetime;
+	uint8_t ucAllocPercent;		// 存活块数在 0 与上限之间时申请的概率(%)，大于 50 时堆逐渐被占满
+	uint32_t ulLiveMax;			// 存活块数上限，0 或大于槽位数时取槽位数
+} MemWorkloadPhase_t;
+
+/* 存活块记录，由调用者提供存储空间 */
+typedef struct MemWorkloadSlot
+{
+	void *pvBlock;
+	uint32_t ulSize;
+} MemWorkloadSlot_t;
+
+typedef struct MemWorkloadConfig
+{
+	void *(*pfMalloc)(size_t xWantedSize);
+	void (*pfFree)(void *pv);
+	size_t (*pfFreeBytes)(void);		// 可选，剩余字节数，用于计算利用率
+	size_t (*pfLargestFree)(void);		// 可选，最大空闲块字节数，用于计算碎片率
+	size_t (*pfFreeBlockNum)(void);		// 可选，空闲块数
+	uint32_t (*pfTick)(void);			// 可选，计时，配合 ulTickHz 计算吞吐
+	uint32_t ulTickHz;
+	void (*pfLock)(void);				// 可选，多线程共享一个不带锁的分配器时使用
+	void (*pfUnlock)(void);
+	void (*pfYield)(void);				// 可选，生产者/消费者等待对方时调用
+	const MemWorkloadPhase_t *pxPhases;
+	uint32_t ulPhaseNum;
+	MemWorkloadSlot_t *pxSlots;
+	uint32_t ulSlotNum;
+	uint32_t ulSeed;					// 0 时取 1
+	uint8_t ucStopOnFail;				// 1: 首次申请失败即停止
+	uint8_t ucTouch;					// 1: 申请后写满内存块，释放前校验首尾字节
+} MemWorkloadConfig_t;
+
+/* 运行结果，千分比字段在缺少对应统计接口时为 0 */
+typedef struct MemWorkloadResult
+{
+	uint32_t ulOps;
+	uint32_t ulAllocs;
+	uint32_t ulFrees;
+	uint32_t ulFails;
+	uint32_t ulCorrupts;				// ucTouch 校验失败次数
+	uint32_t ulFirstFailOp;				// 首次申请失败时的操作序号(从 1 开始)，0 表示未失败
+	uint32_t ulFirstFailPhase;
+	uint32_t ulFirstFailSize;
+	uint32_t ulUtilizationAtFail;		// 首次失败时 存活字节/(存活字节+剩余字节)，千分比
+	uint32_t ulFragmentationAtFail;		// 首次失败时 1-最大空闲块/剩余字节，千分比
+	uint32_t ulFreeBlocksAtFail;
+	uint32_t ulFragmentationFinal;
+	uint32_t ulFreeBlocksFinal;
+	uint64_t ullAllocBytes;				// 累计申请成功的字节数
+	uint64_t ullFreeBytes;				// 累计释放的字节数
+	uint64_t ullPeakLiveBytes;
+	uint32_t ulTicks;
+	uint32_t ulOpsPerSec;				// 需 pfTick 与 ulTickHz
+} MemWorkloadResult_t;
+
+typedef struct MemWorkload
+{
+	MemWorkloadConfig_t xConfig;
+	MemWorkloadResult_t xResult;
+	uint32_t ulRand;
+	volatile uint32_t ulHead;			// 存活块环形队列，ulTail - ulHead 为存活块数
+	volatile uint32_t ulTail;
+	volatile uint8_t ucProducerDone;
+	uint32_t ulStartTick;
+} MemWorkload_t;
+
+/************************************
+ * @brief: 		检查配置并复位负载状态与结果
+ * @param[in] 	pxConfig, 内容被复制，阶段与槽位数组须在运行期间有效
+ * @return 		0-成功，其他为配置错误
+ *************************************/
+int memWorkloadInit( MemWorkload_t *pxWorkload, const MemWorkloadConfig_t *pxConfig );
+
+/************************************
+ * @brief: 		在当前线程依次运行全部阶段
+ * @attention: 	返回时存活块保留，便于查看堆布局，之后调用 memWorkloadRelease 释放
+ * @return 		0-运行完成，-1-ucStopOnFail 时遇到申请失败
+ *************************************/
+int memWorkloadRun( MemWorkload_t *pxWorkload );
+
+/************************************
+ * @brief: 		释放全部存活块
+ *************************************/
+void memWorkloadRelease( MemWorkload_t *pxWorkload );
+
+/************************************
+ * @brief: 		跨线程生产者/消费者模型: 在两个线程(任务)中分别调用，生产者按各阶段的尺寸分布
+ *				申请 ulOps 个内存块放入队列，消费者按先后顺序释放；生命周期与申请概率配置不使用
+ * @attention: 	分配器本身不带锁时须提供 pfLock/pfUnlock；消费者在生产者结束且队列为空后返回，
+ *				并补充碎片率、耗时与吞吐统计，此后 xResult 才完整
+ * @return 		0-完成，-1-ucStopOnFail 时遇到申请失败
+ *************************************/
+int memWorkloadProducer( MemWorkload_t *pxWorkload );
+int memWorkloadConsumer( MemWorkload_t *pxWorkload );
+
+#ifdef __cplusplus
+    }
+#endif
+
+#endif
@@ -43,16 +43,250 @@
 #define MEM_MANAGE_VERSION		"1.0.0"
 
 #define MEM_NO_HANDLE( x )
+
+/* 以下配置项均可在编译命令中通过 -D 覆盖，也可以集中写在一个头文件中，
+   通过 -DMEM_CONFIG_HEADER='"xxx.h"' 指定(例如 tools/mem_sizeclass_gen 生成的尺寸表) */
+#ifdef MEM_CONFIG_HEADER
+#include MEM_CONFIG_HEADER
+#endif
+
+#ifndef memBYTE_ALIGNMENT
 #define memBYTE_ALIGNMENT   			8
+#endif
 
 // #define MEM_MANAGE_PRINTF(fmt, ...)     printf(fmt, ##__VA_ARGS__)
 
+#ifndef TATTER_OPTIME_EN
 #define TATTER_OPTIME_EN	1	// 碎片优化使能
+#endif
+#ifndef MEM_SEARCH_DEPTH_MAX
+#define MEM_SEARCH_DEPTH_MAX	0	// 碎片优化时继续查找更优内存块的最大深度，0 表示不限制
+#endif
+
+/* 快速链表: 刚释放的小内存块按精确尺寸缓存，不合并，同尺寸申请时直接复用；
+   链表溢出或空闲链表中找不到可用内存块时，再合并回空闲链表 */
+#ifndef MEM_QUICK_FIT_EN
+#define MEM_QUICK_FIT_EN		0	// 快速链表使能
+#endif
+#ifndef MEM_QUICK_LIST_NUM
+#define MEM_QUICK_LIST_NUM		16	// 快速链表条数，第 i 条缓存用户区大小为 (i+1)*memBYTE_ALIGNMENT 的内存块
+#endif
+#ifndef MEM_QUICK_LIST_DEPTH
+#define MEM_QUICK_LIST_DEPTH	8	// 每条快速链表最多缓存的内存块个数
+#endif
+
+/* 快速链表自适应: 按用户区大小统计申请次数的直方图，调用 memQuickListRebalance 时把快速链表重新分配给
+   申请次数最多的尺寸，不再被选中的链表缓存的内存块合并回空闲链表；每次调整后直方图减半，旧的负载逐渐淡出。
+   未调整前第 i 条链表仍缓存用户区大小为 (i+1)*memBYTE_ALIGNMENT 的内存块 */
+#ifndef MEM_QUICK_ADAPT_EN
+#define MEM_QUICK_ADAPT_EN		0	// 快速链表自适应使能，需要 MEM_QUICK_FIT_EN
+#endif
+#ifndef MEM_QUICK_ADAPT_MAX
+#define MEM_QUICK_ADAPT_MAX		512	// 直方图统计的最大用户区字节数，每 memBYTE_ALIGNMENT 字节一格
+#endif
+
+/* 空闲块索引: 空闲块另按 (大小, 地址) 组织成红黑树，申请时用 O(log n) 找到最佳适配(最小的足够大的空闲块)，
+   取代 TATTER_OPTIME_EN 的线性查找；地址链表保持不变，释放时仍按地址合并。
+   树节点保存在空闲块的用户区中，最小内存块相应增大(32 位平台 24 字节)。
+   不能与 MEM_PERSIST_EN、MEM_OOB_META_EN、MEM_ZERO_EN 同时使用 */
+#ifndef MEM_TREE_INDEX_EN
+#define MEM_TREE_INDEX_EN		0	// 红黑树空闲块索引使能
+#endif
+
+/* 精确查找表: 常用的申请尺寸按大小直接映射到 MEM_EXACT_SLOT_NUM 个槽，每个槽把该大小的空闲块串成链表，
+   释放与合并时维护；申请时先查表，命中时直接取出，不查找也不分隔。跟踪的尺寸用 memExactFitSetSize 指定，
+   或由 memExactFitLearn 按各槽统计的常见尺寸自动调整。映射到同一个槽的尺寸只能跟踪一个。
+   不能与 MEM_PERSIST_EN、MEM_OOB_META_EN、MEM_ZERO_EN、MEM_TREE_INDEX_EN 同时使用 */
+#ifndef MEM_EXACT_FIT_EN
+#define MEM_EXACT_FIT_EN		0	// 精确查找表使能
+#endif
+#ifndef MEM_EXACT_SLOT_NUM
+#define MEM_EXACT_SLOT_NUM		16	// 槽个数
+#endif
+#ifndef MEM_EXACT_LEARN_VOTES
+#define MEM_EXACT_LEARN_VOTES	64	// memExactFitLearn 采用候选尺寸所需的最少票数
+#endif
+/* 第一次初始化堆时跟踪的尺寸(申请字节数)，例如 { 24, 64, 200 }，默认不定义 */
+// #define MEM_EXACT_SIZES		{ 24, 64, 200 }
+
+/* 带外元数据: 空闲块的偏移、大小和链表指针保存在连续的节点数组中(可放在片内高速 RAM)，申请时的查找和释放时的合并
+   只访问该数组，不再逐个读取分散在堆中的块头，用户越界写也不会破坏空闲链表。
+   同时存活的内存块(含快速链表缓存)最多 MEM_OOB_NODE_NUM - 堆区域个数 个，超出时申请失败。
+   不能与 MEM_PERSIST_EN、MEM_CHECK_EN、MEM_ZERO_EN 同时使用 */
+#ifndef MEM_OOB_META_EN
+#define MEM_OOB_META_EN			0	// 带外元数据使能
+#endif
+#ifndef MEM_OOB_NODE_NUM
+#define MEM_OOB_NODE_NUM		256	// 节点个数(2~65535)，每个节点 12 字节
+#endif
+#ifndef MEM_OOB_SECTION				// 节点数组所在的段，例如 __attribute__( ( section( ".dtcm" ) ) )
+#define MEM_OOB_SECTION
+#endif
+
+/* 主机(Linux)运行模式: 堆区域由 mmap 申请，合并后超过阈值的空闲内存页通过 madvise 归还给操作系统，
+   再次使用时由缺页异常重新分配，仅用于 Linux 仿真器和工具 */
+#ifndef MEM_HOSTED_MMAP_EN
+#define MEM_HOSTED_MMAP_EN		0	// 主机 mmap 模式使能
+#endif
+#ifndef MEM_HOSTED_RELEASE_THRESHOLD
+#define MEM_HOSTED_RELEASE_THRESHOLD	( 64 * 1024 )	// 一次释放可归还的连续页面达到该字节数才调用 madvise
+#endif
+#ifndef MEM_HOSTED_MADVISE
+#define MEM_HOSTED_MADVISE		MADV_DONTNEED	// 可改为 MADV_FREE，归还更延迟但再次使用时内容不保证为 0
+#endif
+
+/* 持久化堆(仅 Linux 主机): 堆区域为映射到内存的文件，空闲链表保存为区域内偏移，
+   调用 memPersistSync 后重启进程，memManageFunctionInit 直接接管文件中已有的堆 */
+#ifndef MEM_PERSIST_EN
+#define MEM_PERSIST_EN			0	// 持久化堆使能，只支持一个堆区域
+#endif
+
+/* 失败快照: 内存申请失败时，在调用 malloc_fail_cb 之前把堆状态快照写入复位后不清零的 RAM 段，
+   重启后用 memPostMortemGet 读出，或导出为二进制文件后用 tools/mem_postmortem_decode 解析 */
+#ifndef MEM_POSTMORTEM_EN
+#define MEM_POSTMORTEM_EN		0	// 失败快照使能
+#endif
+#ifndef MEM_POSTMORTEM_BLOCK_NUM
+#define MEM_POSTMORTEM_BLOCK_NUM	32	// 快照中按地址顺序记录的空闲块个数
+#endif
+#ifndef MEM_POSTMORTEM_WALK_MAX
+#define MEM_POSTMORTEM_WALK_MAX		1024	// 生成快照时最多遍历的空闲块个数，保证耗时有上限
+#endif
+#ifndef MEM_POSTMORTEM_TAG_NUM
+#define MEM_POSTMORTEM_TAG_NUM		8	// 快照中记录的标签个数，打开 MEM_TAG_EN 时记录存活字节数最多的 MEM_POSTMORTEM_TAG_NUM 个标签
+#endif
+#ifndef MEM_POSTMORTEM_SECTION		// 须在链接脚本(分散加载文件)中把该段设为 NOINIT/UNINIT
+#define MEM_POSTMORTEM_SECTION		__attribute__( ( section( ".noinit" ) ) )
+#endif
+
+/* 应急储备: 初始化时从堆中预留一块内存(memHeapWalk 中状态为 MEM_BLOCK_RESERVED)，普通申请不能使用；
+   memMallocCritical 以及 malloc_fail_cb 执行期间的申请在堆中找不到可用内存时从储备中切出，
+   供失败处理代码记录日志、保存状态、发送最后的消息。储备用掉后，释放内存时若剩余空闲内存
+   不少于储备的两倍，就重新预留一整块，原储备剩余的部分归还堆。不能与 MEM_PERSIST_EN 同时使用 */
+#ifndef MEM_RESERVE_EN
+#define MEM_RESERVE_EN			0	// 应急储备使能
+#endif
+#ifndef MEM_RESERVE_SIZE
+#define MEM_RESERVE_SIZE		1024	// 储备的字节数(含块头)，至少 64
+#endif
+
+/* 阻塞申请(仅 FreeRTOS): memMallocWait 申请失败时当前任务按优先级进入等待链表并阻塞，释放内存后刚释放的内存
+   所在的空闲块放得下时，按优先级从高到低唤醒等待的任务重新申请。用任务通知阻塞和唤醒，
+   需要 configUSE_TASK_NOTIFICATIONS 和 INCLUDE_uxTaskPriorityGet */
+#ifndef MEM_WAIT_EN
+#define MEM_WAIT_EN				0	// 阻塞申请使能
+#endif
+#ifndef MEM_WAIT_NOTIFY_INDEX
+#define MEM_WAIT_NOTIFY_INDEX	0	// 使用的任务通知序号，应用不能再使用该序号；大于 0 时需要 FreeRTOS 10.4 及以上
+#endif
+
+/* 耗时统计: 记录每次 memMalloc/memFree 在临界区内的周期数和访问的空闲链表节点数，按 log2 分格统计；
+   Cortex-M3/M4/M7/M33 使用 DWT 周期计数器，x86 主机使用 rdtsc，其他 Linux 主机使用 clock_gettime(纳秒)，
+   其他平台需定义 MEM_CYCLE_COUNTER() 返回 uint32_t 计数值 */
+#ifndef MEM_LATENCY_STAT_EN
+#define MEM_LATENCY_STAT_EN		0	// 耗时统计使能
+#endif
+#ifndef MEM_LATENCY_BUCKET_NUM
+#define MEM_LATENCY_BUCKET_NUM	24	// 直方图格数
+#endif
+
+/* 内部碎片统计: 累计每次成功申请的申请字节数、块头、对齐填充和整块分配时未分隔的余量，按申请大小分类，
+   用于评估紧凑块头、尺寸分级或内存池是否值得使用 */
+#ifndef MEM_WASTE_STAT_EN
+#define MEM_WASTE_STAT_EN		0	// 内部碎片统计使能
+#endif
+#ifndef MEM_WASTE_CLASS_NUM
+#define MEM_WASTE_CLASS_NUM		16	// 分类个数，第 i 类统计申请字节数在 [2^i, 2^(i+1)) 的申请
+#endif
+
+/* 调用跟踪: 把每次 memMalloc/memFree/pvPortReAlloc/pvPortCalloc 调用编码为变长记录(格式见 MEM_TRACE_VERSION 说明)
+   写入环形缓冲区，由 memTraceDrain 输出到 RTT 通道、文件或内存，用于在主机上回放分析 */
+#ifndef MEM_TRACE_EN
+#define MEM_TRACE_EN			0	// 调用跟踪使能
+#endif
+#ifndef MEM_TRACE_BUF_SIZE
+#define MEM_TRACE_BUF_SIZE		1024	// 环形缓冲区字节数，须为 2 的幂
+#endif
+#ifndef MEM_TRACE_CALLER_EN
+#define MEM_TRACE_CALLER_EN		0	// 记录调用者返回地址，每条记录增加约 5 字节
+#endif
+/* 采样分析: 平均每申请 MEM_PROFILE_SAMPLE_BYTES 字节抽取一个内存块，记录调用者返回地址(或 memMallocSite 给出的标识)
+   与申请字节数，被抽中的内存块释放时移除；memProfileDump 输出仍存活的样本，由主机工具 mem_profile_convert
+   转换为 pprof 或火焰图格式。开销只有每次调用一次减法和释放时一次哈希查找，可在产品中常开 */
+#ifndef MEM_PROFILE_EN
+#define MEM_PROFILE_EN			0	// 采样分析使能
+#endif
+#ifndef MEM_PROFILE_SAMPLE_BYTES
+#define MEM_PROFILE_SAMPLE_BYTES	4096	// 平均采样间隔(字节)
+#endif
+#ifndef MEM_PROFILE_SAMPLE_NUM
+#define MEM_PROFILE_SAMPLE_NUM	64	// 样本表大小，须为 2 的幂，最多同时存活 MEM_PROFILE_SAMPLE_NUM - 1 个样本，超出时丢弃并计数
+#endif
+/* 分配标签: memMallocTagged 给内存块打上模块标签，按标签统计存活字节数、块数和峰值，查询为 O(1)；
+   标签保存在块头 xBlockSize 中已分配标记之下的 MEM_TAG_BITS 位，不增加块头大小，
+   代价是单个内存块不能超过 2^(size_t 位数 - 1 - MEM_TAG_BITS) 字节。memMalloc 等接口使用 MEM_TAG_DEFAULT */
+#ifndef MEM_TAG_EN
+#define MEM_TAG_EN				0	// 分配标签使能
+#endif
+#ifndef MEM_TAG_BITS
+#define MEM_TAG_BITS			3	// 标签位数(1~7)，可用标签为 0 ~ 2^MEM_TAG_BITS - 1
+#endif
+#ifndef MEM_TASK_TAG_NUM
+#define MEM_TASK_TAG_NUM		4	// FreeRTOS 下可用 memTaskBindTag 绑定标签的任务个数，0 表示不使用
+#endif
+/* 快照: 每个内存块头增加一个分配序号(块头可能因此变大)，memSnapshotTake 把存活内存块记录到调用者提供的缓冲区，
+   memSnapshotDiff 找出两次快照之间申请且仍存活的内存块，用于在设备上定位缓慢的内存泄漏 */
+#ifndef MEM_SNAPSHOT_EN
+#define MEM_SNAPSHOT_EN			0	// 快照使能
+#endif
+/* 配额: 按标签限制存活字节数(含块头)，在查找空闲内存之前检查，超出时申请失败并调用 quota_exceeded_cb，
+   不调用 malloc_fail_cb；任务用 memTaskBindTag 绑定独占的标签后，该标签的配额即为任务的配额。需要 MEM_TAG_EN */
+#ifndef MEM_QUOTA_EN
+#define MEM_QUOTA_EN			0	// 配额使能
+#endif
+
+/* 年龄统计: 每个内存块头增加申请时的时间戳(块头可能因此变大)，memAgeGetHistogram 按存活时长分格统计存活字节数，
+   可按标签过滤，用于找出长期占用堆、造成碎片的对象。时间单位由 MEM_GET_TIMESTAMP() 决定 */
+#ifndef MEM_AGE_EN
+#define MEM_AGE_EN				0	// 年龄统计使能
+#endif
+#ifndef MEM_AGE_BUCKET_NUM
+#define MEM_AGE_BUCKET_NUM		24	// 直方图格数，第 i 格统计存活 [2^i, 2^(i+1)) 个时间单位的内存块
+#endif
+
+/* 增量完整性检查: memCheckStep 每次按地址检查有限个内存块，从上次停下的位置继续，检查块大小是否越过区域边界、
+   空闲链表是否按地址递增且与实际的空闲块一致、相邻空闲块是否已合并，每轮结束时核对 xFreeBlockNum 和 xFreeBytesRemaining，
+   发现问题时调用 heap_check_cb。每次耗时有上限，可放在 FreeRTOS 空闲钩子中持续运行 */
+#ifndef MEM_CHECK_EN
+#define MEM_CHECK_EN			0	// 增量完整性检查使能
+#endif
+
+/* 空闲时预清零: memZeroStep 在预算内把空闲块清零并在空闲块中记下清零标记，pvPortCalloc 优先使用已清零的内存块，
+   省去 memset；分隔出的剩余部分保持已清零，与刚释放的内存块合并后不再算已清零。可放在 FreeRTOS 空闲钩子中运行。
+   主机 mmap 模式下新映射的区域直接算已清零，较大的空闲块用 madvise(MADV_DONTNEED) 归还整页代替 memset */
+#ifndef MEM_ZERO_EN
+#define MEM_ZERO_EN				0	// 空闲时预清零使能
+#endif
+
+/* 时间戳来源(调用跟踪和年龄统计使用)，返回 uint32_t，未定义时 FreeRTOS 下使用系统节拍，
+   Linux 主机使用单调时钟(微秒)，其他平台为 0，裸机可使用 SysTick 中断计数:
+#define MEM_GET_TIMESTAMP()		( ( uint32_t ) SysTickCount ) */
+
+#ifndef MEM_HEAP_REGION_MAX
+#define MEM_HEAP_REGION_MAX		4	// 最多支持的堆区域个数
+#endif
+
+#define MEM_TAG_NUM				( 1 << MEM_TAG_BITS )
+#define MEM_TAG_DEFAULT			0	// memMalloc/pvPortCalloc 等不带标签的接口使用的标签
 
 /* 操作系统选择 */
-#define OPERATE_SYSTEM      SYSTEM_NO
 #define SYSTEM_NO           0
 #define SYSTEM_FREERTOS     1
+#ifndef OPERATE_SYSTEM
+#define OPERATE_SYSTEM      SYSTEM_NO
+#endif
+
+#define MEM_WAIT_FOREVER		0xFFFFFFFFUL	// memMallocWait 一直等待(需要 INCLUDE_vTaskSuspend)
 
 /* 内存堆定义 */
 typedef struct MemHeapRegion
@@ -62,10 +296,213 @@ typedef struct MemHeapRegion
 } MemHeapRegion_t;
 
 typedef void (*MALLOC_FAIL_CB)(size_t xWantedSize);
+typedef void (*QUOTA_EXCEEDED_CB)(size_t xWantedSize, uint8_t ucTag);
+
+/* memCheckStep 发现的问题 */
+typedef enum
+{
+	MEM_CHECK_OK = 0,
+	MEM_CHECK_BAD_SIZE,			// 块大小为 0、未对齐或越过区域结束标记，块头已损坏，跳过该区域的剩余部分
+	MEM_CHECK_BAD_LINK,			// 空闲链表指针越界、未按地址递增，或与按地址遍历遇到的空闲块不一致
+	MEM_CHECK_NOT_MERGED,		// 相邻的两个空闲块未合并
+	MEM_CHECK_BAD_FREE_NUM,		// 空闲块个数与 xFreeBlockNum 不一致
+	MEM_CHECK_BAD_FREE_BYTES	// 空闲块与快速链表缓存块的字节数之和与 xFreeBytesRemaining 不一致
+} MemCheckError_t;
+
+/* pvBlock 为出问题的块头，xValue 为其相对第一个堆区域起始地址的偏移；
+   计数不一致时 pvBlock 为空指针，xValue 为本轮实际统计的个数或字节数 */
+typedef void (*HEAP_CHECK_CB)(MemCheckError_t eError, const void *pvBlock, size_t xValue);
+
+/* 堆中内存块的状态 */
+typedef enum
+{
+	MEM_BLOCK_FREE = 0,		// 在空闲链表中
+	MEM_BLOCK_USED = 1,		// 已分配给应用
+	MEM_BLOCK_CACHED = 2,	// 已释放，缓存在快速链表中
+	MEM_BLOCK_RESERVED = 3	// 应急储备，不属于任何申请
+} MemBlockState_t;
+
+typedef struct MemHeapBlockInfo
+{
+	void *pvBlock;			// 内存块起始地址(块头)，用户区在其后
+	size_t xOffset;			// 相对第一个堆区域起始地址的偏移
+	size_t xSize;			// 内存块大小，含块头
+	MemBlockState_t eState;
+} MemHeapBlockInfo_t;
+
+/* 一类调用的耗时直方图:
+   ulCycleHist[i] 统计耗时在 [2^i, 2^(i+1)) 个周期的次数，
+   ulNodeHist[0] 统计未访问空闲链表节点的次数，ulNodeHist[i] 统计访问 [2^(i-1), 2^i) 个节点的次数 */
+typedef struct MemLatencyHist
+{
+	uint32_t ulCount;
+	uint32_t ulMaxCycles;
+	uint32_t ulMaxNodes;
+	uint64_t ullTotalCycles;
+	uint64_t ullTotalNodes;
+	uint32_t ulCycleHist[ MEM_LATENCY_BUCKET_NUM ];
+	uint32_t ulNodeHist[ MEM_LATENCY_BUCKET_NUM + 1 ];
+} MemLatencyHist_t;
+
+typedef struct MemLatencyStat
+{
+	MemLatencyHist_t xMallocHit;	// 申请成功
+	MemLatencyHist_t xMallocMiss;	// 申请失败
+	MemLatencyHist_t xFree;
+} MemLatencyStat_t;
+
+/* 一个标签的用量，字节数按内存块大小(含块头)统计，与 memGetFreeHeapSize 之和为堆总大小 */
+typedef struct MemTagStat
+{
+	size_t xLiveBytes;		// 当前存活字节数
+	size_t xLiveCount;		// 当前存活内存块个数
+	size_t xPeakBytes;		// 存活字节数峰值
+} MemTagStat_t;
+
+/* 快照中的一个存活内存块 */
+typedef struct MemSnapshotEntry
+{
+	void *pvBlock;			// 用户区地址，与 memMalloc 返回值相同
+	size_t xSize;			// 用户区大小(按对齐向上取整，可能略大于申请字节数)
+	uint32_t ulSeq;			// 分配序号
+	uint8_t ucTag;			// 标签，未打开 MEM_TAG_EN 时为 MEM_TAG_DEFAULT
+} MemSnapshotEntry_t;
+
+/* 一次快照，按地址顺序保存在 pxEntries 中 */
+typedef struct MemSnapshot
+{
+	MemSnapshotEntry_t *pxEntries;
+	size_t xCapacity;
+	size_t xNum;			// 存活内存块总数，大于 xCapacity 时只记录了前 xCapacity 个
+	uint32_t ulSeq;			// 快照时的下一个分配序号
+} MemSnapshot_t;
+
+#define MEM_AGE_ALL_TAGS		0xFF	// memAgeGetHistogram 统计所有标签
+
+/* 存活内存块按年龄的分布，字节数按内存块大小(含块头)统计 */
+typedef struct MemAgeHist
+{
+	uint32_t ulNow;								// 统计时的时间戳
+	uint32_t ulOldestAge;						// 最老内存块的年龄
+	size_t xBytes[ MEM_AGE_BUCKET_NUM ];
+	size_t xCount[ MEM_AGE_BUCKET_NUM ];
+} MemAgeHist_t;
+
+/* 一类申请的内部碎片，ullGrantedBytes = ullRequestedBytes + ullHeaderBytes + ullAlignBytes + ullSlackBytes */
+typedef struct MemWasteClass
+{
+	uint32_t ulCount;				// 申请成功次数
+	uint64_t ullRequestedBytes;		// 申请字节数
+	uint64_t ullHeaderBytes;		// 块头字节数
+	uint64_t ullAlignBytes;			// 按 memBYTE_ALIGNMENT 向上取整的填充字节数
+	uint64_t ullSlackBytes;			// 剩余部分不足 heapMINIMUM_BLOCK_SIZE 未分隔、随内存块一起分配的字节数
+	uint64_t ullGrantedBytes;		// 实际分配的内存块字节数
+} MemWasteClass_t;
+
+typedef struct MemWasteStat
+{
+	MemWasteClass_t xTotal;
+	MemWasteClass_t xClass[ MEM_WASTE_CLASS_NUM ];
+} MemWasteStat_t;
+
+/* 精确查找表的一个槽，尺寸为用户区字节数(按对齐向上取整) */
+typedef struct MemExactSlotInfo
+{
+	size_t xSize;			// 跟踪的尺寸，0 表示空槽
+	size_t xFreeNum;		// 当前该尺寸的空闲块个数
+	uint32_t ulHits;		// 开始跟踪该尺寸以来直接命中的次数
+	size_t xCandidate;		// 映射到本槽的申请中出现最多的尺寸
+	uint32_t ulVotes;		// 候选尺寸的票数
+} MemExactSlotInfo_t;
+
+/* 遍历回调，返回非 0 时停止遍历 */
+typedef int (*MEM_HEAP_WALK_CB)(const MemHeapBlockInfo_t *pxInfo, void *pvArg);
+
+/* 数据输出接口，如写入 RTT 通道、文件或内存 */
+typedef void (*MEM_OUTPUT_SINK)(const uint8_t *pucData, size_t xLen, void *pvArg);
+
+/* memHeapDumpBinary 输出格式:
+   文件头 4 字节: 'M' 'H' 版本 对齐字节数(A)
+   每个内存块一条记录，由两个 LEB128 变长整数组成:
+     1. 与上一块结束位置的间隔 / A，同一区域内连续的内存块为 0
+     2. ((大小 / A) << 2) | MemBlockState_t
+   最后以两个 0 结束 */
+#define MEM_HEAP_DUMP_VERSION		1
+
+/* 调用跟踪数据格式:
+   流头 4 字节: 'M' 'T' 版本 对齐字节数(A)
+   每条记录: 1 字节操作类型(低 3 位 MEM_TRACE_OP_xxx，bit3 表示带调用者)，LEB128 变长整数的时间戳增量，
+             各操作的参数(均为变长整数)，带调用者时最后是调用者地址
+     MALLOC/CALLOC: 申请字节数，返回偏移
+     FREE:          偏移
+     REALLOC:       原偏移，申请字节数，返回偏移
+     DROPPED:       缓冲区满被丢弃的记录数(无时间戳)
+   偏移 = (用户区地址 - 第一个堆区域起始地址) / A + 1，0 表示空指针 */
+#define MEM_TRACE_VERSION			1
+#define MEM_TRACE_OP_NONE			0xFF
+#define MEM_TRACE_OP_MALLOC			0
+#define MEM_TRACE_OP_FREE			1
+#define MEM_TRACE_OP_REALLOC		2
+#define MEM_TRACE_OP_CALLOC			3
+#define MEM_TRACE_OP_DROPPED		7
+#define MEM_TRACE_OP_MASK			0x07
+#define MEM_TRACE_FLAG_CALLER		0x08
+
+/* memProfileDump 输出格式:
+   文件头 4 字节: 'M' 'P' 版本 对齐字节数
+   之后均为 LEB128 变长整数: 平均采样间隔(字节)，丢弃的样本数，样本数 N，
+   N 个样本，每个为 调用者标识，申请字节数
+   样本代表的字节数估计为 size / (1 - exp(-size / 采样间隔)) */
+#define MEM_PROFILE_VERSION			1
+
+#define MEM_POSTMORTEM_MAGIC		( ( uint32_t ) 0x4D454D50UL )
+#define MEM_POSTMORTEM_VERSION		3
+#define MEM_POSTMORTEM_HIST_NUM		16		// 空闲块尺寸直方图，第 i 格统计 [16<<i, 32<<i) 字节的空闲块
+#define MEM_POSTMORTEM_FLAG_TRUNCATED	( 1UL << 0 )	// 空闲链表过长，遍历被截断
+
+/* 失败快照，全部为定长字段，主机工具可直接解析目标板导出的数据(小端) */
+typedef struct MemPostMortemBlock
+{
+	uint32_t ulOffset;		// 相对第一个堆区域起始地址的偏移
+	uint32_t ulSize;
+} MemPostMortemBlock_t;
+
+typedef struct MemPostMortemTag
+{
+	uint8_t ucTag;
+	uint8_t ucPad[ 3 ];
+	uint32_t ulLiveBytes;
+	uint32_t ulLiveCount;
+	uint32_t ulPeakBytes;
+} MemPostMortemTag_t;
+
+typedef struct MemPostMortem
+{
+	uint32_t ulMagic;
+	uint16_t usVersion;
+	uint16_t usBlockCapacity;					// xBlocks 数组长度，即 MEM_POSTMORTEM_BLOCK_NUM
+	uint32_t ulFailCount;						// 快照清除以来申请失败的次数
+	uint32_t ulWantedSize;						// 最近一次失败的申请大小(含块头和对齐)
+	uint32_t ulFreeBytesRemaining;
+	uint32_t ulMinimumEverFreeBytesRemaining;
+	uint32_t ulFreeBlockNum;
+	uint32_t ulLargestFreeBlock;
+	uint32_t ulWalkedBlockNum;					// 实际遍历的空闲块个数
+	uint32_t ulFlags;
+	uint32_t ulSizeHistogram[ MEM_POSTMORTEM_HIST_NUM ];
+	uint32_t ulBlockNum;						// xBlocks 中的有效个数
+	MemPostMortemBlock_t xBlocks[ MEM_POSTMORTEM_BLOCK_NUM ];
+	uint16_t usTagCapacity;						// xTags 数组长度，即 MEM_POSTMORTEM_TAG_NUM
+	uint16_t usTagNum;							// xTags 中的有效个数，未打开 MEM_TAG_EN 时为 0
+	MemPostMortemTag_t xTags[ MEM_POSTMORTEM_TAG_NUM ];	// 按存活字节数从多到少排列的标签用量
+	uint32_t ulChecksum;						// 之前所有字的校验和，用于判断快照是否有效
+} MemPostMortem_t;
 
 typedef struct mem_manage_s
 {
-	MALLOC_FAIL_CB malloc_fail_cb;  // 内存申请失败时的回调，一般做重启系统处理
+	MALLOC_FAIL_CB malloc_fail_cb;  // 内存申请失败时的回调，一般做重启系统处理；打开 MEM_RESERVE_EN 时回调中的申请可以使用应急储备
+	QUOTA_EXCEEDED_CB quota_exceeded_cb;  // 申请超出标签配额时的回调(MEM_QUOTA_EN)，堆本身仍有空闲内存
+	HEAP_CHECK_CB heap_check_cb;  // memCheckStep 发现堆损坏时的回调(MEM_CHECK_EN)，在临界区外调用
 } mem_manage_t;
 
 /************************************
@@ -82,6 +519,28 @@ int memManageFunctionInit(mem_manage_t *mem_manage, const MemHeapRegion_t * cons
  *************************************/
 void *memMalloc( size_t xWantedSize );
 
+/************************************
+ * @brief: 		与 memMalloc 相同，调用跟踪与采样分析中以 xSite 代替返回地址作为调用者标识，
+ *				用于封装函数中传入上层调用者或模块编号
+ *************************************/
+void *memMallocSite( size_t xWantedSize, size_t xSite );
+
+/************************************
+ * @brief: 		与 memMalloc 相同，内存块记入标签 ucTag 的用量，pvPortReAlloc 得到的新内存块沿用原标签
+ * @param[in] 	xWantedSize, 申请的内存块大小,单位字节
+ * @param[in] 	ucTag, 标签，须小于 MEM_TAG_NUM；未打开 MEM_TAG_EN 时忽略
+ * @return 		申请成功时，返回内存块的起始地址，失败或标签无效时返回空指针
+ *************************************/
+void *memMallocTagged( size_t xWantedSize, uint8_t ucTag );
+
+/************************************
+ * @brief: 		与 memMalloc 相同，堆中找不到可用内存时从应急储备中切出(MEM_RESERVE_EN)，用于失败处理等关键路径；
+ *				未打开 MEM_RESERVE_EN 时与 memMalloc 完全相同
+ * @param[in] 	xWantedSize, 申请的内存块大小,单位字节
+ * @return 		申请成功时，返回内存块的起始地址，堆和储备都不够时返回空指针
+ *************************************/
+void *memMallocCritical( size_t xWantedSize );
+
 /************************************
  * @brief: 		申请释放一块内存
  * @param[in] 	之前申请的内存块地址
@@ -110,6 +569,388 @@ size_t memGetFreeBlockNum( void );
  *************************************/
 void memPrintfFreeListLayout(void);
 
+#if defined(MEM_HOSTED_MMAP_EN) && (MEM_HOSTED_MMAP_EN > 0)
+/************************************
+ * @brief: 		主机模式下用 mmap 申请一块堆区域，用于填写 MemHeapRegion_t
+ * @param[in] 	xSizeInBytes, 区域大小，向上取整到页面大小
+ * @return 		区域起始地址，失败返回空指针
+ * @attention: 	多个区域须按起始地址升序填入 MemHeapRegion_t 数组
+ *************************************/
+uint8_t *memHostedRegionMap( size_t xSizeInBytes );
+
+/************************************
+ * @brief: 		释放 memHostedRegionMap 申请的区域，须在不再使用内存管理后调用
+ * @param[in] 	pucStartAddress, xSizeInBytes 与申请时一致
+ * @return 		void
+ *************************************/
+void memHostedRegionUnmap( uint8_t *pucStartAddress, size_t xSizeInBytes );
+
+/************************************
+ * @brief: 获取累计通过 madvise 归还给操作系统的字节数
+ * @param[in] void
+ * @return 单位字节
+ *************************************/
+size_t memHostedGetReleasedBytes( void );
+#endif
+
+/************************************
+ * @brief: 		按地址顺序遍历所有内存块(已分配、空闲和快速链表中缓存的)，遍历期间挂起调度
+ * @param[in] 	pxCallback, 每个内存块调用一次，返回非 0 时停止遍历
+ * @param[in] 	pvArg, 传给回调的参数
+ * @return 		遍历的内存块个数
+ *************************************/
+size_t memHeapWalk( MEM_HEAP_WALK_CB pxCallback, void *pvArg );
+
+/************************************
+ * @brief: 		以紧凑的二进制格式(见 MEM_HEAP_DUMP_VERSION 说明)输出完整堆布局，分批写入 pxSink
+ * @param[in] 	pxSink, 输出接口，可用 tools/mem_heapmap_decode 解析输出的数据
+ * @param[in] 	pvArg, 传给输出接口的参数
+ * @return 		输出的内存块个数
+ *************************************/
+size_t memHeapDumpBinary( MEM_OUTPUT_SINK pxSink, void *pvArg );
+
+/************************************
+ * @brief: 		重新分配内存，内容复制到新内存块；pv 为空时等同 memMalloc，xWantedSize 为 0 时等同 memFree
+ * @param[in] 	pv, 之前申请的内存块地址
+ * @param[in] 	xWantedSize, 新的大小，单位字节
+ * @return 		新内存块地址，失败返回空指针，原内存块保持不变
+ *************************************/
+void *pvPortReAlloc( void *pv, size_t xWantedSize );
+
+/************************************
+ * @brief: 		申请 xWantedCnt 个 xWantedSize 字节的对象并清零
+ * @return 		申请成功时，返回内存块的起始地址，失败或 xWantedCnt * xWantedSize 溢出时返回空指针
+ *************************************/
+void *pvPortCalloc( size_t xWantedCnt, size_t xWantedSize );
+
+#if defined(MEM_TRACE_EN) && (MEM_TRACE_EN > 0)
+/************************************
+ * @brief: 		清空跟踪缓冲区并重新写入流头，memManageFunctionInit 中会调用一次
+ * @param[in] 	void
+ * @return 		void
+ *************************************/
+void memTraceReset( void );
+
+/************************************
+ * @brief: 		把缓冲区中的跟踪数据输出到 pxSink，可在低优先级任务或主循环中周期调用
+ * @param[in] 	pxSink, 输出接口
+ * @param[in] 	pvArg, 传给输出接口的参数
+ * @return 		输出的字节数
+ *************************************/
+size_t memTraceDrain( MEM_OUTPUT_SINK pxSink, void *pvArg );
+
+/************************************
+ * @brief: 		获取因缓冲区满被丢弃的记录总数
+ * @param[in] 	void
+ * @return 		记录数
+ *************************************/
+uint32_t memTraceGetDropped( void );
+#endif
+
+#if defined(MEM_PROFILE_EN) && (MEM_PROFILE_EN > 0)
+/************************************
+ * @brief: 		清空存活样本并重新开始计数，memManageFunctionInit 中会调用一次
+ * @param[in] 	void
+ * @return 		void
+ *************************************/
+void memProfileReset( void );
+
+/************************************
+ * @brief: 		以紧凑的二进制格式(见 MEM_PROFILE_VERSION 说明)输出当前存活的样本，分批写入 pxSink
+ * @param[in] 	pxSink, 输出接口，在挂起调度期间被调用
+ * @param[in] 	pvArg, 传给输出接口的参数
+ * @return 		样本数
+ *************************************/
+size_t memProfileDump( MEM_OUTPUT_SINK pxSink, void *pvArg );
+
+/************************************
+ * @brief: 		获取因样本表满被丢弃的样本数
+ * @param[in] 	void
+ * @return 		样本数
+ *************************************/
+uint32_t memProfileGetDropped( void );
+#endif
+
+#if defined(MEM_SNAPSHOT_EN) && (MEM_SNAPSHOT_EN > 0)
+/************************************
+ * @brief: 		记录当前所有存活内存块，遍历期间挂起调度，不申请内存
+ * @param[out] 	pxSnapshot, 快照
+ * @param[in] 	pxEntries, 调用者提供的缓冲区，可为空指针(只记录序号，用作 memSnapshotDiff 的旧快照)
+ * @param[in] 	xCapacity, 缓冲区可容纳的内存块个数
+ * @return 		存活内存块个数，大于 xCapacity 时缓冲区不足
+ *************************************/
+size_t memSnapshotTake( MemSnapshot_t *pxSnapshot, MemSnapshotEntry_t *pxEntries, size_t xCapacity );
+
+/************************************
+ * @brief: 		找出 pxOld 之后申请、在 pxNew 时仍存活的内存块，按地址顺序写入 pxOut；
+ *				只用到 pxOld 的分配序号，不访问堆，可在任意时刻调用
+ * @param[in] 	pxOld, 较早的快照
+ * @param[in] 	pxNew, 较晚的快照
+ * @param[out] 	pxOut, 结果缓冲区，可为空指针(只计数)
+ * @param[in] 	xOutCapacity, 结果缓冲区可容纳的内存块个数
+ * @return 		符合条件的内存块个数
+ *************************************/
+size_t memSnapshotDiff( const MemSnapshot_t *pxOld, const MemSnapshot_t *pxNew, MemSnapshotEntry_t *pxOut, size_t xOutCapacity );
+#endif
+
+#if defined(MEM_AGE_EN) && (MEM_AGE_EN > 0)
+/************************************
+ * @brief: 		按存活时长统计当前已分配的内存块，遍历期间挂起调度
+ * @param[out] 	pxHist, 统计结果
+ * @param[in] 	ucTag, 只统计该标签的内存块，MEM_AGE_ALL_TAGS 表示全部；未打开 MEM_TAG_EN 时忽略
+ * @return 		统计的内存块个数
+ *************************************/
+size_t memAgeGetHistogram( MemAgeHist_t *pxHist, uint8_t ucTag );
+#endif
+
+#if defined(MEM_CHECK_EN) && (MEM_CHECK_EN > 0)
+/************************************
+ * @brief: 		增量检查堆的完整性，从上次停下的位置继续按地址检查，每次最多报告一个问题。
+ *				可在 FreeRTOS 空闲钩子中调用(需 configUSE_IDLE_HOOK 为 1):
+ *				void vApplicationIdleHook( void ) { ( void ) memCheckStep( 16 ); }
+ * @param[in] 	xMaxBlocks, 本次最多检查的内存块个数，决定临界区的最长时间
+ * @return 		MEM_CHECK_OK 或本次发现的问题，发现问题时已调用 heap_check_cb
+ *************************************/
+MemCheckError_t memCheckStep( size_t xMaxBlocks );
+
+/************************************
+ * @brief: 		获取已完成的检查轮数，每轮覆盖整个堆
+ * @param[in] 	void
+ * @return 		轮数
+ *************************************/
+uint32_t memCheckGetPassCount( void );
+#endif
+
+#if defined(MEM_ZERO_EN) && (MEM_ZERO_EN > 0)
+/************************************
+ * @brief: 		在预算内把未清零的空闲块清零，从上次停下的位置继续，大的空闲块可分多次完成。
+ *				可在 FreeRTOS 空闲钩子中调用: void vApplicationIdleHook( void ) { ( void ) memZeroStep( 1024 ); }
+ * @param[in] 	xMaxBytes, 本次最多清零的字节数，跳过一个已清零的空闲块按一个块头的字节数计
+ * @return 		本次清零的字节数，为 0 时本次没有遇到未清零的空闲块
+ *************************************/
+size_t memZeroStep( size_t xMaxBytes );
+#endif
+
+#if defined(OPERATE_SYSTEM) && (OPERATE_SYSTEM == SYSTEM_FREERTOS) && defined(MEM_WAIT_EN) && (MEM_WAIT_EN > 0)
+/************************************
+ * @brief: 		与 memMalloc 相同，堆中没有可用内存时阻塞当前任务，直到有内存释放后重新申请成功或超时；
+ *				失败时不调用 malloc_fail_cb，不能在中断或调度器挂起期间调用
+ * @param[in] 	xWantedSize, 申请的内存块大小,单位字节
+ * @param[in] 	ulTimeoutTicks, 最多等待的系统节拍数，0 表示不等待，MEM_WAIT_FOREVER 表示一直等待
+ * @return 		申请成功时，返回内存块的起始地址，超时返回空指针
+ *************************************/
+void *memMallocWait( size_t xWantedSize, uint32_t ulTimeoutTicks );
+#endif
+
+#if defined(MEM_RESERVE_EN) && (MEM_RESERVE_EN > 0)
+/************************************
+ * @brief: 		获取应急储备当前的块大小，小于 MEM_RESERVE_SIZE 说明储备被用过且尚未补足
+ * @param[in] 	void
+ * @return 		单位字节，0 表示储备已用完
+ *************************************/
+size_t memReserveGetSize( void );
+#endif
+
+#if defined(MEM_QUICK_FIT_EN) && (MEM_QUICK_FIT_EN > 0) && defined(MEM_QUICK_ADAPT_EN) && (MEM_QUICK_ADAPT_EN > 0)
+/************************************
+ * @brief: 		按直方图把快速链表重新分配给申请次数最多的尺寸，尺寸改变的链表先合并回空闲链表，然后直方图减半；
+ *				自上次调整后没有统计到申请时不做调整。宜在空闲时调用，例如每隔几秒调用一次
+ * @param[in] 	void
+ * @return 		新分配到快速链表的尺寸个数，0 表示分配不变
+ *************************************/
+size_t memQuickListRebalance( void );
+
+/************************************
+ * @brief: 		获取一条快速链表缓存的用户区大小
+ * @param[in] 	xIndex, 链表序号，0 ~ MEM_QUICK_LIST_NUM - 1
+ * @return 		用户区字节数，0 表示链表未使用或参数无效
+ *************************************/
+size_t memQuickListGetSize( size_t xIndex );
+#endif
+
+#if defined(MEM_EXACT_FIT_EN) && (MEM_EXACT_FIT_EN > 0)
+/************************************
+ * @brief: 		跟踪一个申请尺寸，替换映射到同一个槽的原尺寸，并从空闲链表中收集该大小的空闲块(遍历空闲链表)
+ * @param[in] 	xSize, 申请字节数
+ * @return 		0-成功，-1-尺寸为 0 或太小(空闲块放不下三个指针)
+ *************************************/
+int memExactFitSetSize( size_t xSize );
+
+/************************************
+ * @brief: 		清空精确查找表，不再跟踪任何尺寸，同时清除学习的候选尺寸
+ * @param[in] 	void
+ * @return 		void
+ *************************************/
+void memExactFitClear( void );
+
+/************************************
+ * @brief: 		各槽的候选尺寸票数达到 MEM_EXACT_LEARN_VOTES 且与跟踪的尺寸不同时改为跟踪候选尺寸，
+ *				每调整一个槽遍历一次空闲链表，宜在空闲时调用
+ * @param[in] 	void
+ * @return 		调整的槽个数
+ *************************************/
+size_t memExactFitLearn( void );
+
+/************************************
+ * @brief: 		获取精确查找表一个槽的状态
+ * @param[in] 	xSlot, 槽序号，0 ~ MEM_EXACT_SLOT_NUM - 1
+ * @param[out] 	pxInfo, 槽的状态
+ * @return 		0-成功，-1-参数无效
+ *************************************/
+int memExactFitGetSlot( size_t xSlot, MemExactSlotInfo_t *pxInfo );
+#endif
+
+#if defined(MEM_TAG_EN) && (MEM_TAG_EN > 0)
+/************************************
+ * @brief: 		获取一个标签的用量
+ * @param[in] 	ucTag, 标签
+ * @param[out] 	pxStat, 统计结果
+ * @return 		0-成功，-1-标签无效
+ *************************************/
+int memTagGetStat( uint8_t ucTag, MemTagStat_t *pxStat );
+
+/************************************
+ * @brief: 		把一个标签的峰值重置为当前存活字节数，用于按周期上报峰值
+ * @param[in] 	ucTag, 标签
+ * @return 		void
+ *************************************/
+void memTagResetPeak( uint8_t ucTag );
+
+#if defined(OPERATE_SYSTEM) && (OPERATE_SYSTEM == SYSTEM_FREERTOS) && (MEM_TASK_TAG_NUM > 0)
+/************************************
+ * @brief: 		绑定任务与标签，任务中不带标签的申请(memMalloc/pvPortCalloc 等)记入该标签；
+ *				任务删除前须用 MEM_TAG_DEFAULT 解除绑定，避免任务句柄被复用
+ * @param[in] 	pvTask, 任务句柄(TaskHandle_t)，NULL 表示当前任务
+ * @param[in] 	ucTag, 标签，MEM_TAG_DEFAULT 表示解除绑定
+ * @return 		0-成功，-1-标签无效或绑定表已满
+ *************************************/
+int memTaskBindTag( void *pvTask, uint8_t ucTag );
+#endif
+#endif
+
+#if defined(MEM_QUOTA_EN) && (MEM_QUOTA_EN > 0)
+/************************************
+ * @brief: 		设置标签的配额，设置为低于当前用量时之后的申请都会失败，直到用量降下来
+ * @param[in] 	ucTag, 标签
+ * @param[in] 	xQuotaBytes, 存活字节数上限(含块头)，0 表示不限制
+ * @return 		0-成功，-1-标签无效
+ *************************************/
+int memTagSetQuota( uint8_t ucTag, size_t xQuotaBytes );
+
+/************************************
+ * @brief: 		获取标签的配额
+ * @param[in] 	ucTag, 标签
+ * @return 		配额字节数，0 表示不限制
+ *************************************/
+size_t memTagGetQuota( uint8_t ucTag );
+#endif
+
+#if defined(MEM_LATENCY_STAT_EN) && (MEM_LATENCY_STAT_EN > 0)
+/************************************
+ * @brief: 		获取 memMalloc/memFree 耗时直方图
+ * @param[out] 	pxStat, 统计结果
+ * @return 		void
+ *************************************/
+void memGetLatencyStat( MemLatencyStat_t *pxStat );
+
+/************************************
+ * @brief: 		清零耗时统计，memManageFunctionInit 中会调用一次(同时打开 DWT 周期计数器)
+ * @param[in] 	void
+ * @return 		void
+ *************************************/
+void memResetLatencyStat( void );
+#endif
+
+#if defined(MEM_WASTE_STAT_EN) && (MEM_WASTE_STAT_EN > 0)
+/************************************
+ * @brief: 		获取内部碎片统计
+ * @param[out] 	pxStat, 统计结果
+ * @return 		void
+ *************************************/
+void memGetWasteStat( MemWasteStat_t *pxStat );
+
+/************************************
+ * @brief: 		获取空间效率，即申请字节数 / 实际分配字节数
+ * @param[in] 	void
+ * @return 		千分比，尚无申请时为 1000
+ *************************************/
+uint32_t memGetWasteEfficiency( void );
+
+/************************************
+ * @brief: 		清零内部碎片统计，memManageFunctionInit 中会调用一次
+ * @param[in] 	void
+ * @return 		void
+ *************************************/
+void memResetWasteStat( void );
+#endif
+
+#if defined(MEM_POSTMORTEM_EN) && (MEM_POSTMORTEM_EN > 0)
+/************************************
+ * @brief: 		生成失败快照，memMalloc 失败时自动调用，也可在看门狗或异常处理中调用；不申请内存，耗时有上限
+ * @param[in] 	xWantedSize, 记录到快照中的申请大小
+ * @return 		void
+ *************************************/
+void memPostMortemCapture( size_t xWantedSize );
+
+/************************************
+ * @brief: 		获取复位前保存的失败快照
+ * @param[in] 	void
+ * @return 		快照有效时返回快照地址，否则返回空指针
+ *************************************/
+const MemPostMortem_t *memPostMortemGet( void );
+
+/************************************
+ * @brief: 		清除失败快照，一般在快照上报后调用
+ * @param[in] 	void
+ * @return 		void
+ *************************************/
+void memPostMortemClear( void );
+#endif
+
+#if defined(MEM_PERSIST_EN) && (MEM_PERSIST_EN > 0)
+/************************************
+ * @brief: 		把文件映射到内存作为持久化堆区域，文件不存在时创建，不足 xSizeInBytes 时扩展
+ * @param[in] 	pcPath, 文件路径
+ * @param[in] 	xSizeInBytes, 区域大小，重启前后必须一致
+ * @return 		区域起始地址，失败返回空指针
+ *************************************/
+uint8_t *memPersistMapFile( const char *pcPath, size_t xSizeInBytes );
+
+/************************************
+ * @brief: 		解除 memPersistMapFile 的映射
+ * @param[in] 	pucStartAddress, xSizeInBytes 与映射时一致
+ * @return 		void
+ *************************************/
+void memPersistUnmapFile( uint8_t *pucStartAddress, size_t xSizeInBytes );
+
+/************************************
+ * @brief: 		保存堆状态并写回文件，下次启动时可直接接管；之后再申请或释放内存会使保存的状态失效
+ * @param[in] 	void
+ * @return 		0-成功，其他失败
+ *************************************/
+int memPersistSync( void );
+
+/************************************
+ * @brief: 		memManageFunctionInit 是否接管了文件中已有的堆
+ * @param[in] 	void
+ * @return 		1-接管已有的堆，0-新建的堆
+ *************************************/
+int memPersistIsWarmStart( void );
+
+/************************************
+ * @brief: 		设置/获取根对象，重启后通过根对象找回堆中的数据
+ * @param[in] 	pvRoot, 堆中申请的内存块地址
+ *************************************/
+void memPersistSetRoot( void *pvRoot );
+void *memPersistGetRoot( void );
+
+/************************************
+ * @brief: 		指针与区域内偏移互相转换，堆中数据互相引用时须保存偏移而不是指针
+ *************************************/
+size_t memPersistOffsetOf( const void *pv );
+void *memPersistPointerOf( size_t xOffset );
+#endif
+
 #if 0
 #define MEM_MALLOC		malloc
 #define MEM_FREE		free
@@ -124,11 +965,11 @@ void memPrintfFreeListLayout(void);
 
 // 字节对齐宏定义
 #if memBYTE_ALIGNMENT == 8
-	#define memBYTE_ALIGNMENT_MASK ( 0x0007U )
+	#define memBYTE_ALIGNMENT_MASK ( ( size_t ) 0x0007U )
 #endif
 
 #if memBYTE_ALIGNMENT == 4
-	#define memBYTE_ALIGNMENT_MASK	( 0x0003U)
+	#define memBYTE_ALIGNMENT_MASK	( ( size_t ) 0x0003U )
 #endif
 
 #ifdef __cplusplus
@@ -13,22 +13,164 @@
 	#error "please define MEM_MANAGE_PRINTF Macro, in mem_manage.h file !!!"
 #endif
 
+#if defined(OPERATE_SYSTEM) && (OPERATE_SYSTEM == SYSTEM_FREERTOS)
+	#include "FreeRTOS.h"
+	#include "task.h"
+#endif
+
+#if defined(MEM_HOSTED_MMAP_EN) && (MEM_HOSTED_MMAP_EN > 0)
+	#if !defined(__linux__)
+		#error "MEM_HOSTED_MMAP_EN only supports Linux hosts !!!"
+	#endif
+	#include <sys/mman.h>
+	#include <unistd.h>
+#endif
+
+#if defined(MEM_PERSIST_EN) && (MEM_PERSIST_EN > 0)
+	#if !defined(__linux__)
+		#error "MEM_PERSIST_EN only supports Linux hosts !!!"
+	#endif
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+#if defined(MEM_LATENCY_STAT_EN) && (MEM_LATENCY_STAT_EN > 0)
+	/* 周期计数器，可在 mem_manage.h 中用 MEM_CYCLE_COUNTER() 自行指定 */
+	#if !defined(MEM_CYCLE_COUNTER)
+		#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__) \
+			|| defined(__TARGET_ARCH_7_M) || defined(__TARGET_ARCH_7E_M)
+			#define heapDWT_CTRL		( *( volatile uint32_t * ) 0xE0001000UL )
+			#define heapDWT_CYCCNT		( *( volatile uint32_t * ) 0xE0001004UL )
+			#define heapDEMCR			( *( volatile uint32_t * ) 0xE000EDFCUL )
+			#define MEM_CYCLE_COUNTER()	( heapDWT_CYCCNT )
+		#elif defined(__x86_64__) || defined(__i386__)
+			#include <x86intrin.h>
+			#define MEM_CYCLE_COUNTER()	( ( uint32_t ) __rdtsc() )
+		#elif defined(__linux__)
+			#include <time.h>
+			static uint32_t prvCycleCounter( void )
+			{
+				struct timespec xNow;
+				( void ) clock_gettime( CLOCK_MONOTONIC, &xNow );
+				return ( uint32_t ) ( ( uint64_t ) xNow.tv_sec * 1000000000ULL + ( uint64_t ) xNow.tv_nsec );
+			}
+			#define MEM_CYCLE_COUNTER()	prvCycleCounter()
+		#else
+			#error "please define MEM_CYCLE_COUNTER() Macro for this platform !!!"
+		#endif
+	#endif
+#endif
+
 /*-----------------------------------------------------------*/
 
 /* Define the linked list structure.  This is used to link free blocks in order
 of their memory address. */
 typedef struct A_BLOCK_LINK
 {
+#if defined(MEM_PERSIST_EN) && (MEM_PERSIST_EN > 0)
+	size_t xNextFreeOffset;					/*<< 下一个空闲块相对堆区域起始地址的偏移，0 表示 NULL. */
+#else
 	struct A_BLOCK_LINK *pxNextFreeBlock;	/*<< The next free block in the list. */
+#endif
 	size_t xBlockSize;						/*<< The size of the free block. */
+#if defined(MEM_SNAPSHOT_EN) && (MEM_SNAPSHOT_EN > 0)
+	uint32_t ulSeq;							/*<< 分配序号，区分同一地址上先后分配的内存块. */
+#endif
+#if defined(MEM_AGE_EN) && (MEM_AGE_EN > 0)
+	uint32_t ulBirth;						/*<< 分配时的 MEM_GET_TIMESTAMP() 值. */
+#endif
 } BlockLink_t;
 
+#if defined(MEM_PERSIST_EN) && (MEM_PERSIST_EN > 0)
+/* 持久化堆区域起始处的描述信息，进程重启后据此接管堆. */
+typedef struct MemPersistHeader
+{
+	uint32_t ulMagic;
+	uint32_t ulVersion;
+	uint32_t ulClean;						/*<< 1 表示 memPersistSync 之后堆没有再被修改. */
+	uint32_t ulReserved;
+	size_t xRegionSize;
+	size_t xStartNextOffset;
+	size_t xEndOffset;
+	size_t xFreeBytesRemaining;
+	size_t xMinimumEverFreeBytesRemaining;
+	size_t xFreeBlockNum;
+	size_t xRootOffset;
+} MemPersistHeader_t;
+
+#define heapPERSIST_MAGIC		( ( uint32_t ) 0x4D4D4850UL )
+#define heapPERSIST_VERSION		( ( uint32_t ) 1 )
+
+static uint8_t *pucPersistBase = NULL;
+static MemPersistHeader_t *pxPersistHeader = NULL;
+static int xPersistWarmStart = 0;
+static const size_t xPersistHeaderSize = ( sizeof( MemPersistHeader_t ) + ( ( size_t ) ( memBYTE_ALIGNMENT - 1 ) ) ) & ~( ( size_t ) memBYTE_ALIGNMENT_MASK );
+
+/* 链表指针保存为相对 pucPersistBase 的偏移，文件映射到不同地址后仍然有效. */
+#define heapPERSIST_POINTER( xOffset )	( ( ( xOffset ) != 0 ) ? ( void * ) ( pucPersistBase + ( xOffset ) ) : NULL )
+#define heapPERSIST_OFFSET( pv )		( ( ( pv ) != NULL ) ? ( size_t ) ( ( uint8_t * ) ( pv ) - pucPersistBase ) : ( size_t ) 0 )
+
+#define heapGET_NEXT( pxBlock )				( ( BlockLink_t * ) heapPERSIST_POINTER( ( pxBlock )->xNextFreeOffset ) )
+#define heapSET_NEXT( pxBlock, pxNext )		( ( pxBlock )->xNextFreeOffset = heapPERSIST_OFFSET( pxNext ) )
+
+/* 堆一旦被修改，之前 memPersistSync 保存的状态失效. */
+#define heapPERSIST_TOUCH()					do { if( pxPersistHeader != NULL ) { pxPersistHeader->ulClean = 0; } } while( 0 )
+
+/*
+ * 区域起始处存在 memPersistSync 保存的有效堆时直接接管，返回 1；否则返回 0，需要重新建堆.
+ */
+static int prvPersistAttach( const MemHeapRegion_t * const pxHeapRegions );
+#else
+#define heapGET_NEXT( pxBlock )				( ( pxBlock )->pxNextFreeBlock )
+#define heapSET_NEXT( pxBlock, pxNext )		( ( pxBlock )->pxNextFreeBlock = ( pxNext ) )
+#define heapPERSIST_TOUCH()
+#endif
+
 /* The size of the structure placed at the beginning of each allocated memory
 block must by correctly byte aligned. */
 static const size_t xHeapStructSize	= ( sizeof( BlockLink_t ) + ( ( size_t ) ( memBYTE_ALIGNMENT - 1 ) ) ) & ~( ( size_t ) memBYTE_ALIGNMENT_MASK );
 
+#if defined(MEM_TREE_INDEX_EN) && (MEM_TREE_INDEX_EN > 0)
+/* 空闲块另按 (大小, 地址) 组织成红黑树，树节点保存在空闲块块头之后的用户区中. 地址链表保持不变，用于合并. */
+typedef struct MemTreeNode
+{
+	BlockLink_t *pxPrevFree;				/*<< 地址链表中的前一个空闲块，取出时不必从头查找. */
+	struct MemTreeNode *pxLeft;
+	struct MemTreeNode *pxRight;
+	size_t xParentColor;					/*<< 父节点地址，最低位为 1 表示红色. */
+} MemTreeNode_t;
+
+static const size_t xTreeNodeSize = ( sizeof( MemTreeNode_t ) + ( ( size_t ) ( memBYTE_ALIGNMENT - 1 ) ) ) & ~( ( size_t ) memBYTE_ALIGNMENT_MASK );
+
+/* 允许出现的最小尺寸内存块，释放后要能容纳树节点. */
+#define heapMINIMUM_BLOCK_SIZE	( ( size_t ) ( xHeapStructSize + xTreeNodeSize ) )
+#define heapFREE_META_SIZE		xTreeNodeSize
+#else
 /* 允许出现的最小尺寸内存块. */
 #define heapMINIMUM_BLOCK_SIZE	( ( size_t ) ( xHeapStructSize << 1 ) )
+#endif
+
+#if defined(MEM_EXACT_FIT_EN) && (MEM_EXACT_FIT_EN > 0)
+/* 空闲块用户区开头的链接. pxPrevFree 在所有空闲块中有效；大小被精确查找表跟踪的空闲块另外串成双向链表，
+   这类内存块至少要能容纳整个结构. */
+typedef struct MemExactLink
+{
+	BlockLink_t *pxPrevFree;				/*<< 地址链表中的前一个空闲块，取出时不必从头查找. */
+	BlockLink_t *pxExactNext;
+	BlockLink_t *pxExactPrev;
+} MemExactLink_t;
+
+static const size_t xExactLinkSize = ( sizeof( MemExactLink_t ) + ( ( size_t ) ( memBYTE_ALIGNMENT - 1 ) ) ) & ~( ( size_t ) memBYTE_ALIGNMENT_MASK );
+
+#define heapFREE_META_SIZE		xExactLinkSize
+#endif
+
+/* 空闲块用户区开头由分配器使用的字节数. */
+#ifndef heapFREE_META_SIZE
+#define heapFREE_META_SIZE		( ( size_t ) 0 )
+#endif
 
 /* Assumes 8bit bytes! */
 #define heapBITS_PER_BYTE		( ( size_t ) 8 )
@@ -37,9 +179,9 @@ static const size_t xHeapStructSize	= ( sizeof( BlockLink_t ) + ( ( size_t ) ( m
  * Inserts a block of memory that is being freed into the correct position in
  * the list of free memory blocks.  The block being freed will be merged with
  * the block in front it and/or the block behind it if the memory blocks are
- * adjacent to each other.
+ * adjacent to each other.  Returns the free block that finally contains it.
  */
-static void prvInsertBlockIntoFreeList( BlockLink_t *pxBlockToInsert );
+static BlockLink_t *prvInsertBlockIntoFreeList( BlockLink_t *pxBlockToInsert );
 
 /* Create a couple of list links to mark the start and end of the list. */
 static BlockLink_t xStart, *pxEnd = NULL;
@@ -55,19 +197,637 @@ application.  When the bit is free the block is still part of the free heap
 space. */
 static size_t xBlockAllocatedBit = 0;
 
+#if defined(MEM_TAG_EN) && (MEM_TAG_EN > 0)
+	#if ( MEM_TAG_BITS < 1 ) || ( MEM_TAG_BITS > 7 )
+		#error "MEM_TAG_BITS must be 1 ~ 7 !!!"
+	#endif
+
+/* 标签保存在 xBlockSize 中已分配标记之下的 MEM_TAG_BITS 位，只在内存块分配给应用期间有效，
+释放时在放回快速链表或空闲链表之前清除. */
+#define heapTAG_SHIFT			( ( sizeof( size_t ) * heapBITS_PER_BYTE ) - 1 - MEM_TAG_BITS )
+#define heapTAG_MASK			( ( ( size_t ) ( MEM_TAG_NUM - 1 ) ) << heapTAG_SHIFT )
+#define heapGET_TAG( pxBlock )	( ( uint8_t ) ( ( ( pxBlock )->xBlockSize & heapTAG_MASK ) >> heapTAG_SHIFT ) )
+
+static MemTagStat_t xTagStats[ MEM_TAG_NUM ];
+
+/*
+ * 在临界区内调用，把刚分配的内存块记入标签的用量并写入块头.
+ */
+static void prvTagAdd( BlockLink_t *pxBlock, uint8_t ucTag );
+
+/*
+ * 在临界区内调用，从内存块所属标签的用量中扣除并清除块头中的标签.
+ */
+static void prvTagRemove( BlockLink_t *pxBlock );
+
+/*
+ * 按堆中已分配的内存块重新统计各标签用量，持久化堆接管已有的堆时需要.
+ */
+static void prvTagRecount( void );
+
+	#if defined(MEM_TASK_TAG_NUM) && (MEM_TASK_TAG_NUM > 0) && defined(OPERATE_SYSTEM) && (OPERATE_SYSTEM == SYSTEM_FREERTOS)
+/* 任务与标签的绑定表，pvTask 为 NULL 表示空位. */
+typedef struct MemTaskTag
+{
+	void *pvTask;
+	uint8_t ucTag;
+} MemTaskTag_t;
+
+static MemTaskTag_t xTaskTags[ MEM_TASK_TAG_NUM ];
+
+/*
+ * 在临界区内调用，返回任务绑定的标签，未绑定时返回 MEM_TAG_DEFAULT.
+ */
+static uint8_t prvTaskTag( void *pvTask );
+	#endif
+#else
+#define heapTAG_MASK			( ( size_t ) 0 )
+#endif
+
+#if defined(MEM_QUOTA_EN) && (MEM_QUOTA_EN > 0)
+	#if !defined(MEM_TAG_EN) || (MEM_TAG_EN == 0)
+		#error "MEM_QUOTA_EN requires MEM_TAG_EN !!!"
+	#endif
+
+// 各标签的配额(字节)，0 表示不限制
+static size_t xTagQuota[ MEM_TAG_NUM ];
+
+/*
+ * 在临界区内调用，标签再申请 xBlockSize 字节(含块头)会超出配额时返回 1.
+ */
+static uint8_t prvQuotaExceeded( uint8_t ucTag, size_t xBlockSize );
+#endif
+
+#if defined(MEM_SNAPSHOT_EN) && (MEM_SNAPSHOT_EN > 0)
+// 下一个分配序号，每次申请成功加 1，回绕后按差值比较先后
+static uint32_t ulAllocSeq = 1;
+#endif
+
+/* xBlockSize 中不属于块大小的标记位. */
+#define heapBLOCK_FLAGS			( xBlockAllocatedBit | heapTAG_MASK )
+
 // 空闲内存块计数，表征内存碎片化情况
 static size_t xFreeBlockNum = 0;
 
+/* 各堆区域中第一个内存块和结束标记的位置，按地址遍历所有内存块时使用. */
+typedef struct MemRegionBound
+{
+	BlockLink_t *pxFirstBlock;
+	BlockLink_t *pxEndMarker;
+} MemRegionBound_t;
+
+static MemRegionBound_t xRegionBounds[ MEM_HEAP_REGION_MAX ];
+static size_t xRegionNum = 0;
+
+#if defined(MEM_OOB_META_EN) && (MEM_OOB_META_EN > 0)
+/* 带外空闲块描述. 空闲链表保存在连续的节点数组中，查找与合并只访问该数组；
+   空闲块头中的大小只供 memHeapWalk 使用，由分配器写入但从不读取，被用户越界改写也不影响分配. */
+typedef struct MemOobNode
+{
+	uint32_t ulOffset;			// 相对 pucOobBase 的偏移
+	uint32_t ulSize;			// 空闲块大小，含块头
+	uint16_t usNext;			// 地址更高的下一个空闲块，heapOOB_NIL 表示结束
+} MemOobNode_t;
+
+#define heapOOB_NIL					( ( uint16_t ) 0xFFFF )
+#define heapOOB_BLOCK( usNode )		( ( BlockLink_t * ) ( pucOobBase + xOobNodes[ usNode ].ulOffset ) )
+
+static MemOobNode_t xOobNodes[ MEM_OOB_NODE_NUM ] MEM_OOB_SECTION;
+static uint16_t usOobHead = heapOOB_NIL;		// 地址最低的空闲块
+static uint16_t usOobPool = heapOOB_NIL;		// 未使用的节点，经 usNext 串联
+static uint8_t *pucOobBase = NULL;				// 第一个堆区域的起始地址
+/* 已分配(含快速链表缓存)的内存块个数. 每个区域的空闲块最多比已分配的内存块多 1 个，
+   申请时保证该值不超过 MEM_OOB_NODE_NUM - xRegionNum，释放时就总有节点可用. */
+static size_t xOobUsedBlockNum = 0;
+
+/*
+ * 按 xRegionBounds 为每个区域的初始空闲块建立节点.
+ */
+static void prvOobInit( void );
+#endif
+
+#if defined(MEM_TREE_INDEX_EN) && (MEM_TREE_INDEX_EN > 0)
+#define heapTREE_RED					( ( size_t ) 1 )
+#define heapTREE_NODE( pxBlock )		( ( MemTreeNode_t * ) ( ( uint8_t * ) ( pxBlock ) + xHeapStructSize ) )
+#define heapTREE_BLOCK( pxNode )		( ( BlockLink_t * ) ( ( uint8_t * ) ( pxNode ) - xHeapStructSize ) )
+#define heapTREE_PARENT( pxNode )		( ( MemTreeNode_t * ) ( ( pxNode )->xParentColor & ~heapTREE_RED ) )
+#define heapTREE_IS_RED( pxNode )		( ( ( pxNode ) != NULL ) && ( ( ( pxNode )->xParentColor & heapTREE_RED ) != 0 ) )
+#define heapTREE_SET_PARENT( pxNode, pxParent )	( ( pxNode )->xParentColor = ( size_t ) ( pxParent ) | ( ( pxNode )->xParentColor & heapTREE_RED ) )
+#define heapTREE_SET_RED( pxNode )		( ( pxNode )->xParentColor |= heapTREE_RED )
+#define heapTREE_SET_BLACK( pxNode )	( ( pxNode )->xParentColor &= ~heapTREE_RED )
+
+static MemTreeNode_t *pxTreeRoot = NULL;
+
+/*
+ * 把空闲块加入红黑树，块大小在树中期间不能改变.
+ */
+static void prvTreeInsert( BlockLink_t *pxBlock );
+
+/*
+ * 把空闲块从红黑树中删除.
+ */
+static void prvTreeRemove( BlockLink_t *pxBlock );
+
+/*
+ * 空闲块插入地址链表中 pxPrevious 之后(与 pxPrevious 合并时两者相同)，更新前后两个空闲块的 pxPrevFree 并加入红黑树.
+ */
+static void prvTreeLink( BlockLink_t *pxPrevious, BlockLink_t *pxBlock );
+
+/*
+ * 按地址链表为初始的空闲块建立 pxPrevFree 和红黑树.
+ */
+static void prvTreeInit( void );
+
+#define heapTREE_REMOVE( pxBlock )				prvTreeRemove( pxBlock )
+#define heapTREE_LINK( pxPrevious, pxBlock )	prvTreeLink( pxPrevious, pxBlock )
+#else
+#define heapTREE_REMOVE( pxBlock )
+#define heapTREE_LINK( pxPrevious, pxBlock )
+#endif
+
+#if defined(MEM_EXACT_FIT_EN) && (MEM_EXACT_FIT_EN > 0)
+/* 精确查找表的一个槽，按内存块大小直接映射. */
+typedef struct MemExactSlot
+{
+	size_t xBlockSize;				// 跟踪的内存块大小(含块头)，0 表示空槽
+	BlockLink_t *pxHead;			// 该大小的空闲块
+	size_t xFreeNum;
+	uint32_t ulHits;
+	size_t xCandidate;				// 映射到本槽的申请中出现最多的内存块大小
+	uint32_t ulVotes;				// 候选大小的票数，相同大小的申请加 1，其他大小减 1
+} MemExactSlot_t;
+
+#define heapEXACT_META( pxBlock )		( ( MemExactLink_t * ) ( ( uint8_t * ) ( pxBlock ) + xHeapStructSize ) )
+
+static MemExactSlot_t xExactSlots[ MEM_EXACT_SLOT_NUM ];
+
+	#if defined(MEM_EXACT_SIZES)
+/* 编译时指定的跟踪尺寸(申请字节数)，通常由 tools/mem_sizeclass_gen 根据调用跟踪生成，第一次初始化堆时装入. */
+static const size_t xExactDefaultSizes[] = MEM_EXACT_SIZES;
+static uint8_t ucExactDefaultsLoaded = 0;
+	#endif
+
+/*
+ * 在临界区内调用，返回 xBlockSize 映射到的槽.
+ */
+static MemExactSlot_t *prvExactSlot( size_t xBlockSize );
+
+/*
+ * 在临界区内调用，为 xWantedSize 投票，表中有该大小的空闲块时直接从地址链表中取出，不分隔.
+ */
+static BlockLink_t *prvExactTake( size_t xWantedSize );
+
+/*
+ * 空闲块大小被跟踪时从精确查找表中删除，块大小改变之前调用.
+ */
+static void prvExactRemove( BlockLink_t *pxBlock );
+
+/*
+ * 空闲块已插入地址链表中 pxPrevious 之后(与 pxPrevious 合并时两者相同)，更新前后两个空闲块的 pxPrevFree，
+ * 大小被跟踪时加入精确查找表.
+ */
+static void prvExactLink( BlockLink_t *pxPrevious, BlockLink_t *pxBlock );
+
+/*
+ * 空闲块已从地址链表中取出，从精确查找表中删除并更新下一个空闲块的 pxPrevFree.
+ */
+static void prvExactUnlink( BlockLink_t *pxPrevious, BlockLink_t *pxBlock );
+
+/*
+ * 按地址链表重新建立 pxPrevFree 和精确查找表.
+ */
+static void prvExactInit( void );
+
+#define heapEXACT_REMOVE( pxBlock )				prvExactRemove( pxBlock )
+#define heapEXACT_LINK( pxPrevious, pxBlock )	prvExactLink( pxPrevious, pxBlock )
+#define heapEXACT_UNLINK( pxPrevious, pxBlock )	prvExactUnlink( pxPrevious, pxBlock )
+#else
+#define heapEXACT_REMOVE( pxBlock )
+#define heapEXACT_LINK( pxPrevious, pxBlock )
+#define heapEXACT_UNLINK( pxPrevious, pxBlock )
+#endif
+
+#if defined(MEM_CHECK_EN) && (MEM_CHECK_EN > 0)
+/* 增量检查的进度. 两次 memCheckStep 之间堆可能被修改，合并时若游标所在的块头被吞并，游标移到合并后的内存块，
+   保证游标始终指向有效块头；本轮中堆被修改过时不再核对计数. */
+typedef struct MemCheckCursor
+{
+	BlockLink_t *pxBlock;			// 下一个要检查的内存块，NULL 表示开始新一轮
+	BlockLink_t *pxExpectFree;		// 空闲链表中下一个应遇到的节点，NULL 表示未知
+	size_t xRegion;
+	size_t xFreeNum;				// 本轮已检查的空闲块个数
+	size_t xFreeBytes;				// 本轮已检查的空闲块和快速链表缓存块字节数
+	uint32_t ulGeneration;			// 上次检查时的 ulCheckGeneration
+	uint8_t ucPrevFree;				// 上一个内存块在空闲链表中
+	uint8_t ucDirty;				// 本轮中堆被修改过或发现过问题，不核对计数
+} MemCheckCursor_t;
+
+static MemCheckCursor_t xCheckCursor;
+static uint32_t ulCheckGeneration = 0;
+static uint32_t ulCheckPasses = 0;
+
+#define heapCHECK_TOUCH()					( ulCheckGeneration++ )
+#define heapCHECK_ABSORB( pxOld, pxNew )	do { if( xCheckCursor.pxBlock == ( pxOld ) ) { xCheckCursor.pxBlock = ( pxNew ); } } while( 0 )
+#else
+#define heapCHECK_TOUCH()
+#define heapCHECK_ABSORB( pxOld, pxNew )
+#endif
+
+#if defined(MEM_ZERO_EN) && (MEM_ZERO_EN > 0)
+/* 空闲块用户区的第一个字为清零标记，等于 heapZERO_MAGIC 时其后的用户区全部为 0. 释放时标记一律清除，
+   因此只有空闲链表中的内存块可能带有该标记，用户数据不会被误认为标记. */
+#define heapZERO_MAGIC						( ( size_t ) 0x5A45524FUL )
+#define heapZERO_MARK( pxBlock )			( *( size_t * ) ( ( uint8_t * ) ( pxBlock ) + xHeapStructSize ) )
+#define heapIS_ZERO( pxBlock )				( heapZERO_MARK( pxBlock ) == heapZERO_MAGIC )
+#define heapBLOCK_FITS( pxBlock, xWantedSize, ucZeroOnly ) \
+	( ( ( pxBlock )->xBlockSize >= ( xWantedSize ) ) && ( ( ( ucZeroOnly ) == 0 ) || heapIS_ZERO( pxBlock ) ) )
+
+// memZeroStep 正在清零的空闲块及已清零的字节数，该块被取走或被合并时作废
+static BlockLink_t *pxZeroCursor = NULL;
+static size_t xZeroDone = 0;
+
+#define heapZERO_CLEAR( pxBlock )			( heapZERO_MARK( pxBlock ) = 0 )
+#define heapZERO_FORGET( pxBlock )			do { if( pxZeroCursor == ( pxBlock ) ) { pxZeroCursor = NULL; xZeroDone = 0; } } while( 0 )
+// 被合并进来的一定有刚释放的内存块，合并后按未清零处理
+#define heapZERO_ABSORB( pxInto, pxOld )	do { heapZERO_CLEAR( pxInto ); heapZERO_FORGET( pxOld ); } while( 0 )
+#else
+#define heapBLOCK_FITS( pxBlock, xWantedSize, ucZeroOnly )	( ( pxBlock )->xBlockSize >= ( xWantedSize ) )
+#define heapZERO_CLEAR( pxBlock )
+#define heapZERO_FORGET( pxBlock )
+#define heapZERO_ABSORB( pxInto, pxOld )
+#endif
+
+#if defined(MEM_LATENCY_STAT_EN) && (MEM_LATENCY_STAT_EN > 0)
+static MemLatencyStat_t xLatencyStat;
+
+// 本次调用访问过的空闲链表节点数
+static size_t xNodesVisited = 0;
+#define heapCOUNT_NODE()		( xNodesVisited++ )
+
+static void prvLatencyRecord( MemLatencyHist_t *pxHist, uint32_t ulCycles, size_t xNodes );
+#else
+#define heapCOUNT_NODE()
+#endif
+
+#if defined(MEM_WASTE_STAT_EN) && (MEM_WASTE_STAT_EN > 0)
+static MemWasteStat_t xWasteStat;
+
+/*
+ * 在临界区内调用，记录一次成功申请的申请字节数、对齐后的块大小和实际分配的块大小.
+ */
+static void prvWasteRecord( size_t xRequestedSize, size_t xWantedSize, size_t xGrantedSize );
+#endif
+
 mem_manage_t xMemManage;
 
+#if defined(MEM_POSTMORTEM_EN) && (MEM_POSTMORTEM_EN > 0)
+/* 放在复位后不清零的段中，重启后仍可读出. */
+MemPostMortem_t xMemPostMortem MEM_POSTMORTEM_SECTION;
+
+static uint32_t prvPostMortemChecksum( const MemPostMortem_t *pxPostMortem );
+#endif
+
+#if defined(OPERATE_SYSTEM) && (OPERATE_SYSTEM == SYSTEM_FREERTOS)
+	#define memHEAP_LOCK()		vTaskSuspendAll()
+	#define memHEAP_UNLOCK()	( void ) xTaskResumeAll()
+#elif defined(OPERATE_SYSTEM) && (OPERATE_SYSTEM == SYSTEM_NO)
+	#define memHEAP_LOCK()
+	#define memHEAP_UNLOCK()
+#else
+    #error "please define OPERATE_SYSTEM Macro !!!"
+#endif
+
+#if defined(MEM_QUICK_FIT_EN) && (MEM_QUICK_FIT_EN > 0)
+/* 快速链表：按精确尺寸缓存刚释放的内存块，后进先出，暂不参与合并。
+缓存中的内存块保留 xBlockAllocatedBit，pxNextFreeBlock 指向链表中的下一块(链尾指向 pxEnd)，
+因此既不会被当作空闲链表中的块，重复释放时也能被 memFree 识别出来。 */
+static BlockLink_t *pxQuickList[ MEM_QUICK_LIST_NUM ];
+static size_t xQuickListLen[ MEM_QUICK_LIST_NUM ];
+
+static size_t prvQuickListIndex( size_t xBlockSize );
+static BlockLink_t *prvQuickListTake( size_t xWantedSize );
+static int prvQuickListPut( BlockLink_t *pxLink );
+static size_t prvQuickListFlush( size_t xIndex );
+static size_t prvQuickListFlushAll( void );
+
+	#if defined(MEM_QUICK_ADAPT_EN) && (MEM_QUICK_ADAPT_EN > 0)
+		#if ( MEM_QUICK_LIST_NUM > 255 ) || ( ( MEM_QUICK_ADAPT_MAX / memBYTE_ALIGNMENT ) < MEM_QUICK_LIST_NUM )
+			#error "MEM_QUICK_LIST_NUM must be at most 255 and MEM_QUICK_ADAPT_MAX must cover MEM_QUICK_LIST_NUM sizes !!!"
+		#endif
+/* 直方图第 i 格统计用户区大小为 (i + 1) * memBYTE_ALIGNMENT 的申请次数，与未调整时的链表序号一致.
+ucQuickListOf 把格映射到链表序号(MEM_QUICK_LIST_NUM 表示没有链表)，xQuickListBucket 是反向映射
+(heapQUICK_BUCKET_NUM 表示链表未使用)，两者只在 memQuickListRebalance 中修改. */
+#define heapQUICK_BUCKET_NUM		( MEM_QUICK_ADAPT_MAX / memBYTE_ALIGNMENT )
+static uint32_t ulQuickHist[ heapQUICK_BUCKET_NUM ];
+static uint32_t ulQuickSamples = 0;
+static uint8_t ucQuickListOf[ heapQUICK_BUCKET_NUM ];
+static size_t xQuickListBucket[ MEM_QUICK_LIST_NUM ];
+
+static size_t prvQuickBucket( size_t xBlockSize );
+static void prvQuickCount( size_t xWantedSize );
+static void prvQuickAdaptInit( void );
+#define heapQUICK_COUNT( xWantedSize )		prvQuickCount( xWantedSize )
+	#else
+#define heapQUICK_COUNT( xWantedSize )
+	#endif
+#endif
+
+#if defined(MEM_RESERVE_EN) && (MEM_RESERVE_EN > 0)
+	#if defined(MEM_PERSIST_EN) && (MEM_PERSIST_EN > 0)
+		#error "MEM_RESERVE_EN can not be used with MEM_PERSIST_EN !!!"
+	#endif
+	#if ( MEM_RESERVE_SIZE < 64 )
+		#error "MEM_RESERVE_SIZE must be at least 64 !!!"
+	#endif
+/* 应急储备：一块打上已分配标记的内存块，不在空闲链表中，普通申请看不到。
+紧急申请从储备开头切出所需大小，剩余部分仍作为储备；重新预留一整块后，剩余部分归还空闲链表. */
+#define heapRESERVE_SIZE			( ( size_t ) MEM_RESERVE_SIZE & ~( ( size_t ) memBYTE_ALIGNMENT_MASK ) )
+static BlockLink_t *pxReserveBlock = NULL;
+static size_t xReserveBlockSize = 0;			// 储备的块大小，不含标记位
+static size_t xReserveFailDepth = 0;			// 正在执行的 malloc_fail_cb 层数，不为 0 时普通申请也可以使用储备
+
+static void prvReserveFill( void );
+static BlockLink_t *prvReserveTake( size_t xWantedSize );
+// 释放后剩余空闲内存不少于储备的两倍时才重新预留，避免刚恢复的普通申请马上又失败
+#define heapRESERVE_REFILL()	do { if( ( xReserveBlockSize < heapRESERVE_SIZE ) && ( xFreeBytesRemaining >= ( heapRESERVE_SIZE << 1 ) ) ) { prvReserveFill(); } } while( 0 )
+#else
+#define heapRESERVE_REFILL()
+#endif
+
+#if defined(MEM_WAIT_EN) && (MEM_WAIT_EN > 0)
+	#if !defined(OPERATE_SYSTEM) || (OPERATE_SYSTEM != SYSTEM_FREERTOS)
+		#error "MEM_WAIT_EN only supports FreeRTOS !!!"
+	#endif
+/* memMallocWait 的等待者，保存在调用任务的栈上，按优先级从高到低链接，同优先级先来先服务.
+被唤醒时由释放方移出链表，超时后由等待的任务自己移出. */
+typedef struct MemWaiter
+{
+	struct MemWaiter *pxNext;
+	TaskHandle_t xTask;
+	UBaseType_t uxPriority;
+	size_t xBlockSize;				// 需要的块大小，含块头并对齐
+	uint8_t ucLinked;
+} MemWaiter_t;
+
+static MemWaiter_t *pxWaitList = NULL;
+#define heapWAIT_PENDING()			( pxWaitList != NULL )
+
+static void prvWaitLink( MemWaiter_t *pxWaiter );
+static void prvWaitUnlink( MemWaiter_t *pxWaiter );
+static void prvWaitWake( size_t xFreeSize );
+
+	#if ( MEM_WAIT_NOTIFY_INDEX > 0 )
+		#define heapWAIT_NOTIFY( xTask )	( void ) xTaskNotifyGiveIndexed( ( xTask ), MEM_WAIT_NOTIFY_INDEX )
+		#define heapWAIT_BLOCK( xTicks )	( void ) ulTaskNotifyTakeIndexed( MEM_WAIT_NOTIFY_INDEX, pdTRUE, ( xTicks ) )
+	#else
+		#define heapWAIT_NOTIFY( xTask )	( void ) xTaskNotifyGive( xTask )
+		#define heapWAIT_BLOCK( xTicks )	( void ) ulTaskNotifyTake( pdTRUE, ( xTicks ) )
+	#endif
+#else
+#define heapWAIT_PENDING()			( 0 )
+#endif
+
+/*
+ * 从空闲链表中找出一块可用内存块并摘下，必要时分隔，返回的内存块尚未打上已分配标记.
+ * ucZeroOnly 非 0 时只取已清零的内存块(MEM_ZERO_EN). 找不到合适的内存块时返回 NULL.
+ */
+static BlockLink_t *prvTakeBlockFromFreeList( size_t xWantedSize, uint8_t ucZeroOnly );
+
+/* 一次申请/释放调用的附加信息，由各对外接口传给 prvMalloc/prvFree. */
+typedef struct MemAllocCall
+{
+	uint8_t ucTraceOp;		// 跟踪记录中的操作类型，MEM_TRACE_OP_NONE 表示不记录
+	size_t xCaller;			// 调用者标识(返回地址)，记录到跟踪中
+	uint8_t ucTag;			// 内存块的标签，未打开 MEM_TAG_EN 时忽略
+	uint8_t ucFlags;		// heapCALL_xxx 的组合
+} MemAllocCall_t;
+
+#define heapCALL_CRITICAL		( ( uint8_t ) 0x01 )	// 堆中找不到可用内存时可以使用应急储备，未打开 MEM_RESERVE_EN 时忽略
+#define heapCALL_WAIT			( ( uint8_t ) 0x02 )	// 由 memMallocWait 发起，失败时阻塞等待，不调用失败回调
+
+static void *prvMalloc( size_t xWantedSize, const MemAllocCall_t *pxCall );
+static void prvFree( void *pv, const MemAllocCall_t *pxCall );
+
+#if defined(MEM_EXACT_FIT_EN) && (MEM_EXACT_FIT_EN > 0)
+	#if ( defined(MEM_PERSIST_EN) && (MEM_PERSIST_EN > 0) ) || ( defined(MEM_OOB_META_EN) && (MEM_OOB_META_EN > 0) ) \
+		|| ( defined(MEM_ZERO_EN) && (MEM_ZERO_EN > 0) ) || ( defined(MEM_TREE_INDEX_EN) && (MEM_TREE_INDEX_EN > 0) )
+		#error "MEM_EXACT_FIT_EN can not be used with MEM_PERSIST_EN, MEM_OOB_META_EN, MEM_ZERO_EN or MEM_TREE_INDEX_EN !!!"
+	#endif
+	#if ( MEM_EXACT_SLOT_NUM < 1 )
+		#error "MEM_EXACT_SLOT_NUM must be greater than 0 !!!"
+	#endif
+#endif
+
+#if defined(MEM_TREE_INDEX_EN) && (MEM_TREE_INDEX_EN > 0)
+	#if ( defined(MEM_PERSIST_EN) && (MEM_PERSIST_EN > 0) ) || ( defined(MEM_OOB_META_EN) && (MEM_OOB_META_EN > 0) ) \
+		|| ( defined(MEM_ZERO_EN) && (MEM_ZERO_EN > 0) )
+		#error "MEM_TREE_INDEX_EN can not be used with MEM_PERSIST_EN, MEM_OOB_META_EN or MEM_ZERO_EN !!!"
+	#endif
+#endif
+
+#if defined(MEM_OOB_META_EN) && (MEM_OOB_META_EN > 0)
+	#if ( defined(MEM_PERSIST_EN) && (MEM_PERSIST_EN > 0) ) || ( defined(MEM_CHECK_EN) && (MEM_CHECK_EN > 0) ) \
+		|| ( defined(MEM_ZERO_EN) && (MEM_ZERO_EN > 0) )
+		#error "MEM_OOB_META_EN can not be used with MEM_PERSIST_EN, MEM_CHECK_EN or MEM_ZERO_EN !!!"
+	#endif
+	#if ( MEM_OOB_NODE_NUM < 2 ) || ( MEM_OOB_NODE_NUM > 65535 )
+		#error "MEM_OOB_NODE_NUM must be 2 ~ 65535 !!!"
+	#endif
+#endif
+
+#if defined(MEM_TRACE_EN) && (MEM_TRACE_EN > 0)
+	#if ( MEM_TRACE_BUF_SIZE & ( MEM_TRACE_BUF_SIZE - 1 ) ) != 0
+		#error "MEM_TRACE_BUF_SIZE must be a power of 2 !!!"
+	#endif
+
+	// 跟踪记录只在 MEM_TRACE_CALLER_EN 时带调用者，采样分析单独打开时不影响跟踪数据
+	#if defined(MEM_TRACE_CALLER_EN) && (MEM_TRACE_CALLER_EN > 0)
+		#define heapTRACE_CALLER( xCaller )		( xCaller )
+	#else
+		#define heapTRACE_CALLER( xCaller )		( ( size_t ) 0 )
+	#endif
+
+/* 跟踪记录环形缓冲区，xTraceHead/xTraceTail 只增不减，取模得到下标. */
+static uint8_t ucTraceBuf[ MEM_TRACE_BUF_SIZE ];
+static size_t xTraceHead = 0, xTraceTail = 0;
+static uint32_t ulTraceDropped = 0, ulTraceDroppedPending = 0;
+static uint32_t ulTraceLastTimestamp = 0;
+
+/*
+ * 在临界区内调用，生成一条跟踪记录写入环形缓冲区，空间不足时丢弃并计数.
+ */
+static void prvTraceRecord( uint8_t ucOp, size_t xCaller, const size_t *pxArgs, size_t xArgNum );
+
+// 用户区地址转换为跟踪记录中的偏移，NULL 为 0
+#define heapTRACE_OFFSET( pv )	( ( ( pv ) != NULL ) ? ( ( ( size_t ) ( pv ) - ( size_t ) xRegionBounds[ 0 ].pxFirstBlock ) / memBYTE_ALIGNMENT + 1 ) : ( size_t ) 0 )
+#endif
+
+/* 调用者标识(返回地址)，仅在跟踪调用者或采样分析打开时获取. */
+#if !defined(MEM_TRACE_CALLER)
+	#if ( defined(MEM_TRACE_EN) && (MEM_TRACE_EN > 0) && defined(MEM_TRACE_CALLER_EN) && (MEM_TRACE_CALLER_EN > 0) ) \
+		|| ( defined(MEM_PROFILE_EN) && (MEM_PROFILE_EN > 0) )
+		#if defined(__CC_ARM)
+			#define MEM_TRACE_CALLER()		( ( size_t ) __return_address() )
+		#elif defined(__GNUC__)
+			#define MEM_TRACE_CALLER()		( ( size_t ) __builtin_return_address( 0 ) )
+		#else
+			#define MEM_TRACE_CALLER()		( ( size_t ) 0 )
+		#endif
+	#else
+		#define MEM_TRACE_CALLER()		( ( size_t ) 0 )
+	#endif
+#endif
+
+#if defined(MEM_PROFILE_EN) && (MEM_PROFILE_EN > 0)
+	#if ( MEM_PROFILE_SAMPLE_NUM & ( MEM_PROFILE_SAMPLE_NUM - 1 ) ) != 0
+		#error "MEM_PROFILE_SAMPLE_NUM must be a power of 2 !!!"
+	#endif
+
+/* 存活样本表，以用户区地址为键的开放寻址哈希表，pvBlock 为 NULL 表示空位. */
+typedef struct MemProfileSample
+{
+	void *pvBlock;
+	size_t xSite;
+	size_t xSize;
+} MemProfileSample_t;
+
+static MemProfileSample_t xProfileSamples[ MEM_PROFILE_SAMPLE_NUM ];
+static size_t xProfileLive = 0;
+static size_t xProfileCountdown = 0;	// 距下一次采样还需申请的字节数
+static uint32_t ulProfileRand = 1;
+static uint32_t ulProfileDropped = 0;
+
+/*
+ * 在临界区内调用，累计申请字节数，到达采样点时记录该内存块.
+ */
+static void prvProfileSample( void *pv, size_t xSize, size_t xSite );
+
+/*
+ * 在临界区内调用，被采样的内存块释放时移除样本.
+ */
+static void prvProfileRemove( void *pv );
+#endif
+
+/* 时间戳来源，仅在需要时间戳的功能打开时使用. */
+#if !defined(MEM_GET_TIMESTAMP) && ( ( defined(MEM_TRACE_EN) && (MEM_TRACE_EN > 0) ) || ( defined(MEM_AGE_EN) && (MEM_AGE_EN > 0) ) )
+	#if defined(OPERATE_SYSTEM) && (OPERATE_SYSTEM == SYSTEM_FREERTOS)
+		#define MEM_GET_TIMESTAMP()		( ( uint32_t ) xTaskGetTickCount() )
+	#elif defined(__linux__)
+		#include <time.h>
+		static uint32_t prvGetTimestamp( void )
+		{
+			struct timespec xNow;
+			( void ) clock_gettime( CLOCK_MONOTONIC, &xNow );
+			return ( uint32_t ) ( ( uint64_t ) xNow.tv_sec * 1000000ULL + ( uint64_t ) xNow.tv_nsec / 1000ULL );
+		}
+		#define MEM_GET_TIMESTAMP()		prvGetTimestamp()
+	#else
+		#define MEM_GET_TIMESTAMP()		( ( uint32_t ) 0 )
+	#endif
+#endif
+
+#if defined(MEM_HOSTED_MMAP_EN) && (MEM_HOSTED_MMAP_EN > 0)
+static size_t xHostedPageSize = 0;
+static size_t xHostedReleasedBytes = 0;
+
+/*
+ * 刚释放的 [pucFreedStart, pucFreedEnd) 已并入空闲块 pxBlock，把其中完整落在
+ * pxBlock 用户区内的页面归还给操作系统，空闲块头部所在页面保留.
+ */
+static void prvHostedReleasePages( BlockLink_t *pxBlock, uint8_t *pucFreedStart, uint8_t *pucFreedEnd );
+#endif
+
 /*-----------------------------------------------------------*/
 
 void *memMalloc( size_t xWantedSize )
 {
-	BlockLink_t *pxBlock, *pxBlock_used, *pxPreviousBlock, *pxPreviousBlock_used, *pxNewBlockLink;
+	MemAllocCall_t xCall;
+
+	xCall.ucTraceOp = MEM_TRACE_OP_MALLOC;
+	xCall.xCaller = MEM_TRACE_CALLER();
+	xCall.ucTag = MEM_TAG_DEFAULT;
+	xCall.ucFlags = 0;
+
+	return prvMalloc( xWantedSize, &xCall );
+}
+/*-----------------------------------------------------------*/
+
+void *memMallocSite( size_t xWantedSize, size_t xSite )
+{
+	MemAllocCall_t xCall;
+
+	xCall.ucTraceOp = MEM_TRACE_OP_MALLOC;
+	xCall.xCaller = xSite;
+	xCall.ucTag = MEM_TAG_DEFAULT;
+	xCall.ucFlags = 0;
+
+	return prvMalloc( xWantedSize, &xCall );
+}
+/*-----------------------------------------------------------*/
+
+void *memMallocTagged( size_t xWantedSize, uint8_t ucTag )
+{
+	MemAllocCall_t xCall;
+
+#if defined(MEM_TAG_EN) && (MEM_TAG_EN > 0)
+	if( ucTag >= MEM_TAG_NUM )
+	{
+		return NULL;
+	}
+#else
+	ucTag = MEM_TAG_DEFAULT;
+#endif
+
+	xCall.ucTraceOp = MEM_TRACE_OP_MALLOC;
+	xCall.xCaller = MEM_TRACE_CALLER();
+	xCall.ucTag = ucTag;
+	xCall.ucFlags = 0;
+
+	return prvMalloc( xWantedSize, &xCall );
+}
+/*-----------------------------------------------------------*/
+
+void *memMallocCritical( size_t xWantedSize )
+{
+	MemAllocCall_t xCall;
+
+	xCall.ucTraceOp = MEM_TRACE_OP_MALLOC;
+	xCall.xCaller = MEM_TRACE_CALLER();
+	xCall.ucTag = MEM_TAG_DEFAULT;
+	xCall.ucFlags = heapCALL_CRITICAL;
+
+	return prvMalloc( xWantedSize, &xCall );
+}
+/*-----------------------------------------------------------*/
+
+static void *prvMalloc( size_t xWantedSize, const MemAllocCall_t *pxCall )
+{
+	BlockLink_t *pxBlock = NULL;
 	void *pvReturn = NULL;
+#if defined(MEM_LATENCY_STAT_EN) && (MEM_LATENCY_STAT_EN > 0)
+	uint32_t ulStartCycle;
+#endif
+#if ( defined(MEM_PROFILE_EN) && (MEM_PROFILE_EN > 0) ) || ( defined(MEM_WASTE_STAT_EN) && (MEM_WASTE_STAT_EN > 0) )
+	size_t xRequestedSize = xWantedSize;
+#endif
+#if defined(MEM_TAG_EN) && (MEM_TAG_EN > 0)
+	uint8_t ucTag = pxCall->ucTag;
+#endif
+#if defined(MEM_QUOTA_EN) && (MEM_QUOTA_EN > 0)
+	uint8_t ucQuotaExceeded = 0;
+#endif
+#if defined(MEM_ZERO_EN) && (MEM_ZERO_EN > 0)
+	// calloc 优先使用已清零的内存块
+	uint8_t ucPreferZero = ( pxCall->ucTraceOp == MEM_TRACE_OP_CALLOC ) ? 1 : 0;
+#else
+	uint8_t ucPreferZero = 0;
+#endif
+	uint8_t ucZeroFill = 0;
+#if defined(MEM_TRACE_EN) && (MEM_TRACE_EN > 0)
+	size_t xTraceArgs[ 2 ];
 
-	// size_t search_depth = 0;  // 尝试查找更优内存块的深度
+	xTraceArgs[ 0 ] = xWantedSize;
+#endif
 
 	/* The heap must be initialised before the first call to
 	prvPortMalloc(). */
@@ -75,18 +835,20 @@ void *memMalloc( size_t xWantedSize )
 		return NULL;
 	}
 
-#if defined(OPERATE_SYSTEM) && (OPERATE_SYSTEM == SYSTEM_FREERTOS)
-	vTaskSuspendAll();
-#elif defined(OPERATE_SYSTEM) && (OPERATE_SYSTEM == SYSTEM_NO)
-#else
-    #error "please define OPERATE_SYSTEM Macro !!!"
-#endif
+	memHEAP_LOCK();
 	{
+	#if defined(MEM_LATENCY_STAT_EN) && (MEM_LATENCY_STAT_EN > 0)
+		xNodesVisited = 0;
+		ulStartCycle = MEM_CYCLE_COUNTER();
+	#endif
+		heapPERSIST_TOUCH();
+		heapCHECK_TOUCH();
+
 		/* Check the requested block size is not so large that the top bit is
 		set.  The top bit of the block size member of the BlockLink_t structure
 		is used to determine who owns the block - the application or the
 		kernel, so it must be free. */
-		if( ( xWantedSize & xBlockAllocatedBit ) == 0 )
+		if( ( xWantedSize & heapBLOCK_FLAGS ) == 0 )
 		{
 			/* The wanted size is increased so it can contain a BlockLink_t
 			structure in addition to the requested amount of bytes. */
@@ -105,129 +867,183 @@ void *memMalloc( size_t xWantedSize )
 				{
 					MEM_NO_HANDLE(0);
 				}
-			}
+
+			#if defined(MEM_TREE_INDEX_EN) && (MEM_TREE_INDEX_EN > 0)
+				// 释放后要能容纳树节点
+				if( xWantedSize < heapMINIMUM_BLOCK_SIZE )
+				{
+					xWantedSize = heapMINIMUM_BLOCK_SIZE;
+				}
+			#endif
+			}
 			else
 			{
                 MEM_NO_HANDLE(0); 
 			}
 
-			if( ( xWantedSize > 0 ) && ( xWantedSize <= xFreeBytesRemaining ) )
+		#if defined(MEM_TAG_EN) && (MEM_TAG_EN > 0) && defined(MEM_TASK_TAG_NUM) && (MEM_TASK_TAG_NUM > 0) \
+			&& defined(OPERATE_SYSTEM) && (OPERATE_SYSTEM == SYSTEM_FREERTOS)
+			// 未指定标签的申请记入当前任务绑定的标签
+			if( ucTag == MEM_TAG_DEFAULT )
 			{
-				/* Traverse the list from the start	(lowest address) block until
-				one	of adequate size is found. */
-				pxPreviousBlock = &xStart;
-				pxBlock = xStart.pxNextFreeBlock;
-				while( ( pxBlock->xBlockSize < xWantedSize ) && ( pxBlock->pxNextFreeBlock != NULL ) )
-				{
-					pxPreviousBlock = pxBlock;
-					pxBlock = pxBlock->pxNextFreeBlock;
-				}
+				ucTag = prvTaskTag( ( void * ) xTaskGetCurrentTaskHandle() );
+			}
+		#endif
+
+		#if defined(MEM_QUOTA_EN) && (MEM_QUOTA_EN > 0)
+			// 配额在查找之前检查，超出时不查找空闲内存
+			ucQuotaExceeded = prvQuotaExceeded( ucTag, xWantedSize );
+			if( ucQuotaExceeded == 0 )
+		#endif
+			{
+			#if defined(MEM_QUICK_FIT_EN) && (MEM_QUICK_FIT_EN > 0)
+				// 优先复用快速链表中尺寸完全相同的内存块，无需查找和分隔
+				heapQUICK_COUNT( xWantedSize );
+				pxBlock = prvQuickListTake( xWantedSize );
+			#endif
 
-				/* If the end marker was reached then a block of adequate size
-				was	not found. */
-				if( pxBlock != pxEnd )
+				if( ( pxBlock == NULL ) && ( xWantedSize > 0 ) && ( xWantedSize <= xFreeBytesRemaining ) )
 				{
-					pxBlock_used = pxBlock;
-					pxPreviousBlock_used = pxPreviousBlock;
-				#if defined(TATTER_OPTIME_EN) && (TATTER_OPTIME_EN > 0)
-					// 找到了第一个可用内存块，且很大，需要分隔，真的需要分隔，不再找找
-					if( ( pxBlock->xBlockSize - xWantedSize ) > heapMINIMUM_BLOCK_SIZE ){
-						pxBlock_used = pxBlock;  // 保存可用的pxBlock
-						pxPreviousBlock_used = pxPreviousBlock;
-						// 找下一个更合适的内存块
-						pxPreviousBlock = pxBlock;
-						pxBlock = pxBlock->pxNextFreeBlock;
-						while(pxBlock->pxNextFreeBlock != NULL){
-							if((pxBlock->xBlockSize >= xWantedSize) \
-								&& ((pxBlock->xBlockSize - xWantedSize) <= heapMINIMUM_BLOCK_SIZE)){
-								// 找到新的更优内存块
-								pxBlock_used = pxBlock;
-								pxPreviousBlock_used = pxPreviousBlock;
-							}
-
-							#if 0   // 为优化效率考虑的，碎片较多时，查询可能比较耗时，可控制查询深度
-							search_depth++;
-							if(search_depth >= 10)
-								break; // 不找了，
-							#endif
-
-							// 下一个内存块
-							pxPreviousBlock = pxBlock;
-							pxBlock = pxBlock->pxNextFreeBlock;
-						}
-					}
-				#endif
-					/* Return the memory space pointed to - jumping over the
-					BlockLink_t structure at its start. */
-					pvReturn = ( void * ) ( ( ( uint8_t * ) pxPreviousBlock_used->pxNextFreeBlock ) + xHeapStructSize );
-
-					/* This block is being returned for use so must be taken out
-					of the list of free blocks. */
-					pxPreviousBlock_used->pxNextFreeBlock = pxBlock_used->pxNextFreeBlock;
-					xFreeBlockNum--;
-					/* If the block is larger than required it can be split into
-					two. */
-					if( ( pxBlock_used->xBlockSize - xWantedSize ) > heapMINIMUM_BLOCK_SIZE )
+					pxBlock = prvTakeBlockFromFreeList( xWantedSize, ucPreferZero );
+					if( ( pxBlock == NULL ) && ( ucPreferZero != 0 ) )
 					{
-						/* This block is to be split into two.  Create a new
-						block following the number of bytes requested. The void
-						cast is used to prevent byte alignment warnings from the
-						compiler. */
-						pxNewBlockLink = ( void * ) ( ( ( uint8_t * ) pxBlock_used ) + xWantedSize );
-
-						/* Calculate the sizes of two blocks split from the
-						single block. */
-						pxNewBlockLink->xBlockSize = pxBlock_used->xBlockSize - xWantedSize;
-						pxBlock_used->xBlockSize = xWantedSize;
-						/* Insert the new block into the list of free blocks. */
-						prvInsertBlockIntoFreeList( ( pxNewBlockLink ) );
+						pxBlock = prvTakeBlockFromFreeList( xWantedSize, 0 );
 					}
-					else
+
+				#if defined(MEM_QUICK_FIT_EN) && (MEM_QUICK_FIT_EN > 0)
+					// 空闲链表中找不到，把快速链表缓存的内存块合并回空闲链表后再找一次
+					if( ( pxBlock == NULL ) && ( prvQuickListFlushAll() > 0 ) )
 					{
-                        MEM_NO_HANDLE(0); 
+						pxBlock = prvTakeBlockFromFreeList( xWantedSize, 0 );
 					}
+				#endif
+				}
+				else
+				{
+					MEM_NO_HANDLE(0);
+				}
 
-					xFreeBytesRemaining -= pxBlock_used->xBlockSize;
+			#if defined(MEM_RESERVE_EN) && (MEM_RESERVE_EN > 0)
+				// 堆中找不到时，紧急申请和失败回调中的申请从应急储备中切出
+				if( ( pxBlock == NULL ) && ( xWantedSize > 0 ) && ( ( ( pxCall->ucFlags & heapCALL_CRITICAL ) != 0 ) || ( xReserveFailDepth > 0 ) ) )
+				{
+					pxBlock = prvReserveTake( xWantedSize );
+				}
+			#endif
+			}
 
-					if( xFreeBytesRemaining < xMinimumEverFreeBytesRemaining )
-					{
-						xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
-					}
-					else
-					{
-                        MEM_NO_HANDLE(0);
-					}
+			if( pxBlock != NULL )
+			{
+				xFreeBytesRemaining -= pxBlock->xBlockSize;
 
-					/* The block is being returned - it is allocated and owned
-					by the application and has no "next" block. */
-					pxBlock_used->xBlockSize |= xBlockAllocatedBit;
-					pxBlock_used->pxNextFreeBlock = NULL;
+			#if defined(MEM_WASTE_STAT_EN) && (MEM_WASTE_STAT_EN > 0)
+				prvWasteRecord( xRequestedSize, xWantedSize, pxBlock->xBlockSize );
+			#endif
+
+				if( xFreeBytesRemaining < xMinimumEverFreeBytesRemaining )
+				{
+					xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
 				}
 				else
 				{
-                    MEM_NO_HANDLE(0); 
+                    MEM_NO_HANDLE(0);
 				}
+
+				/* The block is being returned - it is allocated and owned
+				by the application and has no "next" block. */
+				pxBlock->xBlockSize |= xBlockAllocatedBit;
+				heapSET_NEXT( pxBlock, NULL );
+
+				// calloc 取到已清零的内存块时只需清除标记字，其他情况在临界区外清零
+			#if defined(MEM_ZERO_EN) && (MEM_ZERO_EN > 0)
+				ucZeroFill = ( ( ucPreferZero != 0 ) && !heapIS_ZERO( pxBlock ) ) ? 1 : 0;
+				heapZERO_CLEAR( pxBlock );
+			#else
+				ucZeroFill = ( pxCall->ucTraceOp == MEM_TRACE_OP_CALLOC ) ? 1 : 0;
+			#endif
+
+			#if defined(MEM_TAG_EN) && (MEM_TAG_EN > 0)
+				prvTagAdd( pxBlock, ucTag );
+			#endif
+			#if defined(MEM_SNAPSHOT_EN) && (MEM_SNAPSHOT_EN > 0)
+				pxBlock->ulSeq = ulAllocSeq++;
+			#endif
+			#if defined(MEM_AGE_EN) && (MEM_AGE_EN > 0)
+				pxBlock->ulBirth = MEM_GET_TIMESTAMP();
+			#endif
+
+				/* Return the memory space pointed to - jumping over the
+				BlockLink_t structure at its start. */
+				pvReturn = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xHeapStructSize );
 			}
 			else
 			{
-                MEM_NO_HANDLE(0);
+                MEM_NO_HANDLE(0); 
 			}
 		}
 		else
 		{
             MEM_NO_HANDLE(0); 
 		}
+
+	#if defined(MEM_PROFILE_EN) && (MEM_PROFILE_EN > 0)
+		if( pvReturn != NULL )
+		{
+			prvProfileSample( pvReturn, xRequestedSize, pxCall->xCaller );
+		}
+	#endif
+
+	#if defined(MEM_LATENCY_STAT_EN) && (MEM_LATENCY_STAT_EN > 0)
+		prvLatencyRecord( ( pvReturn != NULL ) ? &xLatencyStat.xMallocHit : &xLatencyStat.xMallocMiss,
+						  MEM_CYCLE_COUNTER() - ulStartCycle, xNodesVisited );
+	#endif
+
+	#if defined(MEM_TRACE_EN) && (MEM_TRACE_EN > 0)
+		if( pxCall->ucTraceOp != MEM_TRACE_OP_NONE )
+		{
+			xTraceArgs[ 1 ] = heapTRACE_OFFSET( pvReturn );
+			prvTraceRecord( pxCall->ucTraceOp, heapTRACE_CALLER( pxCall->xCaller ), xTraceArgs, 2 );
+		}
+	#endif
 	}
-#if defined(OPERATE_SYSTEM) && (OPERATE_SYSTEM == SYSTEM_FREERTOS)
-	( void ) xTaskResumeAll();
-#elif defined(OPERATE_SYSTEM) && (OPERATE_SYSTEM == SYSTEM_NO)
-#else
-    #error "please define OPERATE_SYSTEM Macro !!!"
-#endif
-	if( pvReturn == NULL )
+	memHEAP_UNLOCK();
+
+	// memMallocWait 失败后阻塞等待，超时也不调用回调
+	if( ( pvReturn == NULL ) && ( ( pxCall->ucFlags & heapCALL_WAIT ) == 0 ) )
 	{
-		if (xMemManage.malloc_fail_cb)
-			xMemManage.malloc_fail_cb(xWantedSize);
+	#if defined(MEM_QUOTA_EN) && (MEM_QUOTA_EN > 0)
+		// 超出配额不是堆本身的问题，不保存快照，也不调用 malloc_fail_cb
+		if( ucQuotaExceeded != 0 )
+		{
+			if (xMemManage.quota_exceeded_cb)
+				xMemManage.quota_exceeded_cb(xWantedSize, ucTag);
+		}
+		else
+	#endif
+		{
+		#if defined(MEM_POSTMORTEM_EN) && (MEM_POSTMORTEM_EN > 0)
+			// 失败回调中一般会重启系统，先保存快照
+			memPostMortemCapture( xWantedSize );
+		#endif
+		#if defined(MEM_RESERVE_EN) && (MEM_RESERVE_EN > 0)
+			// 回调中记录日志、发送消息等申请可以使用应急储备
+			memHEAP_LOCK();
+			xReserveFailDepth++;
+			memHEAP_UNLOCK();
+		#endif
+			if (xMemManage.malloc_fail_cb)
+				xMemManage.malloc_fail_cb(xWantedSize);
+		#if defined(MEM_RESERVE_EN) && (MEM_RESERVE_EN > 0)
+			memHEAP_LOCK();
+			xReserveFailDepth--;
+			memHEAP_UNLOCK();
+		#endif
+		}
+	}
+	else if( ucZeroFill != 0 )
+	{
+		/* zero the memory */
+		memset( pvReturn, 0, xWantedSize - xHeapStructSize );
 	}
 	else
 	{
@@ -238,167 +1054,3025 @@ void *memMalloc( size_t xWantedSize )
 }
 /*-----------------------------------------------------------*/
 
-void memFree( void *pv )
+#if ( !defined(MEM_OOB_META_EN) || (MEM_OOB_META_EN == 0) ) && ( !defined(MEM_TREE_INDEX_EN) || (MEM_TREE_INDEX_EN == 0) )
+
+static BlockLink_t *prvTakeBlockFromFreeList( size_t xWantedSize, uint8_t ucZeroOnly )
 {
-	uint8_t *puc = ( uint8_t * ) pv;
-	BlockLink_t *pxLink;
+	BlockLink_t *pxBlock, *pxBlock_used, *pxPreviousBlock, *pxPreviousBlock_used, *pxNewBlockLink;
+#if defined(TATTER_OPTIME_EN) && (TATTER_OPTIME_EN > 0) && defined(MEM_SEARCH_DEPTH_MAX) && (MEM_SEARCH_DEPTH_MAX > 0)
+	size_t search_depth = 0;  // 尝试查找更优内存块的深度
+#endif
+#if !defined(MEM_ZERO_EN) || (MEM_ZERO_EN == 0)
+	( void ) ucZeroOnly;
+#endif
 
-	if( pv != NULL )
+#if defined(MEM_EXACT_FIT_EN) && (MEM_EXACT_FIT_EN > 0)
+	// 常用尺寸先查精确查找表，命中时不查找也不分隔
+	pxBlock = prvExactTake( xWantedSize );
+	if( pxBlock != NULL )
 	{
-		/* The memory being freed will have an BlockLink_t structure immediately
-		before it. */
-		puc -= xHeapStructSize;
+		return pxBlock;
+	}
+#endif
 
-		/* This casting is to keep the compiler from issuing warnings. */
-		pxLink = ( void * ) puc;
+	/* Traverse the list from the start	(lowest address) block until
+	one	of adequate size is found. */
+	pxPreviousBlock = &xStart;
+	pxBlock = heapGET_NEXT( &xStart );
+	while( !heapBLOCK_FITS( pxBlock, xWantedSize, ucZeroOnly ) && ( heapGET_NEXT( pxBlock ) != NULL ) )
+	{
+		heapCOUNT_NODE();
+		pxPreviousBlock = pxBlock;
+		pxBlock = heapGET_NEXT( pxBlock );
+	}
 
-		/* Check the block is actually allocated. */
-		configASSERT( ( pxLink->xBlockSize & xBlockAllocatedBit ) != 0 );
-		configASSERT( pxLink->pxNextFreeBlock == NULL );
+	/* If the end marker was reached then a block of adequate size
+	was	not found. */
+	if( pxBlock == pxEnd )
+	{
+		return NULL;
+	}
+
+	pxBlock_used = pxBlock;
+	pxPreviousBlock_used = pxPreviousBlock;
+#if defined(TATTER_OPTIME_EN) && (TATTER_OPTIME_EN > 0)
+	// 找到了第一个可用内存块，且很大，需要分隔，真的需要分隔，不再找找
+	if( ( pxBlock->xBlockSize - xWantedSize ) > heapMINIMUM_BLOCK_SIZE ){
+		pxBlock_used = pxBlock;  // 保存可用的pxBlock
+		pxPreviousBlock_used = pxPreviousBlock;
+		// 找下一个更合适的内存块
+		pxPreviousBlock = pxBlock;
+		pxBlock = heapGET_NEXT( pxBlock );
+		while(heapGET_NEXT( pxBlock ) != NULL){
+			heapCOUNT_NODE();
+			if(heapBLOCK_FITS(pxBlock, xWantedSize, ucZeroOnly) \
+				&& ((pxBlock->xBlockSize - xWantedSize) <= heapMINIMUM_BLOCK_SIZE)){
+				// 找到新的更优内存块
+				pxBlock_used = pxBlock;
+				pxPreviousBlock_used = pxPreviousBlock;
+			}
+
+			#if defined(MEM_SEARCH_DEPTH_MAX) && (MEM_SEARCH_DEPTH_MAX > 0)   // 为优化效率考虑的，碎片较多时，查询可能比较耗时，可控制查询深度
+			search_depth++;
+			if(search_depth >= MEM_SEARCH_DEPTH_MAX)
+				break; // 不找了，
+			#endif
+
+			// 下一个内存块
+			pxPreviousBlock = pxBlock;
+			pxBlock = heapGET_NEXT( pxBlock );
+		}
+	}
+#endif
+
+	/* This block is being returned for use so must be taken out
+	of the list of free blocks. */
+	heapSET_NEXT( pxPreviousBlock_used, heapGET_NEXT( pxBlock_used ) );
+	heapEXACT_UNLINK( pxPreviousBlock_used, pxBlock_used );
+	xFreeBlockNum--;
+	heapZERO_FORGET( pxBlock_used );
+	/* If the block is larger than required it can be split into
+	two. */
+	if( ( pxBlock_used->xBlockSize - xWantedSize ) > heapMINIMUM_BLOCK_SIZE )
+	{
+		/* This block is to be split into two.  Create a new
+		block following the number of bytes requested. The void
+		cast is used to prevent byte alignment warnings from the
+		compiler. */
+		pxNewBlockLink = ( void * ) ( ( ( uint8_t * ) pxBlock_used ) + xWantedSize );
+
+		/* Calculate the sizes of two blocks split from the
+		single block. */
+		pxNewBlockLink->xBlockSize = pxBlock_used->xBlockSize - xWantedSize;
+		pxBlock_used->xBlockSize = xWantedSize;
+	#if defined(MEM_ZERO_EN) && (MEM_ZERO_EN > 0)
+		// 分隔出的剩余部分继承原内存块的清零状态
+		heapZERO_MARK( pxNewBlockLink ) = heapIS_ZERO( pxBlock_used ) ? heapZERO_MAGIC : 0;
+	#endif
+		/* Insert the new block into the list of free blocks. */
+		prvInsertBlockIntoFreeList( ( pxNewBlockLink ) );
+	}
+	else
+	{
+        MEM_NO_HANDLE(0); 
+	}
+
+	return pxBlock_used;
+}
+
+#elif defined(MEM_OOB_META_EN) && (MEM_OOB_META_EN > 0)
+
+static BlockLink_t *prvTakeBlockFromFreeList( size_t xWantedSize, uint8_t ucZeroOnly )
+{
+	BlockLink_t *pxBlock;
+	uint16_t usNode, usPrevious, usUsed, usPreviousUsed;
+#if defined(TATTER_OPTIME_EN) && (TATTER_OPTIME_EN > 0) && defined(MEM_SEARCH_DEPTH_MAX) && (MEM_SEARCH_DEPTH_MAX > 0)
+	size_t search_depth = 0;  // 尝试查找更优内存块的深度
+#endif
+
+	( void ) ucZeroOnly;
+
+	// 存活内存块已达上限，再申请就不能保证释放时有节点可用
+	if( ( xOobUsedBlockNum + xRegionNum ) >= MEM_OOB_NODE_NUM )
+	{
+		return NULL;
+	}
+
+	// 与带内链表相同的首次适配，只访问节点数组
+	usPrevious = heapOOB_NIL;
+	usNode = usOobHead;
+	while( ( usNode != heapOOB_NIL ) && ( xOobNodes[ usNode ].ulSize < xWantedSize ) )
+	{
+		heapCOUNT_NODE();
+		usPrevious = usNode;
+		usNode = xOobNodes[ usNode ].usNext;
+	}
+
+	if( usNode == heapOOB_NIL )
+	{
+		return NULL;
+	}
+
+	usUsed = usNode;
+	usPreviousUsed = usPrevious;
+#if defined(TATTER_OPTIME_EN) && (TATTER_OPTIME_EN > 0)
+	// 首次适配的内存块需要分隔时，继续找分隔后剩余不足 heapMINIMUM_BLOCK_SIZE 的更优内存块
+	if( ( xOobNodes[ usNode ].ulSize - xWantedSize ) > heapMINIMUM_BLOCK_SIZE )
+	{
+		usPrevious = usNode;
+		usNode = xOobNodes[ usNode ].usNext;
+		while( usNode != heapOOB_NIL )
+		{
+			heapCOUNT_NODE();
+			if( ( xOobNodes[ usNode ].ulSize >= xWantedSize )
+				&& ( ( xOobNodes[ usNode ].ulSize - xWantedSize ) <= heapMINIMUM_BLOCK_SIZE ) )
+			{
+				usUsed = usNode;
+				usPreviousUsed = usPrevious;
+			}
+
+			#if defined(MEM_SEARCH_DEPTH_MAX) && (MEM_SEARCH_DEPTH_MAX > 0)
+			search_depth++;
+			if( search_depth >= MEM_SEARCH_DEPTH_MAX )
+				break;
+			#endif
+
+			usPrevious = usNode;
+			usNode = xOobNodes[ usNode ].usNext;
+		}
+	}
+#endif
+
+	pxBlock = heapOOB_BLOCK( usUsed );
+	if( ( xOobNodes[ usUsed ].ulSize - xWantedSize ) > heapMINIMUM_BLOCK_SIZE )
+	{
+		// 分隔后剩余部分在高地址，沿用原节点，链表顺序不变
+		xOobNodes[ usUsed ].ulOffset += ( uint32_t ) xWantedSize;
+		xOobNodes[ usUsed ].ulSize -= ( uint32_t ) xWantedSize;
+		heapOOB_BLOCK( usUsed )->xBlockSize = xOobNodes[ usUsed ].ulSize;
+		pxBlock->xBlockSize = xWantedSize;
+	}
+	else
+	{
+		pxBlock->xBlockSize = xOobNodes[ usUsed ].ulSize;
+		if( usPreviousUsed == heapOOB_NIL )
+		{
+			usOobHead = xOobNodes[ usUsed ].usNext;
+		}
+		else
+		{
+			xOobNodes[ usPreviousUsed ].usNext = xOobNodes[ usUsed ].usNext;
+		}
+		xOobNodes[ usUsed ].usNext = usOobPool;
+		usOobPool = usUsed;
+		xFreeBlockNum--;
+	}
+	xOobUsedBlockNum++;
+
+	return pxBlock;
+}
+
+static void prvOobInit( void )
+{
+	size_t xRegion, xNode;
+	uint16_t usTail = heapOOB_NIL;
+
+	for( xNode = 0; xNode < MEM_OOB_NODE_NUM; xNode++ )
+	{
+		xOobNodes[ xNode ].usNext = ( xNode + 1 < MEM_OOB_NODE_NUM ) ? ( uint16_t ) ( xNode + 1 ) : heapOOB_NIL;
+	}
+	usOobPool = 0;
+	usOobHead = heapOOB_NIL;
+	xOobUsedBlockNum = 0;
+	pucOobBase = ( uint8_t * ) xRegionBounds[ 0 ].pxFirstBlock;
+
+	// 偏移和大小用 32 位保存，所有区域须在 4GB 范围内
+	configASSERT( ( ( size_t ) xRegionBounds[ xRegionNum - 1 ].pxEndMarker - ( size_t ) pucOobBase ) <= 0xFFFFFFFFUL );
+
+	for( xRegion = 0; xRegion < xRegionNum; xRegion++ )
+	{
+		xNode = usOobPool;
+		usOobPool = xOobNodes[ xNode ].usNext;
+		xOobNodes[ xNode ].ulOffset = ( uint32_t ) ( ( uint8_t * ) xRegionBounds[ xRegion ].pxFirstBlock - pucOobBase );
+		xOobNodes[ xNode ].ulSize = ( uint32_t ) xRegionBounds[ xRegion ].pxFirstBlock->xBlockSize;
+		xOobNodes[ xNode ].usNext = heapOOB_NIL;
+
+		if( usTail == heapOOB_NIL )
+		{
+			usOobHead = ( uint16_t ) xNode;
+		}
+		else
+		{
+			xOobNodes[ usTail ].usNext = ( uint16_t ) xNode;
+		}
+		usTail = ( uint16_t ) xNode;
+	}
+}
+
+#else
+
+static BlockLink_t *prvTakeBlockFromFreeList( size_t xWantedSize, uint8_t ucZeroOnly )
+{
+	BlockLink_t *pxBlock = NULL, *pxPrevious, *pxNext, *pxNewBlockLink;
+	MemTreeNode_t *pxNode = pxTreeRoot;
+
+	( void ) ucZeroOnly;
+
+	// 找大小不小于 xWantedSize 的最小空闲块，大小相同时取地址最低的
+	while( pxNode != NULL )
+	{
+		heapCOUNT_NODE();
+		if( heapTREE_BLOCK( pxNode )->xBlockSize >= xWantedSize )
+		{
+			pxBlock = heapTREE_BLOCK( pxNode );
+			pxNode = pxNode->pxLeft;
+		}
+		else
+		{
+			pxNode = pxNode->pxRight;
+		}
+	}
+
+	if( pxBlock == NULL )
+	{
+		return NULL;
+	}
+
+	prvTreeRemove( pxBlock );
+	pxPrevious = heapTREE_NODE( pxBlock )->pxPrevFree;
+	pxNext = heapGET_NEXT( pxBlock );
+
+	if( ( pxBlock->xBlockSize - xWantedSize ) > heapMINIMUM_BLOCK_SIZE )
+	{
+		// 分隔后剩余部分在地址链表中占据原内存块的位置，不需要重新查找插入位置
+		pxNewBlockLink = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xWantedSize );
+		pxNewBlockLink->xBlockSize = pxBlock->xBlockSize - xWantedSize;
+		pxBlock->xBlockSize = xWantedSize;
+
+		heapSET_NEXT( pxNewBlockLink, pxNext );
+		heapSET_NEXT( pxPrevious, pxNewBlockLink );
+		heapTREE_LINK( pxPrevious, pxNewBlockLink );
+	}
+	else
+	{
+		heapSET_NEXT( pxPrevious, pxNext );
+		if( pxNext->xBlockSize != 0 )
+		{
+			heapTREE_NODE( pxNext )->pxPrevFree = pxPrevious;
+		}
+		xFreeBlockNum--;
+	}
+
+	return pxBlock;
+}
+
+static void prvTreeReplaceChild( MemTreeNode_t *pxParent, MemTreeNode_t *pxOld, MemTreeNode_t *pxNew )
+{
+	if( pxParent == NULL )
+	{
+		pxTreeRoot = pxNew;
+	}
+	else if( pxParent->pxLeft == pxOld )
+	{
+		pxParent->pxLeft = pxNew;
+	}
+	else
+	{
+		pxParent->pxRight = pxNew;
+	}
+}
+
+static void prvTreeRotateLeft( MemTreeNode_t *pxNode )
+{
+	MemTreeNode_t *pxChild = pxNode->pxRight;
+
+	pxNode->pxRight = pxChild->pxLeft;
+	if( pxChild->pxLeft != NULL )
+	{
+		heapTREE_SET_PARENT( pxChild->pxLeft, pxNode );
+	}
+	heapTREE_SET_PARENT( pxChild, heapTREE_PARENT( pxNode ) );
+	prvTreeReplaceChild( heapTREE_PARENT( pxNode ), pxNode, pxChild );
+	pxChild->pxLeft = pxNode;
+	heapTREE_SET_PARENT( pxNode, pxChild );
+}
+
+static void prvTreeRotateRight( MemTreeNode_t *pxNode )
+{
+	MemTreeNode_t *pxChild = pxNode->pxLeft;
+
+	pxNode->pxLeft = pxChild->pxRight;
+	if( pxChild->pxRight != NULL )
+	{
+		heapTREE_SET_PARENT( pxChild->pxRight, pxNode );
+	}
+	heapTREE_SET_PARENT( pxChild, heapTREE_PARENT( pxNode ) );
+	prvTreeReplaceChild( heapTREE_PARENT( pxNode ), pxNode, pxChild );
+	pxChild->pxRight = pxNode;
+	heapTREE_SET_PARENT( pxNode, pxChild );
+}
+
+static void prvTreeInsert( BlockLink_t *pxBlock )
+{
+	MemTreeNode_t *pxNode = heapTREE_NODE( pxBlock ), *pxParent = NULL, *pxGrand, *pxUncle, **ppxLink = &pxTreeRoot;
+	size_t xSize = pxBlock->xBlockSize;
+
+	// 按 (大小, 地址) 找到插入位置，地址不会重复
+	while( *ppxLink != NULL )
+	{
+		heapCOUNT_NODE();
+		pxParent = *ppxLink;
+		if( ( xSize < heapTREE_BLOCK( pxParent )->xBlockSize )
+			|| ( ( xSize == heapTREE_BLOCK( pxParent )->xBlockSize ) && ( pxNode < pxParent ) ) )
+		{
+			ppxLink = &( pxParent->pxLeft );
+		}
+		else
+		{
+			ppxLink = &( pxParent->pxRight );
+		}
+	}
+
+	pxNode->pxLeft = NULL;
+	pxNode->pxRight = NULL;
+	pxNode->xParentColor = ( size_t ) pxParent | heapTREE_RED;
+	*ppxLink = pxNode;
+
+	// 父节点为红色时重新着色或旋转
+	while( heapTREE_IS_RED( heapTREE_PARENT( pxNode ) ) )
+	{
+		pxParent = heapTREE_PARENT( pxNode );
+		pxGrand = heapTREE_PARENT( pxParent );
+		if( pxParent == pxGrand->pxLeft )
+		{
+			pxUncle = pxGrand->pxRight;
+			if( heapTREE_IS_RED( pxUncle ) )
+			{
+				heapTREE_SET_BLACK( pxParent );
+				heapTREE_SET_BLACK( pxUncle );
+				heapTREE_SET_RED( pxGrand );
+				pxNode = pxGrand;
+				continue;
+			}
+			if( pxNode == pxParent->pxRight )
+			{
+				prvTreeRotateLeft( pxParent );
+				pxNode = pxParent;
+				pxParent = heapTREE_PARENT( pxNode );
+			}
+			heapTREE_SET_BLACK( pxParent );
+			heapTREE_SET_RED( pxGrand );
+			prvTreeRotateRight( pxGrand );
+		}
+		else
+		{
+			pxUncle = pxGrand->pxLeft;
+			if( heapTREE_IS_RED( pxUncle ) )
+			{
+				heapTREE_SET_BLACK( pxParent );
+				heapTREE_SET_BLACK( pxUncle );
+				heapTREE_SET_RED( pxGrand );
+				pxNode = pxGrand;
+				continue;
+			}
+			if( pxNode == pxParent->pxLeft )
+			{
+				prvTreeRotateRight( pxParent );
+				pxNode = pxParent;
+				pxParent = heapTREE_PARENT( pxNode );
+			}
+			heapTREE_SET_BLACK( pxParent );
+			heapTREE_SET_RED( pxGrand );
+			prvTreeRotateLeft( pxGrand );
+		}
+	}
+	heapTREE_SET_BLACK( pxTreeRoot );
+}
+
+static void prvTreeRemove( BlockLink_t *pxBlock )
+{
+	MemTreeNode_t *pxNode = heapTREE_NODE( pxBlock ), *pxChild, *pxParent, *pxNext, *pxSibling;
+	uint8_t ucRemovedRed;
+
+	if( pxNode->pxLeft == NULL )
+	{
+		pxChild = pxNode->pxRight;
+		pxParent = heapTREE_PARENT( pxNode );
+		ucRemovedRed = heapTREE_IS_RED( pxNode );
+		prvTreeReplaceChild( pxParent, pxNode, pxChild );
+		if( pxChild != NULL )
+		{
+			heapTREE_SET_PARENT( pxChild, pxParent );
+		}
+	}
+	else if( pxNode->pxRight == NULL )
+	{
+		pxChild = pxNode->pxLeft;
+		pxParent = heapTREE_PARENT( pxNode );
+		ucRemovedRed = heapTREE_IS_RED( pxNode );
+		prvTreeReplaceChild( pxParent, pxNode, pxChild );
+		heapTREE_SET_PARENT( pxChild, pxParent );
+	}
+	else
+	{
+		// 有两个子节点时由右子树中的最小节点接替其位置
+		pxNext = pxNode->pxRight;
+		while( pxNext->pxLeft != NULL )
+		{
+			pxNext = pxNext->pxLeft;
+		}
+		ucRemovedRed = heapTREE_IS_RED( pxNext );
+		pxChild = pxNext->pxRight;
+		if( heapTREE_PARENT( pxNext ) == pxNode )
+		{
+			pxParent = pxNext;
+		}
+		else
+		{
+			pxParent = heapTREE_PARENT( pxNext );
+			pxParent->pxLeft = pxChild;
+			if( pxChild != NULL )
+			{
+				heapTREE_SET_PARENT( pxChild, pxParent );
+			}
+			pxNext->pxRight = pxNode->pxRight;
+			heapTREE_SET_PARENT( pxNext->pxRight, pxNext );
+		}
+		prvTreeReplaceChild( heapTREE_PARENT( pxNode ), pxNode, pxNext );
+		pxNext->xParentColor = pxNode->xParentColor;
+		pxNext->pxLeft = pxNode->pxLeft;
+		heapTREE_SET_PARENT( pxNext->pxLeft, pxNext );
+	}
+
+	if( ucRemovedRed != 0 )
+	{
+		return;
+	}
+
+	// 删除了黑色节点，从 pxChild 向上补足黑高
+	while( ( pxChild != pxTreeRoot ) && !heapTREE_IS_RED( pxChild ) )
+	{
+		if( pxChild == pxParent->pxLeft )
+		{
+			pxSibling = pxParent->pxRight;
+			if( heapTREE_IS_RED( pxSibling ) )
+			{
+				heapTREE_SET_BLACK( pxSibling );
+				heapTREE_SET_RED( pxParent );
+				prvTreeRotateLeft( pxParent );
+				pxSibling = pxParent->pxRight;
+			}
+			if( !heapTREE_IS_RED( pxSibling->pxLeft ) && !heapTREE_IS_RED( pxSibling->pxRight ) )
+			{
+				heapTREE_SET_RED( pxSibling );
+				pxChild = pxParent;
+				pxParent = heapTREE_PARENT( pxChild );
+			}
+			else
+			{
+				if( !heapTREE_IS_RED( pxSibling->pxRight ) )
+				{
+					heapTREE_SET_BLACK( pxSibling->pxLeft );
+					heapTREE_SET_RED( pxSibling );
+					prvTreeRotateRight( pxSibling );
+					pxSibling = pxParent->pxRight;
+				}
+				pxSibling->xParentColor = ( pxSibling->xParentColor & ~heapTREE_RED ) | ( pxParent->xParentColor & heapTREE_RED );
+				heapTREE_SET_BLACK( pxParent );
+				heapTREE_SET_BLACK( pxSibling->pxRight );
+				prvTreeRotateLeft( pxParent );
+				pxChild = pxTreeRoot;
+			}
+		}
+		else
+		{
+			pxSibling = pxParent->pxLeft;
+			if( heapTREE_IS_RED( pxSibling ) )
+			{
+				heapTREE_SET_BLACK( pxSibling );
+				heapTREE_SET_RED( pxParent );
+				prvTreeRotateRight( pxParent );
+				pxSibling = pxParent->pxLeft;
+			}
+			if( !heapTREE_IS_RED( pxSibling->pxLeft ) && !heapTREE_IS_RED( pxSibling->pxRight ) )
+			{
+				heapTREE_SET_RED( pxSibling );
+				pxChild = pxParent;
+				pxParent = heapTREE_PARENT( pxChild );
+			}
+			else
+			{
+				if( !heapTREE_IS_RED( pxSibling->pxLeft ) )
+				{
+					heapTREE_SET_BLACK( pxSibling->pxRight );
+					heapTREE_SET_RED( pxSibling );
+					prvTreeRotateLeft( pxSibling );
+					pxSibling = pxParent->pxLeft;
+				}
+				pxSibling->xParentColor = ( pxSibling->xParentColor & ~heapTREE_RED ) | ( pxParent->xParentColor & heapTREE_RED );
+				heapTREE_SET_BLACK( pxParent );
+				heapTREE_SET_BLACK( pxSibling->pxLeft );
+				prvTreeRotateRight( pxParent );
+				pxChild = pxTreeRoot;
+			}
+		}
+	}
+	if( pxChild != NULL )
+	{
+		heapTREE_SET_BLACK( pxChild );
+	}
+}
+
+static void prvTreeLink( BlockLink_t *pxPrevious, BlockLink_t *pxBlock )
+{
+	BlockLink_t *pxNext = heapGET_NEXT( pxBlock );
+
+	if( pxPrevious != pxBlock )
+	{
+		heapTREE_NODE( pxBlock )->pxPrevFree = pxPrevious;
+	}
+	// 各区域的结束标记没有树节点
+	if( pxNext->xBlockSize != 0 )
+	{
+		heapTREE_NODE( pxNext )->pxPrevFree = pxBlock;
+	}
+	prvTreeInsert( pxBlock );
+}
+
+static void prvTreeInit( void )
+{
+	BlockLink_t *pxPrevious = &xStart, *pxBlock;
+
+	pxTreeRoot = NULL;
+	for( pxBlock = heapGET_NEXT( &xStart ); pxBlock != NULL; pxBlock = heapGET_NEXT( pxBlock ) )
+	{
+		if( pxBlock->xBlockSize != 0 )
+		{
+			heapTREE_NODE( pxBlock )->pxPrevFree = pxPrevious;
+			prvTreeInsert( pxBlock );
+		}
+		pxPrevious = pxBlock;
+	}
+}
+
+#endif
+
+#if defined(MEM_EXACT_FIT_EN) && (MEM_EXACT_FIT_EN > 0)
+
+static MemExactSlot_t *prvExactSlot( size_t xBlockSize )
+{
+	// 乘法散列取高位，避免 2 的幂次尺寸集中到同一个槽
+	uint32_t ulHash = ( uint32_t ) ( xBlockSize / memBYTE_ALIGNMENT ) * 0x9E3779B1UL;
+
+	return &xExactSlots[ ( ulHash >> 16 ) % MEM_EXACT_SLOT_NUM ];
+}
+
+static BlockLink_t *prvExactTake( size_t xWantedSize )
+{
+	MemExactSlot_t *pxSlot = prvExactSlot( xWantedSize );
+	BlockLink_t *pxBlock, *pxPrevious;
+
+	if( pxSlot->xCandidate == xWantedSize )
+	{
+		if( pxSlot->ulVotes < 0xFFFFFFFFUL )
+		{
+			pxSlot->ulVotes++;
+		}
+	}
+	else if( pxSlot->ulVotes > 0 )
+	{
+		pxSlot->ulVotes--;
+	}
+	else
+	{
+		pxSlot->xCandidate = xWantedSize;
+		pxSlot->ulVotes = 1;
+	}
+
+	if( ( pxSlot->xBlockSize != xWantedSize ) || ( pxSlot->pxHead == NULL ) )
+	{
+		return NULL;
+	}
+
+	pxBlock = pxSlot->pxHead;
+	pxPrevious = heapEXACT_META( pxBlock )->pxPrevFree;
+	heapSET_NEXT( pxPrevious, heapGET_NEXT( pxBlock ) );
+	prvExactUnlink( pxPrevious, pxBlock );
+	xFreeBlockNum--;
+	pxSlot->ulHits++;
+
+	return pxBlock;
+}
+
+static void prvExactRemove( BlockLink_t *pxBlock )
+{
+	MemExactSlot_t *pxSlot = prvExactSlot( pxBlock->xBlockSize );
+	MemExactLink_t *pxLink = heapEXACT_META( pxBlock );
+
+	if( pxSlot->xBlockSize != pxBlock->xBlockSize )
+	{
+		return;
+	}
+
+	if( pxLink->pxExactPrev == NULL )
+	{
+		pxSlot->pxHead = pxLink->pxExactNext;
+	}
+	else
+	{
+		heapEXACT_META( pxLink->pxExactPrev )->pxExactNext = pxLink->pxExactNext;
+	}
+	if( pxLink->pxExactNext != NULL )
+	{
+		heapEXACT_META( pxLink->pxExactNext )->pxExactPrev = pxLink->pxExactPrev;
+	}
+	pxSlot->xFreeNum--;
+}
+
+static void prvExactPush( MemExactSlot_t *pxSlot, BlockLink_t *pxBlock )
+{
+	MemExactLink_t *pxLink = heapEXACT_META( pxBlock );
+
+	pxLink->pxExactPrev = NULL;
+	pxLink->pxExactNext = pxSlot->pxHead;
+	if( pxSlot->pxHead != NULL )
+	{
+		heapEXACT_META( pxSlot->pxHead )->pxExactPrev = pxBlock;
+	}
+	pxSlot->pxHead = pxBlock;
+	pxSlot->xFreeNum++;
+}
+
+static void prvExactLink( BlockLink_t *pxPrevious, BlockLink_t *pxBlock )
+{
+	BlockLink_t *pxNext = heapGET_NEXT( pxBlock );
+	MemExactSlot_t *pxSlot = prvExactSlot( pxBlock->xBlockSize );
+
+	if( pxPrevious != pxBlock )
+	{
+		heapEXACT_META( pxBlock )->pxPrevFree = pxPrevious;
+	}
+	// 各区域的结束标记没有用户区
+	if( pxNext->xBlockSize != 0 )
+	{
+		heapEXACT_META( pxNext )->pxPrevFree = pxBlock;
+	}
+	if( pxSlot->xBlockSize == pxBlock->xBlockSize )
+	{
+		prvExactPush( pxSlot, pxBlock );
+	}
+}
+
+static void prvExactUnlink( BlockLink_t *pxPrevious, BlockLink_t *pxBlock )
+{
+	BlockLink_t *pxNext = heapGET_NEXT( pxBlock );
+
+	prvExactRemove( pxBlock );
+	if( pxNext->xBlockSize != 0 )
+	{
+		heapEXACT_META( pxNext )->pxPrevFree = pxPrevious;
+	}
+}
+
+// 按地址链表收集大小为 xBlockSize 的空闲块，xBlockSize 为 0 时只重建 pxPrevFree
+static void prvExactRebuild( MemExactSlot_t *pxSlot, size_t xBlockSize )
+{
+	BlockLink_t *pxPrevious = &xStart, *pxBlock;
+
+	for( pxBlock = heapGET_NEXT( &xStart ); pxBlock != NULL; pxBlock = heapGET_NEXT( pxBlock ) )
+	{
+		if( pxBlock->xBlockSize != 0 )
+		{
+			heapEXACT_META( pxBlock )->pxPrevFree = pxPrevious;
+			if( pxBlock->xBlockSize == xBlockSize )
+			{
+				prvExactPush( pxSlot, pxBlock );
+			}
+		}
+		pxPrevious = pxBlock;
+	}
+}
+
+// 槽改为跟踪 xBlockSize，原大小的空闲块只留在地址链表中
+static void prvExactRetune( MemExactSlot_t *pxSlot, size_t xBlockSize )
+{
+	pxSlot->xBlockSize = xBlockSize;
+	pxSlot->pxHead = NULL;
+	pxSlot->xFreeNum = 0;
+	pxSlot->ulHits = 0;
+	if( ( xBlockSize != 0 ) && ( pxEnd != NULL ) )
+	{
+		prvExactRebuild( pxSlot, xBlockSize );
+	}
+}
+
+// 申请字节数换算为内存块大小，不能被跟踪时返回 0
+static size_t prvExactBlockSize( size_t xSize )
+{
+	size_t xBlockSize;
+
+	if( ( xSize == 0 ) || ( xSize > ( ( ( size_t ) -1 ) >> 2 ) ) )
+	{
+		return 0;
+	}
+
+	xBlockSize = ( xSize + xHeapStructSize + memBYTE_ALIGNMENT_MASK ) & ~( ( size_t ) memBYTE_ALIGNMENT_MASK );
+
+	// 双向链表保存在空闲块的用户区中
+	return ( xBlockSize >= ( xHeapStructSize + xExactLinkSize ) ) ? xBlockSize : 0;
+}
+
+static void prvExactInit( void )
+{
+	size_t xSlot;
+#if defined(MEM_EXACT_SIZES)
+	size_t xBlockSize;
+
+	if( ucExactDefaultsLoaded == 0 )
+	{
+		ucExactDefaultsLoaded = 1;
+		for( xSlot = 0; xSlot < ( sizeof( xExactDefaultSizes ) / sizeof( xExactDefaultSizes[ 0 ] ) ); xSlot++ )
+		{
+			xBlockSize = prvExactBlockSize( xExactDefaultSizes[ xSlot ] );
+			if( xBlockSize != 0 )
+			{
+				prvExactSlot( xBlockSize )->xBlockSize = xBlockSize;
+			}
+		}
+	}
+#endif
+
+	// 跟踪的大小在重新初始化后保留，重新收集空闲块
+	prvExactRebuild( NULL, 0 );
+	for( xSlot = 0; xSlot < MEM_EXACT_SLOT_NUM; xSlot++ )
+	{
+		prvExactRetune( &xExactSlots[ xSlot ], xExactSlots[ xSlot ].xBlockSize );
+	}
+}
+
+int memExactFitSetSize( size_t xSize )
+{
+	size_t xBlockSize = prvExactBlockSize( xSize );
+	MemExactSlot_t *pxSlot;
+
+	if( xBlockSize == 0 )
+	{
+		return -1;
+	}
+
+	memHEAP_LOCK();
+	{
+		pxSlot = prvExactSlot( xBlockSize );
+		if( pxSlot->xBlockSize != xBlockSize )
+		{
+			prvExactRetune( pxSlot, xBlockSize );
+		}
+	}
+	memHEAP_UNLOCK();
+
+	return 0;
+}
+
+void memExactFitClear( void )
+{
+	size_t xSlot;
+
+	memHEAP_LOCK();
+	{
+		for( xSlot = 0; xSlot < MEM_EXACT_SLOT_NUM; xSlot++ )
+		{
+			prvExactRetune( &xExactSlots[ xSlot ], 0 );
+			xExactSlots[ xSlot ].xCandidate = 0;
+			xExactSlots[ xSlot ].ulVotes = 0;
+		}
+	#if defined(MEM_EXACT_SIZES)
+		ucExactDefaultsLoaded = 1;
+	#endif
+	}
+	memHEAP_UNLOCK();
+}
+
+size_t memExactFitLearn( void )
+{
+	MemExactSlot_t *pxSlot;
+	size_t xSlot, xRetuned = 0;
+
+	memHEAP_LOCK();
+	{
+		for( xSlot = 0; xSlot < MEM_EXACT_SLOT_NUM; xSlot++ )
+		{
+			pxSlot = &xExactSlots[ xSlot ];
+			if( ( pxSlot->xCandidate != pxSlot->xBlockSize ) && ( pxSlot->ulVotes >= MEM_EXACT_LEARN_VOTES )
+				&& ( pxSlot->xCandidate >= ( xHeapStructSize + xExactLinkSize ) ) )
+			{
+				prvExactRetune( pxSlot, pxSlot->xCandidate );
+				xRetuned++;
+			}
+		}
+	}
+	memHEAP_UNLOCK();
+
+	return xRetuned;
+}
+
+int memExactFitGetSlot( size_t xSlot, MemExactSlotInfo_t *pxInfo )
+{
+	MemExactSlot_t *pxSlot;
+
+	if( ( xSlot >= MEM_EXACT_SLOT_NUM ) || ( pxInfo == NULL ) )
+	{
+		return -1;
+	}
+
+	memHEAP_LOCK();
+	{
+		pxSlot = &xExactSlots[ xSlot ];
+		pxInfo->xSize = ( pxSlot->xBlockSize != 0 ) ? ( pxSlot->xBlockSize - xHeapStructSize ) : 0;
+		pxInfo->xFreeNum = pxSlot->xFreeNum;
+		pxInfo->ulHits = pxSlot->ulHits;
+		pxInfo->xCandidate = ( pxSlot->xCandidate != 0 ) ? ( pxSlot->xCandidate - xHeapStructSize ) : 0;
+		pxInfo->ulVotes = pxSlot->ulVotes;
+	}
+	memHEAP_UNLOCK();
+
+	return 0;
+}
+
+#endif
+/*-----------------------------------------------------------*/
+
+void memFree( void *pv )
+{
+	MemAllocCall_t xCall;
+
+	xCall.ucTraceOp = MEM_TRACE_OP_FREE;
+	xCall.xCaller = MEM_TRACE_CALLER();
+	xCall.ucTag = MEM_TAG_DEFAULT;
+	xCall.ucFlags = 0;
+
+	prvFree( pv, &xCall );
+}
+/*-----------------------------------------------------------*/
+
+static void prvFree( void *pv, const MemAllocCall_t *pxCall )
+{
+	uint8_t *puc = ( uint8_t * ) pv;
+	BlockLink_t *pxLink;
+#if defined(MEM_WAIT_EN) && (MEM_WAIT_EN > 0)
+	size_t xFreeSize;
+#endif
+#if defined(MEM_LATENCY_STAT_EN) && (MEM_LATENCY_STAT_EN > 0)
+	uint32_t ulStartCycle;
+#endif
+#if defined(MEM_TRACE_EN) && (MEM_TRACE_EN > 0)
+	size_t xTraceArg;
+#else
+	( void ) pxCall;
+#endif
+
+	if( pv != NULL )
+	{
+		/* The memory being freed will have an BlockLink_t structure immediately
+		before it. */
+		puc -= xHeapStructSize;
+
+		/* This casting is to keep the compiler from issuing warnings. */
+		pxLink = ( void * ) puc;
+
+		/* Check the block is actually allocated. */
+		configASSERT( ( pxLink->xBlockSize & xBlockAllocatedBit ) != 0 );
+		configASSERT( heapGET_NEXT( pxLink ) == NULL );
+
+		if( ( pxLink->xBlockSize & xBlockAllocatedBit ) != 0 )
+		{
+			if( heapGET_NEXT( pxLink ) == NULL )
+			{
+				memHEAP_LOCK();
+				{
+				#if defined(MEM_LATENCY_STAT_EN) && (MEM_LATENCY_STAT_EN > 0)
+					xNodesVisited = 0;
+					ulStartCycle = MEM_CYCLE_COUNTER();
+				#endif
+					heapPERSIST_TOUCH();
+					heapCHECK_TOUCH();
+					xFreeBytesRemaining += ( pxLink->xBlockSize & ~heapBLOCK_FLAGS );
+					heapZERO_CLEAR( pxLink );
+
+				#if defined(MEM_TAG_EN) && (MEM_TAG_EN > 0)
+					prvTagRemove( pxLink );
+				#endif
+
+				#if defined(MEM_PROFILE_EN) && (MEM_PROFILE_EN > 0)
+					prvProfileRemove( pv );
+				#endif
+
+				#if defined(MEM_WAIT_EN) && (MEM_WAIT_EN > 0)
+					xFreeSize = pxLink->xBlockSize & ~heapBLOCK_FLAGS;
+				#endif
+
+				#if defined(MEM_QUICK_FIT_EN) && (MEM_QUICK_FIT_EN > 0)
+					// 小内存块先缓存到快速链表，不合并；有任务在等待内存时直接合并，尽快凑出大的空闲块
+					if( heapWAIT_PENDING() || ( prvQuickListPut( pxLink ) == 0 ) )
+				#endif
+					{
+						/* The block is being returned to the heap - it is no longer
+						allocated. */
+						pxLink->xBlockSize &= ~xBlockAllocatedBit;
+
+					#if defined(MEM_HOSTED_MMAP_EN) && (MEM_HOSTED_MMAP_EN > 0)
+						puc = ( uint8_t * ) pxLink + pxLink->xBlockSize;
+						prvHostedReleasePages( prvInsertBlockIntoFreeList( pxLink ), ( uint8_t * ) pxLink, puc );
+					#elif defined(MEM_WAIT_EN) && (MEM_WAIT_EN > 0)
+						// 按合并后的空闲块大小唤醒等待的任务
+						xFreeSize = prvInsertBlockIntoFreeList( pxLink )->xBlockSize;
+					#else
+						/* Add this block to the list of free blocks. */
+						prvInsertBlockIntoFreeList( ( ( BlockLink_t * ) pxLink ) );
+					#endif
+					}
+				#if defined(MEM_WAIT_EN) && (MEM_WAIT_EN > 0)
+					// 有任务在等待时释放的内存先留给它们，储备等之后的释放再补足
+					if( pxWaitList != NULL )
+					{
+						prvWaitWake( xFreeSize );
+					}
+					else
+				#endif
+					{
+						heapRESERVE_REFILL();
+					}
+
+				#if defined(MEM_LATENCY_STAT_EN) && (MEM_LATENCY_STAT_EN > 0)
+					prvLatencyRecord( &xLatencyStat.xFree, MEM_CYCLE_COUNTER() - ulStartCycle, xNodesVisited );
+				#endif
+
+				#if defined(MEM_TRACE_EN) && (MEM_TRACE_EN > 0)
+					if( pxCall->ucTraceOp != MEM_TRACE_OP_NONE )
+					{
+						xTraceArg = heapTRACE_OFFSET( pv );
+						prvTraceRecord( pxCall->ucTraceOp, heapTRACE_CALLER( pxCall->xCaller ), &xTraceArg, 1 );
+					}
+				#endif
+				}
+				memHEAP_UNLOCK();
+			}
+			else
+			{
+				MEM_NO_HANDLE(0);
+			}
+		}
+		else
+		{
+			MEM_NO_HANDLE(0);
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+#if defined(MEM_QUICK_FIT_EN) && (MEM_QUICK_FIT_EN > 0)
+
+#if defined(MEM_QUICK_ADAPT_EN) && (MEM_QUICK_ADAPT_EN > 0)
+
+// 超出直方图范围时返回 heapQUICK_BUCKET_NUM
+static size_t prvQuickBucket( size_t xBlockSize )
+{
+	size_t xBucket;
+
+	if( xBlockSize <= xHeapStructSize )
+	{
+		return heapQUICK_BUCKET_NUM;
+	}
+
+	xBucket = ( ( xBlockSize - xHeapStructSize ) / memBYTE_ALIGNMENT ) - 1;
+	return ( xBucket < heapQUICK_BUCKET_NUM ) ? xBucket : heapQUICK_BUCKET_NUM;
+}
+
+static void prvQuickCount( size_t xWantedSize )
+{
+	size_t xBucket = prvQuickBucket( xWantedSize );
+
+	if( ( xBucket < heapQUICK_BUCKET_NUM ) && ( ulQuickHist[ xBucket ] != 0xFFFFFFFFUL ) )
+	{
+		ulQuickHist[ xBucket ]++;
+	}
+	ulQuickSamples++;
+}
+
+// 第 i 条链表先缓存用户区大小为 (i + 1) * memBYTE_ALIGNMENT 的内存块，与未打开自适应时相同
+static void prvQuickAdaptInit( void )
+{
+	size_t xBucket;
+
+	for( xBucket = 0; xBucket < heapQUICK_BUCKET_NUM; xBucket++ )
+	{
+		ucQuickListOf[ xBucket ] = ( uint8_t ) ( ( xBucket < MEM_QUICK_LIST_NUM ) ? xBucket : MEM_QUICK_LIST_NUM );
+		ulQuickHist[ xBucket ] = 0;
+	}
+	for( xBucket = 0; xBucket < MEM_QUICK_LIST_NUM; xBucket++ )
+	{
+		xQuickListBucket[ xBucket ] = xBucket;
+	}
+	ulQuickSamples = 0;
+}
+
+// 返回缓存 xBlockSize 大小内存块的链表序号，没有时返回 MEM_QUICK_LIST_NUM
+static size_t prvQuickListIndex( size_t xBlockSize )
+{
+	size_t xBucket = prvQuickBucket( xBlockSize );
+
+	return ( xBucket < heapQUICK_BUCKET_NUM ) ? ucQuickListOf[ xBucket ] : MEM_QUICK_LIST_NUM;
+}
+
+#else
+
+// 第 i 条快速链表缓存用户区大小为 (i + 1) * memBYTE_ALIGNMENT 的内存块
+static size_t prvQuickListIndex( size_t xBlockSize )
+{
+	if( xBlockSize <= xHeapStructSize )
+	{
+		return MEM_QUICK_LIST_NUM;
+	}
+
+	return ( ( xBlockSize - xHeapStructSize ) / memBYTE_ALIGNMENT ) - 1;
+}
+
+#endif
+
+static BlockLink_t *prvQuickListTake( size_t xWantedSize )
+{
+	BlockLink_t *pxBlock;
+	size_t xIndex = prvQuickListIndex( xWantedSize );
+
+	if( ( xIndex >= MEM_QUICK_LIST_NUM ) || ( xQuickListLen[ xIndex ] == 0 ) )
+	{
+		return NULL;
+	}
+
+	pxBlock = pxQuickList[ xIndex ];
+	xQuickListLen[ xIndex ]--;
+	pxQuickList[ xIndex ] = ( xQuickListLen[ xIndex ] > 0 ) ? heapGET_NEXT( pxBlock ) : NULL;
+
+	// 回到调用者手中时按未分配的内存块处理，与空闲链表取出的内存块一致
+	pxBlock->xBlockSize &= ~xBlockAllocatedBit;
+	return pxBlock;
+}
+
+// 缓存成功返回 1，尺寸不在快速链表范围内返回 0
+static int prvQuickListPut( BlockLink_t *pxLink )
+{
+	size_t xIndex = prvQuickListIndex( pxLink->xBlockSize & ~heapBLOCK_FLAGS );
+
+	if( xIndex >= MEM_QUICK_LIST_NUM )
+	{
+		return 0;
+	}
+
+	// 链表已满，先把整条链表合并回空闲链表
+	if( xQuickListLen[ xIndex ] >= MEM_QUICK_LIST_DEPTH )
+	{
+		( void ) prvQuickListFlush( xIndex );
+	}
+
+	heapSET_NEXT( pxLink, ( xQuickListLen[ xIndex ] > 0 ) ? pxQuickList[ xIndex ] : pxEnd );
+	pxQuickList[ xIndex ] = pxLink;
+	xQuickListLen[ xIndex ]++;
+	return 1;
+}
+
+// 返回合并回空闲链表的内存块个数
+static size_t prvQuickListFlush( size_t xIndex )
+{
+	BlockLink_t *pxBlock;
+	size_t xNum = xQuickListLen[ xIndex ];
+
+	while( xQuickListLen[ xIndex ] > 0 )
+	{
+		pxBlock = pxQuickList[ xIndex ];
+		pxQuickList[ xIndex ] = heapGET_NEXT( pxBlock );
+		xQuickListLen[ xIndex ]--;
+
+		pxBlock->xBlockSize &= ~xBlockAllocatedBit;
+		prvInsertBlockIntoFreeList( pxBlock );
+	}
+	pxQuickList[ xIndex ] = NULL;
+
+	return xNum;
+}
+
+static size_t prvQuickListFlushAll( void )
+{
+	size_t xIndex, xNum = 0;
+
+	for( xIndex = 0; xIndex < MEM_QUICK_LIST_NUM; xIndex++ )
+	{
+		xNum += prvQuickListFlush( xIndex );
+	}
+
+	return xNum;
+}
+
+	#if defined(MEM_QUICK_ADAPT_EN) && (MEM_QUICK_ADAPT_EN > 0)
+
+size_t memQuickListRebalance( void )
+{
+	uint8_t ucChosen[ heapQUICK_BUCKET_NUM ];
+	size_t xIndex, xBucket, xBest, xAssigned = 0;
+
+	memHEAP_LOCK();
+	{
+		// 自上次调整后没有申请时保持原分配
+		if( ulQuickSamples != 0 )
+		{
+			// 选出申请次数最多的 MEM_QUICK_LIST_NUM 个尺寸，次数为 0 的尺寸不分配链表
+			memset( ucChosen, 0, sizeof( ucChosen ) );
+			for( xIndex = 0; xIndex < MEM_QUICK_LIST_NUM; xIndex++ )
+			{
+				xBest = heapQUICK_BUCKET_NUM;
+				for( xBucket = 0; xBucket < heapQUICK_BUCKET_NUM; xBucket++ )
+				{
+					if( ( ucChosen[ xBucket ] == 0 ) && ( ulQuickHist[ xBucket ] > 0 )
+						&& ( ( xBest == heapQUICK_BUCKET_NUM ) || ( ulQuickHist[ xBucket ] > ulQuickHist[ xBest ] ) ) )
+					{
+						xBest = xBucket;
+					}
+				}
+				if( xBest == heapQUICK_BUCKET_NUM )
+				{
+					break;
+				}
+				ucChosen[ xBest ] = 1;
+			}
+
+			// 仍被选中的链表保留已缓存的内存块，其余链表合并回空闲链表后空出
+			for( xIndex = 0; xIndex < MEM_QUICK_LIST_NUM; xIndex++ )
+			{
+				xBucket = xQuickListBucket[ xIndex ];
+				if( ( xBucket < heapQUICK_BUCKET_NUM ) && ( ucChosen[ xBucket ] != 0 ) )
+				{
+					ucChosen[ xBucket ] = 0;
+				}
+				else
+				{
+					( void ) prvQuickListFlush( xIndex );
+					if( xBucket < heapQUICK_BUCKET_NUM )
+					{
+						ucQuickListOf[ xBucket ] = MEM_QUICK_LIST_NUM;
+					}
+					xQuickListBucket[ xIndex ] = heapQUICK_BUCKET_NUM;
+				}
+			}
+
+			// 新选中的尺寸依次分配到空出的链表，选中的尺寸不超过链表条数，一定能分到
+			xIndex = 0;
+			for( xBucket = 0; xBucket < heapQUICK_BUCKET_NUM; xBucket++ )
+			{
+				if( ucChosen[ xBucket ] != 0 )
+				{
+					while( xQuickListBucket[ xIndex ] < heapQUICK_BUCKET_NUM )
+					{
+						xIndex++;
+					}
+					xQuickListBucket[ xIndex ] = xBucket;
+					ucQuickListOf[ xBucket ] = ( uint8_t ) xIndex;
+					xAssigned++;
+				}
+				ulQuickHist[ xBucket ] >>= 1;
+			}
+			ulQuickSamples = 0;
+			heapCHECK_TOUCH();
+		}
+	}
+	memHEAP_UNLOCK();
+
+	return xAssigned;
+}
+
+size_t memQuickListGetSize( size_t xIndex )
+{
+	if( ( xIndex >= MEM_QUICK_LIST_NUM ) || ( xQuickListBucket[ xIndex ] >= heapQUICK_BUCKET_NUM ) )
+	{
+		return 0;
+	}
+
+	return ( xQuickListBucket[ xIndex ] + 1 ) * memBYTE_ALIGNMENT;
+}
+
+	#endif
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if defined(MEM_RESERVE_EN) && (MEM_RESERVE_EN > 0)
+
+// 在临界区内调用，从空闲链表中预留一整块储备，成功后原储备剩余的部分归还空闲链表
+static void prvReserveFill( void )
+{
+	BlockLink_t *pxBlock;
+
+	if( ( xReserveBlockSize >= heapRESERVE_SIZE ) || ( xFreeBytesRemaining < heapRESERVE_SIZE ) )
+	{
+		return;
+	}
+
+	pxBlock = prvTakeBlockFromFreeList( heapRESERVE_SIZE, 0 );
+	if( pxBlock == NULL )
+	{
+		return;
+	}
+
+	xFreeBytesRemaining -= pxBlock->xBlockSize;
+	if( xFreeBytesRemaining < xMinimumEverFreeBytesRemaining )
+	{
+		xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+	}
+	heapZERO_CLEAR( pxBlock );
+	pxBlock->xBlockSize |= xBlockAllocatedBit;
+	heapSET_NEXT( pxBlock, NULL );
+
+	if( pxReserveBlock != NULL )
+	{
+		xFreeBytesRemaining += xReserveBlockSize;
+		pxReserveBlock->xBlockSize = xReserveBlockSize;
+		prvInsertBlockIntoFreeList( pxReserveBlock );
+	}
+	pxReserveBlock = pxBlock;
+	xReserveBlockSize = pxBlock->xBlockSize & ~heapBLOCK_FLAGS;
+}
+
+// 在临界区内调用，从储备开头切出 xWantedSize 字节，返回的内存块尚未打上已分配标记，与 prvTakeBlockFromFreeList 一致
+static BlockLink_t *prvReserveTake( size_t xWantedSize )
+{
+	BlockLink_t *pxBlock = pxReserveBlock;
+
+	if( ( pxBlock == NULL ) || ( xWantedSize > xReserveBlockSize ) )
+	{
+		return NULL;
+	}
+
+	// 带外元数据下分隔会多出一个存活内存块，已达上限时整块交出
+	if( ( ( xReserveBlockSize - xWantedSize ) > heapMINIMUM_BLOCK_SIZE )
+	#if defined(MEM_OOB_META_EN) && (MEM_OOB_META_EN > 0)
+		&& ( ( xOobUsedBlockNum + xRegionNum ) < MEM_OOB_NODE_NUM )
+	#endif
+		)
+	{
+		pxReserveBlock = ( BlockLink_t * ) ( ( ( uint8_t * ) pxBlock ) + xWantedSize );
+		xReserveBlockSize -= xWantedSize;
+		pxReserveBlock->xBlockSize = xReserveBlockSize | xBlockAllocatedBit;
+		heapSET_NEXT( pxReserveBlock, NULL );
+		// 新块头之后的字来自原储备的中间，可能恰好是清零标记
+		heapZERO_CLEAR( pxReserveBlock );
+		pxBlock->xBlockSize = xWantedSize;
+	#if defined(MEM_OOB_META_EN) && (MEM_OOB_META_EN > 0)
+		xOobUsedBlockNum++;
+	#endif
+	}
+	else
+	{
+		pxBlock->xBlockSize = xReserveBlockSize;
+		pxReserveBlock = NULL;
+		xReserveBlockSize = 0;
+	}
+
+	// 切出的部分先记回空闲字节数，由调用者按普通申请扣除
+	xFreeBytesRemaining += pxBlock->xBlockSize;
+	return pxBlock;
+}
+
+size_t memReserveGetSize( void )
+{
+	return xReserveBlockSize;
+}
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if defined(MEM_WAIT_EN) && (MEM_WAIT_EN > 0)
+
+// 在临界区内调用，排在同优先级的等待者之后
+static void prvWaitLink( MemWaiter_t *pxWaiter )
+{
+	MemWaiter_t **ppxIterator = &pxWaitList;
+
+	while( ( *ppxIterator != NULL ) && ( ( *ppxIterator )->uxPriority >= pxWaiter->uxPriority ) )
+	{
+		ppxIterator = &( ( *ppxIterator )->pxNext );
+	}
+	pxWaiter->pxNext = *ppxIterator;
+	*ppxIterator = pxWaiter;
+	pxWaiter->ucLinked = 1;
+}
+
+// 在临界区内调用，已被唤醒(移出链表)时不做处理
+static void prvWaitUnlink( MemWaiter_t *pxWaiter )
+{
+	MemWaiter_t **ppxIterator = &pxWaitList;
+
+	if( pxWaiter->ucLinked == 0 )
+	{
+		return;
+	}
+
+	while( *ppxIterator != pxWaiter )
+	{
+		ppxIterator = &( ( *ppxIterator )->pxNext );
+	}
+	*ppxIterator = pxWaiter->pxNext;
+	pxWaiter->ucLinked = 0;
+}
+
+/*
+ * 在临界区内调用，xFreeSize 为刚释放的内存所在空闲块的大小. 按优先级从高到低唤醒放得下的等待者，
+ * 每唤醒一个扣除其块大小，放不下的不阻挡后面较小的申请；被唤醒的任务重新申请，失败时再次等待.
+ */
+static void prvWaitWake( size_t xFreeSize )
+{
+	MemWaiter_t **ppxIterator = &pxWaitList;
+	MemWaiter_t *pxWaiter;
+
+	while( ( *ppxIterator != NULL ) && ( xFreeSize > 0 ) )
+	{
+		pxWaiter = *ppxIterator;
+		if( pxWaiter->xBlockSize <= xFreeSize )
+		{
+			xFreeSize -= pxWaiter->xBlockSize;
+			*ppxIterator = pxWaiter->pxNext;
+			pxWaiter->ucLinked = 0;
+			heapWAIT_NOTIFY( pxWaiter->xTask );
+		}
+		else
+		{
+			ppxIterator = &( pxWaiter->pxNext );
+		}
+	}
+}
+
+void *memMallocWait( size_t xWantedSize, uint32_t ulTimeoutTicks )
+{
+	MemAllocCall_t xCall;
+	MemWaiter_t xWaiter;
+	TimeOut_t xTimeOut;
+	TickType_t xTicksToWait;
+	void *pvReturn;
+	uint8_t ucExpired = 0;
+
+	xCall.ucTraceOp = MEM_TRACE_OP_MALLOC;
+	xCall.xCaller = MEM_TRACE_CALLER();
+	xCall.ucTag = MEM_TAG_DEFAULT;
+	xCall.ucFlags = heapCALL_WAIT;
+
+	// 大小为 0 或与标记位冲突的申请永远不会成功，不等待
+	if( ( xWantedSize == 0 ) || ( ( xWantedSize & heapBLOCK_FLAGS ) != 0 ) )
+	{
+		return prvMalloc( xWantedSize, &xCall );
+	}
+
+	xWaiter.pxNext = NULL;
+	xWaiter.xTask = xTaskGetCurrentTaskHandle();
+	xWaiter.uxPriority = uxTaskPriorityGet( NULL );
+	xWaiter.xBlockSize = ( xWantedSize + xHeapStructSize + memBYTE_ALIGNMENT_MASK ) & ~( ( size_t ) memBYTE_ALIGNMENT_MASK );
+	xWaiter.ucLinked = 0;
+	xTicksToWait = ( ulTimeoutTicks == MEM_WAIT_FOREVER ) ? portMAX_DELAY : ( TickType_t ) ulTimeoutTicks;
+	vTaskSetTimeOutState( &xTimeOut );
+
+	for( ;; )
+	{
+		// 申请失败与进入等待链表在同一个临界区内完成，期间释放的内存不会漏掉唤醒
+		memHEAP_LOCK();
+		{
+			pvReturn = prvMalloc( xWantedSize, &xCall );
+			if( pvReturn == NULL )
+			{
+				ucExpired = ( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) != pdFALSE ) ? 1 : 0;
+				if( ucExpired == 0 )
+				{
+					prvWaitLink( &xWaiter );
+				}
+			}
+		}
+		memHEAP_UNLOCK();
+
+		if( ( pvReturn != NULL ) || ( ucExpired != 0 ) )
+		{
+			break;
+		}
+
+		heapWAIT_BLOCK( xTicksToWait );
+
+		memHEAP_LOCK();
+		prvWaitUnlink( &xWaiter );
+		memHEAP_UNLOCK();
+	}
+
+	return pvReturn;
+}
+
+#endif
+/*-----------------------------------------------------------*/
+
+size_t memGetFreeHeapSize( void )
+{
+	return xFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+size_t memGetMinimumEverFreeHeapSize( void )
+{
+	return xMinimumEverFreeBytesRemaining;
+}
+
+size_t memGetFreeBlockNum( void )
+{
+	return xFreeBlockNum;
+}
+
+// {"xMemFreeListLayout":[12,12],"num":2}
+void memPrintfFreeListLayout(void)
+{
+#if defined(MEM_OOB_META_EN) && (MEM_OOB_META_EN > 0)
+	uint16_t usNode;
+#else
+	BlockLink_t *pxIterator = &xStart;
+#endif
+	size_t num = 0,freeBlockTotalSize = 0;
+
+	MEM_MANAGE_PRINTF("\n{\"xMemFreeListLayout\":[");
+#if defined(MEM_OOB_META_EN) && (MEM_OOB_META_EN > 0)
+	for( usNode = usOobHead; usNode != heapOOB_NIL; usNode = xOobNodes[ usNode ].usNext )
+	{
+		MEM_MANAGE_PRINTF("%lu,",( unsigned long ) xOobNodes[ usNode ].ulSize);
+		freeBlockTotalSize += xOobNodes[ usNode ].ulSize;
+		num++;
+	}
+#else
+	while(heapGET_NEXT( pxIterator ) != NULL)
+	{
+		if(pxIterator->xBlockSize > 0) {
+			// MEM_MANAGE_PRINTF("{\"size\":%ld,\"0x\"%08x},",pxIterator->xBlockSize,(size_t)(pxIterator));
+			MEM_MANAGE_PRINTF("%lu,",( unsigned long ) pxIterator->xBlockSize);
+			freeBlockTotalSize += pxIterator->xBlockSize;
+			num++;
+		}
+		pxIterator = heapGET_NEXT( pxIterator );
+	}
+#endif
+	MEM_MANAGE_PRINTF("%lu],\"num\":%lu}\n",( unsigned long ) freeBlockTotalSize,( unsigned long ) num);
+}
+
+size_t memHeapWalk( MEM_HEAP_WALK_CB pxCallback, void *pvArg )
+{
+	MemHeapBlockInfo_t xInfo;
+	BlockLink_t *pxBlock;
+	size_t xRegion, xNum = 0;
+	int iStop = 0;
+
+	if( ( pxCallback == NULL ) || ( pxEnd == NULL ) )
+	{
+		return 0;
+	}
+
+	memHEAP_LOCK();
+	{
+		for( xRegion = 0; ( xRegion < xRegionNum ) && ( iStop == 0 ); xRegion++ )
+		{
+			// 区域内的内存块首尾相接，按块大小依次跳到下一块，直到结束标记
+			pxBlock = xRegionBounds[ xRegion ].pxFirstBlock;
+			while( ( pxBlock < xRegionBounds[ xRegion ].pxEndMarker ) && ( iStop == 0 ) )
+			{
+				xInfo.pvBlock = pxBlock;
+				xInfo.xOffset = ( size_t ) pxBlock - ( size_t ) xRegionBounds[ 0 ].pxFirstBlock;
+				xInfo.xSize = pxBlock->xBlockSize & ~heapBLOCK_FLAGS;
+				if( ( pxBlock->xBlockSize & xBlockAllocatedBit ) == 0 )
+				{
+					xInfo.eState = MEM_BLOCK_FREE;
+				}
+			#if defined(MEM_RESERVE_EN) && (MEM_RESERVE_EN > 0)
+				else if( pxBlock == pxReserveBlock )
+				{
+					// 储备块的序号和时间戳是预留时的旧值，不能当作已分配块参与快照和泄漏统计
+					xInfo.eState = MEM_BLOCK_RESERVED;
+				}
+			#endif
+				else if( heapGET_NEXT( pxBlock ) == NULL )
+				{
+					xInfo.eState = MEM_BLOCK_USED;
+				}
+				else
+				{
+					xInfo.eState = MEM_BLOCK_CACHED;
+				}
+
+				// 块头损坏时停止遍历，避免越界
+				if( xInfo.xSize == 0 )
+				{
+					break;
+				}
+
+				xNum++;
+				iStop = pxCallback( &xInfo, pvArg );
+				pxBlock = ( BlockLink_t * ) ( ( uint8_t * ) pxBlock + xInfo.xSize );
+			}
+		}
+	}
+	memHEAP_UNLOCK();
+
+	return xNum;
+}
+
+/* 二进制堆布局输出的上下文，记录先缓存到 ucBuf，满了再交给 pxSink. */
+typedef struct MemHeapDumpCtx
+{
+	MEM_OUTPUT_SINK pxSink;
+	void *pvArg;
+	size_t xNextOffset;		// 上一条记录所描述内存块的结束偏移
+	size_t xLen;
+	uint8_t ucBuf[ 64 ];
+} MemHeapDumpCtx_t;
+
+static void prvHeapDumpPutVarint( MemHeapDumpCtx_t *pxCtx, size_t xValue )
+{
+	// 为保证一个变长整数不会被拆开，缓存剩余空间不足 10 字节时先输出
+	if( ( sizeof( pxCtx->ucBuf ) - pxCtx->xLen ) < 10 )
+	{
+		pxCtx->pxSink( pxCtx->ucBuf, pxCtx->xLen, pxCtx->pvArg );
+		pxCtx->xLen = 0;
+	}
+
+	while( xValue >= 0x80 )
+	{
+		pxCtx->ucBuf[ pxCtx->xLen++ ] = ( uint8_t ) ( xValue | 0x80 );
+		xValue >>= 7;
+	}
+	pxCtx->ucBuf[ pxCtx->xLen++ ] = ( uint8_t ) xValue;
+}
+
+static int prvHeapDumpBlock( const MemHeapBlockInfo_t *pxInfo, void *pvArg )
+{
+	MemHeapDumpCtx_t *pxCtx = ( MemHeapDumpCtx_t * ) pvArg;
+
+	prvHeapDumpPutVarint( pxCtx, ( pxInfo->xOffset - pxCtx->xNextOffset ) / memBYTE_ALIGNMENT );
+	prvHeapDumpPutVarint( pxCtx, ( ( pxInfo->xSize / memBYTE_ALIGNMENT ) << 2 ) | ( size_t ) pxInfo->eState );
+	pxCtx->xNextOffset = pxInfo->xOffset + pxInfo->xSize;
+
+	return 0;
+}
+
+size_t memHeapDumpBinary( MEM_OUTPUT_SINK pxSink, void *pvArg )
+{
+	MemHeapDumpCtx_t xCtx;
+	size_t xNum;
+
+	if( pxSink == NULL )
+	{
+		return 0;
+	}
+
+	xCtx.pxSink = pxSink;
+	xCtx.pvArg = pvArg;
+	xCtx.xNextOffset = 0;
+	xCtx.xLen = 0;
+
+	// 文件头: 'M' 'H' 版本 对齐字节数
+	xCtx.ucBuf[ xCtx.xLen++ ] = 'M';
+	xCtx.ucBuf[ xCtx.xLen++ ] = 'H';
+	xCtx.ucBuf[ xCtx.xLen++ ] = MEM_HEAP_DUMP_VERSION;
+	xCtx.ucBuf[ xCtx.xLen++ ] = memBYTE_ALIGNMENT;
+
+	xNum = memHeapWalk( prvHeapDumpBlock, &xCtx );
+
+	// 结束记录: 间隔 0，大小 0
+	prvHeapDumpPutVarint( &xCtx, 0 );
+	prvHeapDumpPutVarint( &xCtx, 0 );
+	pxSink( xCtx.ucBuf, xCtx.xLen, pvArg );
+
+	return xNum;
+}
+
+#if defined(MEM_SNAPSHOT_EN) && (MEM_SNAPSHOT_EN > 0)
+
+static int prvSnapshotBlock( const MemHeapBlockInfo_t *pxInfo, void *pvArg )
+{
+	MemSnapshot_t *pxSnapshot = ( MemSnapshot_t * ) pvArg;
+	MemSnapshotEntry_t *pxEntry;
+	const BlockLink_t *pxBlock = ( const BlockLink_t * ) pxInfo->pvBlock;
+
+	if( pxInfo->eState != MEM_BLOCK_USED )
+	{
+		return 0;
+	}
+
+	// 缓冲区满时只计数，调用者据此判断需要的容量
+	if( pxSnapshot->xNum < pxSnapshot->xCapacity )
+	{
+		pxEntry = &pxSnapshot->pxEntries[ pxSnapshot->xNum ];
+		pxEntry->pvBlock = ( uint8_t * ) pxInfo->pvBlock + xHeapStructSize;
+		pxEntry->xSize = pxInfo->xSize - xHeapStructSize;
+		pxEntry->ulSeq = pxBlock->ulSeq;
+	#if defined(MEM_TAG_EN) && (MEM_TAG_EN > 0)
+		pxEntry->ucTag = heapGET_TAG( pxBlock );
+	#else
+		pxEntry->ucTag = MEM_TAG_DEFAULT;
+	#endif
+	}
+	pxSnapshot->xNum++;
+
+	return 0;
+}
+
+size_t memSnapshotTake( MemSnapshot_t *pxSnapshot, MemSnapshotEntry_t *pxEntries, size_t xCapacity )
+{
+	if( pxSnapshot == NULL )
+	{
+		return 0;
+	}
+
+	pxSnapshot->pxEntries = pxEntries;
+	pxSnapshot->xCapacity = ( pxEntries != NULL ) ? xCapacity : 0;
+	pxSnapshot->xNum = 0;
+
+	memHEAP_LOCK();
+	{
+		pxSnapshot->ulSeq = ulAllocSeq;
+		( void ) memHeapWalk( prvSnapshotBlock, pxSnapshot );
+	}
+	memHEAP_UNLOCK();
+
+	return pxSnapshot->xNum;
+}
+
+size_t memSnapshotDiff( const MemSnapshot_t *pxOld, const MemSnapshot_t *pxNew, MemSnapshotEntry_t *pxOut, size_t xOutCapacity )
+{
+	size_t xIndex, xNum = 0, xEntryNum;
+
+	if( ( pxOld == NULL ) || ( pxNew == NULL ) )
+	{
+		return 0;
+	}
+
+	// 序号不小于旧快照时的下一个序号，说明是旧快照之后申请的，且在新快照时仍存活
+	xEntryNum = ( pxNew->xNum < pxNew->xCapacity ) ? pxNew->xNum : pxNew->xCapacity;
+	for( xIndex = 0; xIndex < xEntryNum; xIndex++ )
+	{
+		if( ( int32_t ) ( pxNew->pxEntries[ xIndex ].ulSeq - pxOld->ulSeq ) >= 0 )
+		{
+			if( ( pxOut != NULL ) && ( xNum < xOutCapacity ) )
+			{
+				pxOut[ xNum ] = pxNew->pxEntries[ xIndex ];
+			}
+			xNum++;
+		}
+	}
+
+	return xNum;
+}
+
+#endif
+
+#if defined(MEM_AGE_EN) && (MEM_AGE_EN > 0)
+
+typedef struct MemAgeCtx
+{
+	MemAgeHist_t *pxHist;
+	uint8_t ucTag;
+} MemAgeCtx_t;
+
+static int prvAgeBlock( const MemHeapBlockInfo_t *pxInfo, void *pvArg )
+{
+	MemAgeCtx_t *pxCtx = ( MemAgeCtx_t * ) pvArg;
+	const BlockLink_t *pxBlock = ( const BlockLink_t * ) pxInfo->pvBlock;
+	uint32_t ulAge;
+	size_t xBucket = 0;
+
+	if( pxInfo->eState != MEM_BLOCK_USED )
+	{
+		return 0;
+	}
+#if defined(MEM_TAG_EN) && (MEM_TAG_EN > 0)
+	if( ( pxCtx->ucTag != MEM_AGE_ALL_TAGS ) && ( heapGET_TAG( pxBlock ) != pxCtx->ucTag ) )
+	{
+		return 0;
+	}
+#endif
+
+	ulAge = pxCtx->pxHist->ulNow - pxBlock->ulBirth;
+	if( ulAge > pxCtx->pxHist->ulOldestAge )
+	{
+		pxCtx->pxHist->ulOldestAge = ulAge;
+	}
+
+	// 第 i 格统计年龄在 [2^i, 2^(i+1)) 个时间单位的内存块，0 和 1 都计入第 0 格
+	while( ( ulAge > 1 ) && ( xBucket < ( MEM_AGE_BUCKET_NUM - 1 ) ) )
+	{
+		ulAge >>= 1;
+		xBucket++;
+	}
+
+	pxCtx->pxHist->xBytes[ xBucket ] += pxInfo->xSize;
+	pxCtx->pxHist->xCount[ xBucket ]++;
+
+	return 0;
+}
+
+size_t memAgeGetHistogram( MemAgeHist_t *pxHist, uint8_t ucTag )
+{
+	MemAgeCtx_t xCtx;
+	size_t xNum = 0, xBucket;
+
+	if( pxHist == NULL )
+	{
+		return 0;
+	}
+
+	memset( pxHist, 0, sizeof( MemAgeHist_t ) );
+	xCtx.pxHist = pxHist;
+	xCtx.ucTag = ucTag;
+
+	memHEAP_LOCK();
+	{
+		pxHist->ulNow = MEM_GET_TIMESTAMP();
+		( void ) memHeapWalk( prvAgeBlock, &xCtx );
+	}
+	memHEAP_UNLOCK();
+
+	for( xBucket = 0; xBucket < MEM_AGE_BUCKET_NUM; xBucket++ )
+	{
+		xNum += pxHist->xCount[ xBucket ];
+	}
+
+	return xNum;
+}
+
+#endif
+
+#if defined(MEM_CHECK_EN) && (MEM_CHECK_EN > 0)
+
+// 空闲链表指针须指向更高地址、对齐，且落在某个堆区域内(含结束标记)
+static int prvCheckLinkValid( const BlockLink_t *pxBlock, const BlockLink_t *pxNext )
+{
+	size_t xRegion;
+
+	if( ( pxNext <= pxBlock ) || ( ( ( size_t ) pxNext & memBYTE_ALIGNMENT_MASK ) != 0 ) )
+	{
+		return 0;
+	}
+
+	for( xRegion = 0; xRegion < xRegionNum; xRegion++ )
+	{
+		if( ( pxNext >= xRegionBounds[ xRegion ].pxFirstBlock ) && ( pxNext <= xRegionBounds[ xRegion ].pxEndMarker ) )
+		{
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+// 在临界区内调用，检查游标处的一个内存块并前进，返回发现的问题
+static MemCheckError_t prvCheckBlock( BlockLink_t **ppxBad )
+{
+	MemCheckCursor_t *pxCur = &xCheckCursor;
+	BlockLink_t *pxBlock, *pxMarker, *pxNext;
+	MemCheckError_t eError = MEM_CHECK_OK;
+	size_t xSize;
+
+	if( pxCur->pxBlock == NULL )
+	{
+		// 新一轮从第一个区域开始，空闲链表的第一个节点应是地址最低的空闲块
+		pxCur->xRegion = 0;
+		pxCur->pxBlock = xRegionBounds[ 0 ].pxFirstBlock;
+		pxCur->pxExpectFree = heapGET_NEXT( &xStart );
+		pxCur->xFreeNum = 0;
+		pxCur->xFreeBytes = 0;
+		pxCur->ucPrevFree = 0;
+		pxCur->ucDirty = 0;
+	}
+
+	pxBlock = pxCur->pxBlock;
+	pxMarker = xRegionBounds[ pxCur->xRegion ].pxEndMarker;
+	*ppxBad = pxBlock;
+
+	if( pxBlock == pxMarker )
+	{
+		// 结束标记也在空闲链表中，最后一个区域的结束标记即 pxEnd，之后为空
+		pxNext = heapGET_NEXT( pxBlock );
+		if( ( pxCur->pxExpectFree != NULL ) && ( pxCur->pxExpectFree != pxBlock ) )
+		{
+			eError = MEM_CHECK_BAD_LINK;
+		}
+		else if( ( pxCur->xRegion + 1 < xRegionNum ) ? ( prvCheckLinkValid( pxBlock, pxNext ) == 0 ) : ( pxNext != NULL ) )
+		{
+			eError = MEM_CHECK_BAD_LINK;
+		}
+		pxCur->pxExpectFree = ( eError == MEM_CHECK_OK ) ? pxNext : NULL;
+		pxCur->ucPrevFree = 0;
+
+		pxCur->xRegion++;
+		if( pxCur->xRegion < xRegionNum )
+		{
+			pxCur->pxBlock = xRegionBounds[ pxCur->xRegion ].pxFirstBlock;
+		}
+		else
+		{
+			// 一轮结束，本轮未被打断时核对计数
+			if( ( eError == MEM_CHECK_OK ) && ( pxCur->ucDirty == 0 ) )
+			{
+				*ppxBad = NULL;
+				if( pxCur->xFreeNum != xFreeBlockNum )
+				{
+					eError = MEM_CHECK_BAD_FREE_NUM;
+				}
+				else if( pxCur->xFreeBytes != xFreeBytesRemaining )
+				{
+					eError = MEM_CHECK_BAD_FREE_BYTES;
+				}
+			}
+			pxCur->pxBlock = NULL;
+			ulCheckPasses++;
+		}
+		return eError;
+	}
+
+	xSize = pxBlock->xBlockSize & ~heapBLOCK_FLAGS;
+	if( ( xSize == 0 ) || ( ( xSize & memBYTE_ALIGNMENT_MASK ) != 0 )
+		|| ( xSize > ( size_t ) ( ( uint8_t * ) pxMarker - ( uint8_t * ) pxBlock ) ) )
+	{
+		// 块头已损坏，无法找到下一块，跳过该区域的剩余部分
+		pxCur->pxBlock = pxMarker;
+		pxCur->pxExpectFree = NULL;
+		pxCur->ucPrevFree = 0;
+		pxCur->ucDirty = 1;
+		return MEM_CHECK_BAD_SIZE;
+	}
+
+	if( ( pxBlock->xBlockSize & xBlockAllocatedBit ) == 0 )
+	{
+		pxNext = heapGET_NEXT( pxBlock );
+		if( pxCur->ucPrevFree != 0 )
+		{
+			eError = MEM_CHECK_NOT_MERGED;
+		}
+		else if( ( ( pxCur->pxExpectFree != NULL ) && ( pxCur->pxExpectFree != pxBlock ) )
+				|| ( prvCheckLinkValid( pxBlock, pxNext ) == 0 ) )
+		{
+			eError = MEM_CHECK_BAD_LINK;
+		}
+		pxCur->pxExpectFree = ( eError == MEM_CHECK_OK ) ? pxNext : NULL;
+		pxCur->ucPrevFree = 1;
+		pxCur->xFreeNum++;
+		pxCur->xFreeBytes += xSize;
+	}
+	else
+	{
+		// 快速链表缓存的内存块计入 xFreeBytesRemaining，但不计入 xFreeBlockNum
+		if( heapGET_NEXT( pxBlock ) != NULL )
+		{
+			pxCur->xFreeBytes += xSize;
+		}
+		pxCur->ucPrevFree = 0;
+	}
+
+	if( eError != MEM_CHECK_OK )
+	{
+		pxCur->ucDirty = 1;
+	}
+	pxCur->pxBlock = ( BlockLink_t * ) ( ( uint8_t * ) pxBlock + xSize );
+
+	return eError;
+}
+
+MemCheckError_t memCheckStep( size_t xMaxBlocks )
+{
+	MemCheckError_t eError = MEM_CHECK_OK;
+	BlockLink_t *pxBad = NULL;
+	size_t xChecked;
+
+	if( pxEnd == NULL )
+	{
+		return MEM_CHECK_OK;
+	}
+
+	memHEAP_LOCK();
+	{
+		// 上次检查之后堆被修改过，之前记下的期望节点和相邻关系已失效
+		if( xCheckCursor.ulGeneration != ulCheckGeneration )
+		{
+			xCheckCursor.ulGeneration = ulCheckGeneration;
+			xCheckCursor.pxExpectFree = NULL;
+			xCheckCursor.ucPrevFree = 0;
+			xCheckCursor.ucDirty = 1;
+		}
+
+		// 每次最多报告一个问题，回调在临界区外调用
+		for( xChecked = 0; ( xChecked < xMaxBlocks ) && ( eError == MEM_CHECK_OK ); xChecked++ )
+		{
+			eError = prvCheckBlock( &pxBad );
+		}
+	}
+	memHEAP_UNLOCK();
+
+	if( ( eError != MEM_CHECK_OK ) && ( xMemManage.heap_check_cb != NULL ) )
+	{
+		xMemManage.heap_check_cb( eError, pxBad,
+			( pxBad != NULL ) ? ( size_t ) pxBad - ( size_t ) xRegionBounds[ 0 ].pxFirstBlock
+			: ( ( eError == MEM_CHECK_BAD_FREE_NUM ) ? xCheckCursor.xFreeNum : xCheckCursor.xFreeBytes ) );
+	}
+
+	return eError;
+}
+
+uint32_t memCheckGetPassCount( void )
+{
+	return ulCheckPasses;
+}
+
+static void prvCheckReset( void )
+{
+	memset( &xCheckCursor, 0, sizeof( MemCheckCursor_t ) );
+	xCheckCursor.ulGeneration = ulCheckGeneration;
+	ulCheckPasses = 0;
+}
+
+#endif
+
+#if defined(MEM_ZERO_EN) && (MEM_ZERO_EN > 0)
+
+#if defined(MEM_HOSTED_MMAP_EN) && (MEM_HOSTED_MMAP_EN > 0) && (MEM_HOSTED_MADVISE == MADV_DONTNEED)
+// 用 madvise 归还中间的整页，归还后读到的内容为 0，只清零之前不足一页的部分；返回从 pucStart 起已清零的字节数
+static size_t prvHostedZeroPages( uint8_t *pucStart, size_t xLen )
+{
+	size_t xPageMask = xHostedPageSize - 1;
+	size_t xLow, xHigh;
+
+	if( xHostedPageSize == 0 )
+	{
+		return 0;
+	}
+
+	xLow = ( ( size_t ) pucStart + xPageMask ) & ~xPageMask;
+	xHigh = ( ( size_t ) pucStart + xLen ) & ~xPageMask;
+	if( ( xHigh <= xLow ) || ( ( xHigh - xLow ) < MEM_HOSTED_RELEASE_THRESHOLD )
+		|| ( madvise( ( void * ) xLow, xHigh - xLow, MADV_DONTNEED ) != 0 ) )
+	{
+		return 0;
+	}
+
+	xHostedReleasedBytes += xHigh - xLow;
+	memset( pucStart, 0, xLow - ( size_t ) pucStart );
+	return xHigh - ( size_t ) pucStart;
+}
+#endif
+
+size_t memZeroStep( size_t xMaxBytes )
+{
+	BlockLink_t *pxBlock;
+	uint8_t *pucStart;
+	size_t xLen, xChunk, xZeroed = 0;
+
+	if( pxEnd == NULL )
+	{
+		return 0;
+	}
+
+	memHEAP_LOCK();
+	{
+		// 从上次停下的空闲块继续，到达链表末尾后下次从头开始
+		pxBlock = ( pxZeroCursor != NULL ) ? pxZeroCursor : heapGET_NEXT( &xStart );
+		while( ( pxBlock != NULL ) && ( xMaxBytes > 0 ) )
+		{
+			// 结束标记和已清零的内存块只计入访问节点的开销
+			if( ( pxBlock->xBlockSize == 0 ) || heapIS_ZERO( pxBlock ) )
+			{
+				xMaxBytes -= ( xMaxBytes > sizeof( BlockLink_t ) ) ? sizeof( BlockLink_t ) : xMaxBytes;
+				pxBlock = heapGET_NEXT( pxBlock );
+				continue;
+			}
+
+			// 标记字之后的用户区
+			pucStart = ( uint8_t * ) pxBlock + xHeapStructSize + sizeof( size_t );
+			xLen = pxBlock->xBlockSize - xHeapStructSize - sizeof( size_t );
+
+		#if defined(MEM_HOSTED_MMAP_EN) && (MEM_HOSTED_MMAP_EN > 0) && (MEM_HOSTED_MADVISE == MADV_DONTNEED)
+			if( xZeroDone == 0 )
+			{
+				xZeroDone = prvHostedZeroPages( pucStart, xLen );
+				xZeroed += xZeroDone;
+			}
+		#endif
+
+			xChunk = ( ( xLen - xZeroDone ) < xMaxBytes ) ? ( xLen - xZeroDone ) : xMaxBytes;
+			memset( pucStart + xZeroDone, 0, xChunk );
+			xZeroDone += xChunk;
+			xZeroed += xChunk;
+			xMaxBytes -= xChunk;
+
+			if( xZeroDone == xLen )
+			{
+				heapZERO_MARK( pxBlock ) = heapZERO_MAGIC;
+				xZeroDone = 0;
+				pxBlock = heapGET_NEXT( pxBlock );
+			}
+		}
+		pxZeroCursor = pxBlock;
+	}
+	memHEAP_UNLOCK();
+
+	return xZeroed;
+}
+
+#endif
+
+#if defined(MEM_TRACE_EN) && (MEM_TRACE_EN > 0)
+
+static size_t prvPutVarint( uint8_t *pucBuf, size_t xValue )
+{
+	size_t xLen = 0;
+
+	while( xValue >= 0x80 )
+	{
+		pucBuf[ xLen++ ] = ( uint8_t ) ( xValue | 0x80 );
+		xValue >>= 7;
+	}
+	pucBuf[ xLen++ ] = ( uint8_t ) xValue;
+
+	return xLen;
+}
+
+// 写入环形缓冲区，空间不足时不写并返回 0
+static int prvTraceWrite( const uint8_t *pucData, size_t xLen )
+{
+	size_t xIndex;
+
+	if( ( MEM_TRACE_BUF_SIZE - ( xTraceHead - xTraceTail ) ) < xLen )
+	{
+		return 0;
+	}
+
+	for( xIndex = 0; xIndex < xLen; xIndex++ )
+	{
+		ucTraceBuf[ ( xTraceHead + xIndex ) & ( MEM_TRACE_BUF_SIZE - 1 ) ] = pucData[ xIndex ];
+	}
+	xTraceHead += xLen;
+
+	return 1;
+}
+
+static void prvTraceRecord( uint8_t ucOp, size_t xCaller, const size_t *pxArgs, size_t xArgNum )
+{
+	uint8_t ucRecord[ ( 1 + 5 ) + ( 1 + 6 * 10 ) ];
+	uint32_t ulTimestamp = MEM_GET_TIMESTAMP();
+	size_t xLen = 0, xIndex;
+
+	// 之前有记录被丢弃，先补一条丢弃记录，与本条记录一起写入
+	if( ulTraceDroppedPending > 0 )
+	{
+		ucRecord[ xLen++ ] = MEM_TRACE_OP_DROPPED;
+		xLen += prvPutVarint( &ucRecord[ xLen ], ulTraceDroppedPending );
+	}
+
+	ucRecord[ xLen++ ] = ( uint8_t ) ( ucOp | ( ( xCaller != 0 ) ? MEM_TRACE_FLAG_CALLER : 0 ) );
+	xLen += prvPutVarint( &ucRecord[ xLen ], ( size_t ) ( uint32_t ) ( ulTimestamp - ulTraceLastTimestamp ) );
+	for( xIndex = 0; xIndex < xArgNum; xIndex++ )
+	{
+		xLen += prvPutVarint( &ucRecord[ xLen ], pxArgs[ xIndex ] );
+	}
+	if( xCaller != 0 )
+	{
+		xLen += prvPutVarint( &ucRecord[ xLen ], xCaller );
+	}
+
+	if( prvTraceWrite( ucRecord, xLen ) == 0 )
+	{
+		ulTraceDroppedPending++;
+		ulTraceDropped++;
+		return;
+	}
+	ulTraceDroppedPending = 0;
+	ulTraceLastTimestamp = ulTimestamp;
+}
+
+void memTraceReset( void )
+{
+	uint8_t ucHeader[ 4 ];
+
+	ucHeader[ 0 ] = 'M';
+	ucHeader[ 1 ] = 'T';
+	ucHeader[ 2 ] = MEM_TRACE_VERSION;
+	ucHeader[ 3 ] = memBYTE_ALIGNMENT;
+
+	memHEAP_LOCK();
+	{
+		xTraceHead = 0;
+		xTraceTail = 0;
+		ulTraceDropped = 0;
+		ulTraceDroppedPending = 0;
+		ulTraceLastTimestamp = MEM_GET_TIMESTAMP();
+		( void ) prvTraceWrite( ucHeader, sizeof( ucHeader ) );
+	}
+	memHEAP_UNLOCK();
+}
+
+size_t memTraceDrain( MEM_OUTPUT_SINK pxSink, void *pvArg )
+{
+	size_t xHead, xTail, xLen, xTotal = 0;
+
+	if( pxSink == NULL )
+	{
+		return 0;
+	}
+
+	for( ;; )
+	{
+		memHEAP_LOCK();
+		{
+			xHead = xTraceHead;
+			xTail = xTraceTail;
+		}
+		memHEAP_UNLOCK();
+
+		if( xHead == xTail )
+		{
+			break;
+		}
+
+		// 每次输出到缓冲区末尾为止的连续数据，输出期间不持有锁，生产者只会写入空闲区域
+		xLen = xHead - xTail;
+		if( ( ( xTail & ( MEM_TRACE_BUF_SIZE - 1 ) ) + xLen ) > MEM_TRACE_BUF_SIZE )
+		{
+			xLen = MEM_TRACE_BUF_SIZE - ( xTail & ( MEM_TRACE_BUF_SIZE - 1 ) );
+		}
+		pxSink( &ucTraceBuf[ xTail & ( MEM_TRACE_BUF_SIZE - 1 ) ], xLen, pvArg );
+		xTotal += xLen;
+
+		memHEAP_LOCK();
+		{
+			xTraceTail += xLen;
+		}
+		memHEAP_UNLOCK();
+	}
+
+	return xTotal;
+}
+
+uint32_t memTraceGetDropped( void )
+{
+	return ulTraceDropped;
+}
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if defined(MEM_PROFILE_EN) && (MEM_PROFILE_EN > 0)
+
+static size_t prvProfileHash( const void *pv )
+{
+	return ( ( ( size_t ) pv / memBYTE_ALIGNMENT ) * 2654435761UL ) & ( MEM_PROFILE_SAMPLE_NUM - 1 );
+}
+
+// 下一次采样间隔在 [1, 2 * MEM_PROFILE_SAMPLE_BYTES] 内均匀随机，避免与固定的申请模式同步
+static size_t prvProfileNextInterval( void )
+{
+	ulProfileRand ^= ulProfileRand << 13;
+	ulProfileRand ^= ulProfileRand >> 17;
+	ulProfileRand ^= ulProfileRand << 5;
+
+	return ( size_t ) ( ulProfileRand % ( 2UL * MEM_PROFILE_SAMPLE_BYTES ) ) + 1;
+}
+
+static void prvProfileSample( void *pv, size_t xSize, size_t xSite )
+{
+	size_t xIndex;
+
+	if( xSize < xProfileCountdown )
+	{
+		xProfileCountdown -= xSize;
+		return;
+	}
+	xProfileCountdown = prvProfileNextInterval();
+
+	// 至少保留一个空位，保证探测与后移删除都能在空位处终止
+	if( xProfileLive >= MEM_PROFILE_SAMPLE_NUM - 1 )
+	{
+		ulProfileDropped++;
+		return;
+	}
+
+	for( xIndex = prvProfileHash( pv ); xProfileSamples[ xIndex ].pvBlock != NULL; xIndex = ( xIndex + 1 ) & ( MEM_PROFILE_SAMPLE_NUM - 1 ) )
+	{
+	}
+	xProfileSamples[ xIndex ].pvBlock = pv;
+	xProfileSamples[ xIndex ].xSite = xSite;
+	xProfileSamples[ xIndex ].xSize = xSize;
+	xProfileLive++;
+}
+
+static void prvProfileRemove( void *pv )
+{
+	size_t xIndex, xNext, xHome, xProbes;
+
+	if( xProfileLive == 0 )
+	{
+		return;
+	}
+
+	xIndex = prvProfileHash( pv );
+	for( xProbes = 0; xProfileSamples[ xIndex ].pvBlock != pv; xProbes++ )
+	{
+		if( ( xProfileSamples[ xIndex ].pvBlock == NULL ) || ( xProbes >= MEM_PROFILE_SAMPLE_NUM ) )
+		{
+			return;
+		}
+		xIndex = ( xIndex + 1 ) & ( MEM_PROFILE_SAMPLE_NUM - 1 );
+	}
+	xProfileLive--;
+
+	// 后移删除: 把探测链上后续可以前移的样本填到空位，保持查找不中断
+	for( xNext = ( xIndex + 1 ) & ( MEM_PROFILE_SAMPLE_NUM - 1 ); xProfileSamples[ xNext ].pvBlock != NULL;
+		 xNext = ( xNext + 1 ) & ( MEM_PROFILE_SAMPLE_NUM - 1 ) )
+	{
+		xHome = prvProfileHash( xProfileSamples[ xNext ].pvBlock );
+		if( ( ( xNext - xHome ) & ( MEM_PROFILE_SAMPLE_NUM - 1 ) ) >= ( ( xNext - xIndex ) & ( MEM_PROFILE_SAMPLE_NUM - 1 ) ) )
+		{
+			xProfileSamples[ xIndex ] = xProfileSamples[ xNext ];
+			xIndex = xNext;
+		}
+	}
+	xProfileSamples[ xIndex ].pvBlock = NULL;
+}
+
+void memProfileReset( void )
+{
+	memHEAP_LOCK();
+	{
+		memset( xProfileSamples, 0, sizeof( xProfileSamples ) );
+		xProfileLive = 0;
+		ulProfileDropped = 0;
+		xProfileCountdown = prvProfileNextInterval();
+	}
+	memHEAP_UNLOCK();
+}
+
+size_t memProfileDump( MEM_OUTPUT_SINK pxSink, void *pvArg )
+{
+	MemHeapDumpCtx_t xCtx;
+	size_t xIndex, xNum;
+
+	if( pxSink == NULL )
+	{
+		return 0;
+	}
+
+	xCtx.pxSink = pxSink;
+	xCtx.pvArg = pvArg;
+	xCtx.xNextOffset = 0;
+	xCtx.xLen = 0;
+
+	// 文件头: 'M' 'P' 版本 对齐字节数
+	xCtx.ucBuf[ xCtx.xLen++ ] = 'M';
+	xCtx.ucBuf[ xCtx.xLen++ ] = 'P';
+	xCtx.ucBuf[ xCtx.xLen++ ] = MEM_PROFILE_VERSION;
+	xCtx.ucBuf[ xCtx.xLen++ ] = memBYTE_ALIGNMENT;
+
+	memHEAP_LOCK();
+	{
+		xNum = xProfileLive;
+		prvHeapDumpPutVarint( &xCtx, MEM_PROFILE_SAMPLE_BYTES );
+		prvHeapDumpPutVarint( &xCtx, ulProfileDropped );
+		prvHeapDumpPutVarint( &xCtx, xNum );
+		for( xIndex = 0; xIndex < MEM_PROFILE_SAMPLE_NUM; xIndex++ )
+		{
+			if( xProfileSamples[ xIndex ].pvBlock != NULL )
+			{
+				prvHeapDumpPutVarint( &xCtx, xProfileSamples[ xIndex ].xSite );
+				prvHeapDumpPutVarint( &xCtx, xProfileSamples[ xIndex ].xSize );
+			}
+		}
+	}
+	memHEAP_UNLOCK();
+
+	pxSink( xCtx.ucBuf, xCtx.xLen, pvArg );
+
+	return xNum;
+}
+
+uint32_t memProfileGetDropped( void )
+{
+	return ulProfileDropped;
+}
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if defined(MEM_TAG_EN) && (MEM_TAG_EN > 0)
+
+static void prvTagAdd( BlockLink_t *pxBlock, uint8_t ucTag )
+{
+	MemTagStat_t *pxStat = &xTagStats[ ucTag ];
+
+	pxStat->xLiveBytes += pxBlock->xBlockSize & ~heapBLOCK_FLAGS;
+	pxStat->xLiveCount++;
+	if( pxStat->xLiveBytes > pxStat->xPeakBytes )
+	{
+		pxStat->xPeakBytes = pxStat->xLiveBytes;
+	}
+
+	pxBlock->xBlockSize |= ( ( size_t ) ucTag ) << heapTAG_SHIFT;
+}
+
+static void prvTagRemove( BlockLink_t *pxBlock )
+{
+	MemTagStat_t *pxStat = &xTagStats[ heapGET_TAG( pxBlock ) ];
+
+	pxStat->xLiveBytes -= pxBlock->xBlockSize & ~heapBLOCK_FLAGS;
+	pxStat->xLiveCount--;
+
+	pxBlock->xBlockSize &= ~heapTAG_MASK;
+}
+
+static int prvTagRecountCb( const MemHeapBlockInfo_t *pxInfo, void *pvArg )
+{
+	MemTagStat_t *pxStat;
+
+	( void ) pvArg;
+	if( pxInfo->eState == MEM_BLOCK_USED )
+	{
+		pxStat = &xTagStats[ heapGET_TAG( ( BlockLink_t * ) pxInfo->pvBlock ) ];
+		pxStat->xLiveBytes += pxInfo->xSize;
+		pxStat->xLiveCount++;
+		pxStat->xPeakBytes = pxStat->xLiveBytes;
+	}
+	return 0;
+}
+
+static void prvTagRecount( void )
+{
+	memset( xTagStats, 0, sizeof( xTagStats ) );
+	( void ) memHeapWalk( prvTagRecountCb, NULL );
+}
+
+int memTagGetStat( uint8_t ucTag, MemTagStat_t *pxStat )
+{
+	if( ( ucTag >= MEM_TAG_NUM ) || ( pxStat == NULL ) )
+	{
+		return -1;
+	}
+
+	memHEAP_LOCK();
+	{
+		*pxStat = xTagStats[ ucTag ];
+	}
+	memHEAP_UNLOCK();
+
+	return 0;
+}
+
+void memTagResetPeak( uint8_t ucTag )
+{
+	if( ucTag >= MEM_TAG_NUM )
+	{
+		return;
+	}
+
+	memHEAP_LOCK();
+	{
+		xTagStats[ ucTag ].xPeakBytes = xTagStats[ ucTag ].xLiveBytes;
+	}
+	memHEAP_UNLOCK();
+}
+
+	#if defined(MEM_TASK_TAG_NUM) && (MEM_TASK_TAG_NUM > 0) && defined(OPERATE_SYSTEM) && (OPERATE_SYSTEM == SYSTEM_FREERTOS)
+
+static uint8_t prvTaskTag( void *pvTask )
+{
+	size_t xIndex;
+
+	for( xIndex = 0; xIndex < MEM_TASK_TAG_NUM; xIndex++ )
+	{
+		if( xTaskTags[ xIndex ].pvTask == pvTask )
+		{
+			return xTaskTags[ xIndex ].ucTag;
+		}
+	}
+
+	return MEM_TAG_DEFAULT;
+}
+
+int memTaskBindTag( void *pvTask, uint8_t ucTag )
+{
+	size_t xIndex, xSlot = MEM_TASK_TAG_NUM;
+	int iResult = 0;
+
+	if( ucTag >= MEM_TAG_NUM )
+	{
+		return -1;
+	}
+	if( pvTask == NULL )
+	{
+		pvTask = ( void * ) xTaskGetCurrentTaskHandle();
+	}
+
+	memHEAP_LOCK();
+	{
+		// 已绑定时改写原表项，否则使用第一个空位
+		for( xIndex = 0; xIndex < MEM_TASK_TAG_NUM; xIndex++ )
+		{
+			if( xTaskTags[ xIndex ].pvTask == pvTask )
+			{
+				xSlot = xIndex;
+				break;
+			}
+			if( ( xTaskTags[ xIndex ].pvTask == NULL ) && ( xSlot == MEM_TASK_TAG_NUM ) )
+			{
+				xSlot = xIndex;
+			}
+		}
+
+		if( ucTag == MEM_TAG_DEFAULT )
+		{
+			// 解除绑定
+			if( ( xSlot < MEM_TASK_TAG_NUM ) && ( xTaskTags[ xSlot ].pvTask == pvTask ) )
+			{
+				xTaskTags[ xSlot ].pvTask = NULL;
+			}
+		}
+		else if( xSlot < MEM_TASK_TAG_NUM )
+		{
+			xTaskTags[ xSlot ].pvTask = pvTask;
+			xTaskTags[ xSlot ].ucTag = ucTag;
+		}
+		else
+		{
+			iResult = -1;
+		}
+	}
+	memHEAP_UNLOCK();
+
+	return iResult;
+}
+
+	#endif
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if defined(MEM_QUOTA_EN) && (MEM_QUOTA_EN > 0)
+
+static uint8_t prvQuotaExceeded( uint8_t ucTag, size_t xBlockSize )
+{
+	if( ( xTagQuota[ ucTag ] != 0 ) && ( ( xTagStats[ ucTag ].xLiveBytes + xBlockSize ) > xTagQuota[ ucTag ] ) )
+	{
+		return 1;
+	}
+
+	return 0;
+}
+
+int memTagSetQuota( uint8_t ucTag, size_t xQuotaBytes )
+{
+	if( ucTag >= MEM_TAG_NUM )
+	{
+		return -1;
+	}
+
+	memHEAP_LOCK();
+	{
+		xTagQuota[ ucTag ] = xQuotaBytes;
+	}
+	memHEAP_UNLOCK();
+
+	return 0;
+}
+
+size_t memTagGetQuota( uint8_t ucTag )
+{
+	return ( ucTag < MEM_TAG_NUM ) ? xTagQuota[ ucTag ] : 0;
+}
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if defined(MEM_LATENCY_STAT_EN) && (MEM_LATENCY_STAT_EN > 0)
+
+// 第 i 格统计 [2^i, 2^(i+1)) 的数值，0 和 1 都计入第 0 格
+static size_t prvLog2Bucket( uint32_t ulValue )
+{
+	size_t xBucket = 0;
+
+	while( ( ulValue > 1 ) && ( xBucket < ( MEM_LATENCY_BUCKET_NUM - 1 ) ) )
+	{
+		ulValue >>= 1;
+		xBucket++;
+	}
+
+	return xBucket;
+}
+
+static void prvLatencyRecord( MemLatencyHist_t *pxHist, uint32_t ulCycles, size_t xNodes )
+{
+	pxHist->ulCount++;
+	pxHist->ullTotalCycles += ulCycles;
+	pxHist->ulCycleHist[ prvLog2Bucket( ulCycles ) ]++;
+	if( ulCycles > pxHist->ulMaxCycles )
+	{
+		pxHist->ulMaxCycles = ulCycles;
+	}
+
+	pxHist->ullTotalNodes += xNodes;
+	pxHist->ulNodeHist[ ( xNodes == 0 ) ? 0 : ( prvLog2Bucket( ( uint32_t ) xNodes ) + 1 ) ]++;
+	if( xNodes > pxHist->ulMaxNodes )
+	{
+		pxHist->ulMaxNodes = ( uint32_t ) xNodes;
+	}
+}
+
+void memGetLatencyStat( MemLatencyStat_t *pxStat )
+{
+	if( pxStat == NULL )
+	{
+		return;
+	}
+
+	memHEAP_LOCK();
+	{
+		memcpy( pxStat, &xLatencyStat, sizeof( MemLatencyStat_t ) );
+	}
+	memHEAP_UNLOCK();
+}
+
+void memResetLatencyStat( void )
+{
+#if defined(heapDWT_CYCCNT)
+	// 打开 DWT 周期计数器: DEMCR.TRCENA 和 DWT_CTRL.CYCCNTENA
+	heapDEMCR |= ( 1UL << 24 );
+	heapDWT_CTRL |= 1UL;
+#endif
+
+	memHEAP_LOCK();
+	{
+		memset( &xLatencyStat, 0, sizeof( MemLatencyStat_t ) );
+	}
+	memHEAP_UNLOCK();
+}
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if defined(MEM_WASTE_STAT_EN) && (MEM_WASTE_STAT_EN > 0)
+
+static void prvWasteAdd( MemWasteClass_t *pxClass, size_t xRequestedSize, size_t xWantedSize, size_t xGrantedSize )
+{
+	pxClass->ulCount++;
+	pxClass->ullRequestedBytes += xRequestedSize;
+	pxClass->ullHeaderBytes += xHeapStructSize;
+	pxClass->ullAlignBytes += xWantedSize - xHeapStructSize - xRequestedSize;
+	pxClass->ullSlackBytes += xGrantedSize - xWantedSize;
+	pxClass->ullGrantedBytes += xGrantedSize;
+}
+
+static void prvWasteRecord( size_t xRequestedSize, size_t xWantedSize, size_t xGrantedSize )
+{
+	size_t xClass = 0, xValue = xRequestedSize;
+
+	// 第 i 类统计申请字节数在 [2^i, 2^(i+1)) 的申请，0 和 1 都计入第 0 类
+	while( ( xValue > 1 ) && ( xClass < ( MEM_WASTE_CLASS_NUM - 1 ) ) )
+	{
+		xValue >>= 1;
+		xClass++;
+	}
+
+	prvWasteAdd( &xWasteStat.xTotal, xRequestedSize, xWantedSize, xGrantedSize );
+	prvWasteAdd( &xWasteStat.xClass[ xClass ], xRequestedSize, xWantedSize, xGrantedSize );
+}
+
+void memGetWasteStat( MemWasteStat_t *pxStat )
+{
+	if( pxStat == NULL )
+	{
+		return;
+	}
+
+	memHEAP_LOCK();
+	{
+		memcpy( pxStat, &xWasteStat, sizeof( MemWasteStat_t ) );
+	}
+	memHEAP_UNLOCK();
+}
+
+uint32_t memGetWasteEfficiency( void )
+{
+	uint64_t ullRequested, ullGranted;
+
+	memHEAP_LOCK();
+	{
+		ullRequested = xWasteStat.xTotal.ullRequestedBytes;
+		ullGranted = xWasteStat.xTotal.ullGrantedBytes;
+	}
+	memHEAP_UNLOCK();
+
+	return ( ullGranted > 0 ) ? ( uint32_t ) ( ( ullRequested * 1000U ) / ullGranted ) : 1000U;
+}
+
+void memResetWasteStat( void )
+{
+	memHEAP_LOCK();
+	{
+		memset( &xWasteStat, 0, sizeof( MemWasteStat_t ) );
+	}
+	memHEAP_UNLOCK();
+}
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if !defined(MEM_OOB_META_EN) || (MEM_OOB_META_EN == 0)
+
+static BlockLink_t *prvInsertBlockIntoFreeList( BlockLink_t *pxBlockToInsert )
+{
+    BlockLink_t *pxIterator;
+    uint8_t *puc;
+
+	xFreeBlockNum++;
+
+	/* Iterate through the list until a block is found that has a higher address
+	than the block being inserted. */
+	// 按地址升序的方向插入空闲内存块
+	for( pxIterator = &xStart; heapGET_NEXT( pxIterator ) < pxBlockToInsert; pxIterator = heapGET_NEXT( pxIterator ) )
+	{
+		/* Nothing to do here, just iterate to the right position. */
+		heapCOUNT_NODE();
+	}
+
+	/* Do the block being inserted, and the block it is being inserted after
+	make a contiguous block of memory? */
+	// 左边连续地址的空闲内存块，可以合并
+	puc = ( uint8_t * ) pxIterator;
+	if( ( puc + pxIterator->xBlockSize ) == ( uint8_t * ) pxBlockToInsert )
+	{
+		heapCHECK_ABSORB( pxBlockToInsert, pxIterator );
+		heapZERO_ABSORB( pxIterator, pxBlockToInsert );
+		heapTREE_REMOVE( pxIterator );
+		heapEXACT_REMOVE( pxIterator );
+		pxIterator->xBlockSize += pxBlockToInsert->xBlockSize;
+		pxBlockToInsert = pxIterator;
+		xFreeBlockNum--;
+	}
+	else
+	{
+		MEM_NO_HANDLE(0);
+	}
+
+	/* Do the block being inserted, and the block it is being inserted before
+	make a contiguous block of memory? */
+	puc = ( uint8_t * ) pxBlockToInsert;
+	if( ( puc + pxBlockToInsert->xBlockSize ) == ( uint8_t * ) heapGET_NEXT( pxIterator ) )
+	{
+		// 各区域的结束标记(xBlockSize 为 0)不参与合并，保留在链表中，也不计入 xFreeBlockNum
+		if( heapGET_NEXT( pxIterator )->xBlockSize != 0 )
+		{
+			/* Form one big block from the two blocks. */
+			heapCHECK_ABSORB( heapGET_NEXT( pxIterator ), pxBlockToInsert );
+			heapZERO_ABSORB( pxBlockToInsert, heapGET_NEXT( pxIterator ) );
+			heapTREE_REMOVE( heapGET_NEXT( pxIterator ) );
+			heapEXACT_REMOVE( heapGET_NEXT( pxIterator ) );
+			pxBlockToInsert->xBlockSize += heapGET_NEXT( pxIterator )->xBlockSize;
+			heapSET_NEXT( pxBlockToInsert, heapGET_NEXT( heapGET_NEXT( pxIterator ) ) );
+			xFreeBlockNum--;
+		}
+		else
+		{
+			heapSET_NEXT( pxBlockToInsert, heapGET_NEXT( pxIterator ) );
+		}
+	}
+	else
+	{
+		heapSET_NEXT( pxBlockToInsert, heapGET_NEXT( pxIterator ) );
+	}
+
+	/* If the block being inserted plugged a gab, so was merged with the block
+	before and the block after, then it's pxNextFreeBlock pointer will have
+	already been set, and should not be set here as that would make it point
+	to itself. */
+	if( pxIterator != pxBlockToInsert )
+	{
+		heapSET_NEXT( pxIterator, pxBlockToInsert );
+	}
+	else
+	{
+		MEM_NO_HANDLE(0);
+	}
+
+	heapTREE_LINK( pxIterator, pxBlockToInsert );
+	heapEXACT_LINK( pxIterator, pxBlockToInsert );
+
+	return pxBlockToInsert;
+}
+
+#else
+
+static BlockLink_t *prvInsertBlockIntoFreeList( BlockLink_t *pxBlockToInsert )
+{
+	uint16_t usPrevious = heapOOB_NIL, usNode = usOobHead, usNew;
+	uint32_t ulOffset = ( uint32_t ) ( ( uint8_t * ) pxBlockToInsert - pucOobBase );
+	uint32_t ulSize = ( uint32_t ) pxBlockToInsert->xBlockSize;
+
+	xOobUsedBlockNum--;
+
+	// 按地址升序找到插入位置
+	while( ( usNode != heapOOB_NIL ) && ( xOobNodes[ usNode ].ulOffset < ulOffset ) )
+	{
+		heapCOUNT_NODE();
+		usPrevious = usNode;
+		usNode = xOobNodes[ usNode ].usNext;
+	}
+
+	if( ( usPrevious != heapOOB_NIL ) && ( ( xOobNodes[ usPrevious ].ulOffset + xOobNodes[ usPrevious ].ulSize ) == ulOffset ) )
+	{
+		// 并入左边的空闲块，若同时与右边的空闲块相邻，右边的节点也并入
+		usNew = usPrevious;
+		xOobNodes[ usNew ].ulSize += ulSize;
+		if( ( usNode != heapOOB_NIL ) && ( ( ulOffset + ulSize ) == xOobNodes[ usNode ].ulOffset ) )
+		{
+			xOobNodes[ usNew ].ulSize += xOobNodes[ usNode ].ulSize;
+			xOobNodes[ usNew ].usNext = xOobNodes[ usNode ].usNext;
+			xOobNodes[ usNode ].usNext = usOobPool;
+			usOobPool = usNode;
+			xFreeBlockNum--;
+		}
+	}
+	else if( ( usNode != heapOOB_NIL ) && ( ( ulOffset + ulSize ) == xOobNodes[ usNode ].ulOffset ) )
+	{
+		// 只与右边的空闲块相邻，沿用其节点
+		usNew = usNode;
+		xOobNodes[ usNew ].ulOffset = ulOffset;
+		xOobNodes[ usNew ].ulSize += ulSize;
+	}
+	else
+	{
+		usNew = usOobPool;
+		configASSERT( usNew != heapOOB_NIL );
+		if( usNew == heapOOB_NIL )
+		{
+			return pxBlockToInsert;
+		}
+		usOobPool = xOobNodes[ usNew ].usNext;
+
+		xOobNodes[ usNew ].ulOffset = ulOffset;
+		xOobNodes[ usNew ].ulSize = ulSize;
+		xOobNodes[ usNew ].usNext = usNode;
+		if( usPrevious == heapOOB_NIL )
+		{
+			usOobHead = usNew;
+		}
+		else
+		{
+			xOobNodes[ usPrevious ].usNext = usNew;
+		}
+		xFreeBlockNum++;
+	}
+
+	// 块头中的大小只供 memHeapWalk 使用
+	pxBlockToInsert = heapOOB_BLOCK( usNew );
+	pxBlockToInsert->xBlockSize = xOobNodes[ usNew ].ulSize;
+
+	return pxBlockToInsert;
+}
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if defined(MEM_HOSTED_MMAP_EN) && (MEM_HOSTED_MMAP_EN > 0)
+
+static void prvHostedReleasePages( BlockLink_t *pxBlock, uint8_t *pucFreedStart, uint8_t *pucFreedEnd )
+{
+	size_t xPageMask = xHostedPageSize - 1;
+	size_t xLow, xHigh, xBlockLow, xBlockHigh;
+
+	if( xHostedPageSize == 0 )
+	{
+		return;
+	}
 
-		if( ( pxLink->xBlockSize & xBlockAllocatedBit ) != 0 )
-		{
-			if( pxLink->pxNextFreeBlock == NULL )
-			{
-				/* The block is being returned to the heap - it is no longer
-				allocated. */
-				pxLink->xBlockSize &= ~xBlockAllocatedBit;
+	// 释放范围向外扩展到页面边界，再限制在合并后空闲块的用户区内
+	xLow = ( size_t ) pucFreedStart & ~xPageMask;
+	xHigh = ( ( size_t ) pucFreedEnd + xPageMask ) & ~xPageMask;
+	// 用户区开头的索引信息所在的页面不能归还
+	xBlockLow = ( ( size_t ) pxBlock + xHeapStructSize + heapFREE_META_SIZE + xPageMask ) & ~xPageMask;
+	xBlockHigh = ( ( size_t ) pxBlock + pxBlock->xBlockSize ) & ~xPageMask;
 
-            #if defined(OPERATE_SYSTEM) && (OPERATE_SYSTEM == SYSTEM_FREERTOS)
-	            vTaskSuspendAll();
-            #elif defined(OPERATE_SYSTEM) && (OPERATE_SYSTEM == SYSTEM_NO)
-            #else
-                #error "please define OPERATE_SYSTEM Macro !!!"
-            #endif
-				{
-					/* Add this block to the list of free blocks. */
-					xFreeBytesRemaining += pxLink->xBlockSize;
-					prvInsertBlockIntoFreeList( ( ( BlockLink_t * ) pxLink ) );
-				}
-            #if defined(OPERATE_SYSTEM) && (OPERATE_SYSTEM == SYSTEM_FREERTOS)
-	            ( void ) xTaskResumeAll();
-            #elif defined(OPERATE_SYSTEM) && (OPERATE_SYSTEM == SYSTEM_NO)
-            #else
-                #error "please define OPERATE_SYSTEM Macro !!!"
-            #endif
+	if( xLow < xBlockLow )
+	{
+		xLow = xBlockLow;
+	}
+	if( xHigh > xBlockHigh )
+	{
+		xHigh = xBlockHigh;
+	}
 
-			}
-			else
-			{
-				MEM_NO_HANDLE(0);
-			}
-		}
-		else
+	if( ( xHigh > xLow ) && ( ( xHigh - xLow ) >= MEM_HOSTED_RELEASE_THRESHOLD ) )
+	{
+		if( madvise( ( void * ) xLow, xHigh - xLow, MEM_HOSTED_MADVISE ) == 0 )
 		{
-			MEM_NO_HANDLE(0);
+			xHostedReleasedBytes += xHigh - xLow;
 		}
 	}
 }
-/*-----------------------------------------------------------*/
 
-size_t memGetFreeHeapSize( void )
+uint8_t *memHostedRegionMap( size_t xSizeInBytes )
 {
-	return xFreeBytesRemaining;
+	void *pvRegion;
+
+	if( xHostedPageSize == 0 )
+	{
+		xHostedPageSize = ( size_t ) sysconf( _SC_PAGESIZE );
+	}
+
+	xSizeInBytes = ( xSizeInBytes + xHostedPageSize - 1 ) & ~( xHostedPageSize - 1 );
+	pvRegion = mmap( NULL, xSizeInBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0 );
+	if( pvRegion == MAP_FAILED )
+	{
+		return NULL;
+	}
+
+	return ( uint8_t * ) pvRegion;
 }
-/*-----------------------------------------------------------*/
 
-size_t memGetMinimumEverFreeHeapSize( void )
+void memHostedRegionUnmap( uint8_t *pucStartAddress, size_t xSizeInBytes )
 {
-	return xMinimumEverFreeBytesRemaining;
+	if( pucStartAddress != NULL )
+	{
+		( void ) munmap( pucStartAddress, xSizeInBytes );
+	}
 }
 
-size_t memGetFreeBlockNum( void )
+size_t memHostedGetReleasedBytes( void )
 {
-	return xFreeBlockNum;
+	return xHostedReleasedBytes;
 }
 
-// {"xMemFreeListLayout":[12,12],"num":2}
-void memPrintfFreeListLayout(void)
+#endif
+/*-----------------------------------------------------------*/
+
+#if defined(MEM_POSTMORTEM_EN) && (MEM_POSTMORTEM_EN > 0)
+
+static uint32_t prvPostMortemChecksum( const MemPostMortem_t *pxPostMortem )
 {
-	BlockLink_t *pxIterator = &xStart;
-	size_t num = 0,freeBlockTotalSize = 0;
+	const uint32_t *pulWord = ( const uint32_t * ) pxPostMortem;
+	size_t xWordNum = offsetof( MemPostMortem_t, ulChecksum ) / sizeof( uint32_t );
+	uint32_t ulSum = 0x5A5A5A5AUL;
 
-	MEM_MANAGE_PRINTF("\n{\"xMemFreeListLayout\":[");
-	while(pxIterator->pxNextFreeBlock != NULL)
+	while( xWordNum-- > 0 )
 	{
-		if(pxIterator->xBlockSize > 0) {
-			// MEM_MANAGE_PRINTF("{\"size\":%ld,\"0x\"%08x},",pxIterator->xBlockSize,(size_t)(pxIterator));
-			MEM_MANAGE_PRINTF("%ld,",pxIterator->xBlockSize);
-			freeBlockTotalSize += pxIterator->xBlockSize;
-			num++;
-		}
-		pxIterator = pxIterator->pxNextFreeBlock;
+		ulSum = ( ( ulSum << 5 ) | ( ulSum >> 27 ) ) ^ *pulWord++;
 	}
-	MEM_MANAGE_PRINTF("%ld],\"num\":%d}\n",freeBlockTotalSize,num);
-}
 
-/*-----------------------------------------------------------*/
+	return ulSum;
+}
 
-static void prvInsertBlockIntoFreeList( BlockLink_t *pxBlockToInsert )
+void memPostMortemCapture( size_t xWantedSize )
 {
-    BlockLink_t *pxIterator;
-    uint8_t *puc;
-
-	xFreeBlockNum++;
+	MemPostMortem_t *pxPostMortem = &xMemPostMortem;
+	BlockLink_t *pxBlock;
+	uint32_t ulFailCount = 0;
+	size_t xBucket, xSize;
+#if defined(MEM_OOB_META_EN) && (MEM_OOB_META_EN > 0)
+	uint16_t usNode;
+#endif
+#if defined(MEM_TAG_EN) && (MEM_TAG_EN > 0)
+	MemPostMortemTag_t *pxTags = pxPostMortem->xTags;
+	size_t xTag, xPos, xTagNum = 0;
+#endif
 
-	/* Iterate through the list until a block is found that has a higher address
-	than the block being inserted. */
-	// 按地址升序的方向插入空闲内存块
-	for( pxIterator = &xStart; pxIterator->pxNextFreeBlock < pxBlockToInsert; pxIterator = pxIterator->pxNextFreeBlock )
+	// 上一次的快照还有效时累计失败次数
+	if( memPostMortemGet() != NULL )
 	{
-		/* Nothing to do here, just iterate to the right position. */
+		ulFailCount = pxPostMortem->ulFailCount;
 	}
 
-	/* Do the block being inserted, and the block it is being inserted after
-	make a contiguous block of memory? */
-	// 左边连续地址的空闲内存块，可以合并
-	puc = ( uint8_t * ) pxIterator;
-	if( ( puc + pxIterator->xBlockSize ) == ( uint8_t * ) pxBlockToInsert )
-	{
-		pxIterator->xBlockSize += pxBlockToInsert->xBlockSize;
-		pxBlockToInsert = pxIterator;
-		xFreeBlockNum--;
-	}
-	else
-	{
-		MEM_NO_HANDLE(0);
-	}
+	memset( pxPostMortem, 0, sizeof( MemPostMortem_t ) );
+	pxPostMortem->ulMagic = MEM_POSTMORTEM_MAGIC;
+	pxPostMortem->usVersion = MEM_POSTMORTEM_VERSION;
+	pxPostMortem->usBlockCapacity = MEM_POSTMORTEM_BLOCK_NUM;
+	pxPostMortem->ulFailCount = ulFailCount + 1;
+	pxPostMortem->ulWantedSize = ( uint32_t ) xWantedSize;
 
-	/* Do the block being inserted, and the block it is being inserted before
-	make a contiguous block of memory? */
-	puc = ( uint8_t * ) pxBlockToInsert;
-	if( ( puc + pxBlockToInsert->xBlockSize ) == ( uint8_t * ) pxIterator->pxNextFreeBlock )
+	memHEAP_LOCK();
 	{
-		if( pxIterator->pxNextFreeBlock != pxEnd )
+		pxPostMortem->ulFreeBytesRemaining = ( uint32_t ) xFreeBytesRemaining;
+		pxPostMortem->ulMinimumEverFreeBytesRemaining = ( uint32_t ) xMinimumEverFreeBytesRemaining;
+		pxPostMortem->ulFreeBlockNum = ( uint32_t ) xFreeBlockNum;
+
+		pxPostMortem->usTagCapacity = MEM_POSTMORTEM_TAG_NUM;
+	#if defined(MEM_TAG_EN) && (MEM_TAG_EN > 0)
+		// 插入排序保留存活字节数最多的几个标签，相同时标签号小的在前；从未使用过的标签不记录
+		for( xTag = 0; xTag < MEM_TAG_NUM; xTag++ )
 		{
-			/* Form one big block from the two blocks. */
-			pxBlockToInsert->xBlockSize += pxIterator->pxNextFreeBlock->xBlockSize;
-			pxBlockToInsert->pxNextFreeBlock = pxIterator->pxNextFreeBlock->pxNextFreeBlock;
-			xFreeBlockNum--;
+			if( xTagStats[ xTag ].xPeakBytes == 0 )
+			{
+				continue;
+			}
+			for( xPos = xTagNum; ( xPos > 0 ) && ( pxTags[ xPos - 1 ].ulLiveBytes < ( uint32_t ) xTagStats[ xTag ].xLiveBytes ); xPos-- )
+			{
+				if( xPos < MEM_POSTMORTEM_TAG_NUM )
+				{
+					pxTags[ xPos ] = pxTags[ xPos - 1 ];
+				}
+			}
+			if( xPos < MEM_POSTMORTEM_TAG_NUM )
+			{
+				pxTags[ xPos ].ucTag = ( uint8_t ) xTag;
+				pxTags[ xPos ].ulLiveBytes = ( uint32_t ) xTagStats[ xTag ].xLiveBytes;
+				pxTags[ xPos ].ulLiveCount = ( uint32_t ) xTagStats[ xTag ].xLiveCount;
+				pxTags[ xPos ].ulPeakBytes = ( uint32_t ) xTagStats[ xTag ].xPeakBytes;
+				if( xTagNum < MEM_POSTMORTEM_TAG_NUM )
+				{
+					xTagNum++;
+				}
+			}
 		}
-		else
+		pxPostMortem->usTagNum = ( uint16_t ) xTagNum;
+	#endif
+
+	#if defined(MEM_OOB_META_EN) && (MEM_OOB_META_EN > 0)
+		for( usNode = ( pxEnd != NULL ) ? usOobHead : heapOOB_NIL; usNode != heapOOB_NIL; usNode = xOobNodes[ usNode ].usNext )
 		{
-			pxBlockToInsert->pxNextFreeBlock = pxEnd;
+			pxBlock = heapOOB_BLOCK( usNode );
+			xSize = xOobNodes[ usNode ].ulSize;
+	#else
+		for( pxBlock = ( pxEnd != NULL ) ? heapGET_NEXT( &xStart ) : NULL; ( pxBlock != NULL ) && ( pxBlock != pxEnd ); pxBlock = heapGET_NEXT( pxBlock ) )
+		{
+			xSize = pxBlock->xBlockSize;
+	#endif
+			if( xSize == 0 )
+			{
+				continue;	// 区域结束标记
+			}
+
+			if( pxPostMortem->ulWalkedBlockNum >= MEM_POSTMORTEM_WALK_MAX )
+			{
+				pxPostMortem->ulFlags |= MEM_POSTMORTEM_FLAG_TRUNCATED;
+				break;
+			}
+			pxPostMortem->ulWalkedBlockNum++;
+
+			if( xSize > pxPostMortem->ulLargestFreeBlock )
+			{
+				pxPostMortem->ulLargestFreeBlock = ( uint32_t ) xSize;
+			}
+
+			for( xBucket = 0; ( xBucket < ( MEM_POSTMORTEM_HIST_NUM - 1 ) ) && ( xSize >= ( ( size_t ) 32 << xBucket ) ); xBucket++ )
+			{
+			}
+			pxPostMortem->ulSizeHistogram[ xBucket ]++;
+
+			if( pxPostMortem->ulBlockNum < MEM_POSTMORTEM_BLOCK_NUM )
+			{
+				pxPostMortem->xBlocks[ pxPostMortem->ulBlockNum ].ulOffset = ( uint32_t ) ( ( size_t ) pxBlock - ( size_t ) xRegionBounds[ 0 ].pxFirstBlock );
+				pxPostMortem->xBlocks[ pxPostMortem->ulBlockNum ].ulSize = ( uint32_t ) xSize;
+				pxPostMortem->ulBlockNum++;
+			}
 		}
 	}
-	else
-	{
-		pxBlockToInsert->pxNextFreeBlock = pxIterator->pxNextFreeBlock;
-	}
+	memHEAP_UNLOCK();
 
-	/* If the block being inserted plugged a gab, so was merged with the block
-	before and the block after, then it's pxNextFreeBlock pointer will have
-	already been set, and should not be set here as that would make it point
-	to itself. */
-	if( pxIterator != pxBlockToInsert )
-	{
-		pxIterator->pxNextFreeBlock = pxBlockToInsert;
-	}
-	else
+	pxPostMortem->ulChecksum = prvPostMortemChecksum( pxPostMortem );
+}
+
+const MemPostMortem_t *memPostMortemGet( void )
+{
+	if( ( xMemPostMortem.ulMagic != MEM_POSTMORTEM_MAGIC ) || ( xMemPostMortem.usVersion != MEM_POSTMORTEM_VERSION )
+		|| ( xMemPostMortem.ulChecksum != prvPostMortemChecksum( &xMemPostMortem ) ) )
 	{
-		MEM_NO_HANDLE(0);
+		return NULL;
 	}
+
+	return &xMemPostMortem;
 }
+
+void memPostMortemClear( void )
+{
+	memset( &xMemPostMortem, 0, sizeof( MemPostMortem_t ) );
+}
+
+#endif
 /*-----------------------------------------------------------*/
 
 static void memDefineHeapRegions( const MemHeapRegion_t * const pxHeapRegions )
@@ -413,6 +4087,21 @@ static void memDefineHeapRegions( const MemHeapRegion_t * const pxHeapRegions )
 	/* Can only call once! */
 	configASSERT( pxEnd == NULL );
 
+#if defined(MEM_PERSIST_EN) && (MEM_PERSIST_EN > 0)
+	if( prvPersistAttach( pxHeapRegions ) != 0 )
+	{
+		memPrintfFreeListLayout();
+		return;
+	}
+#endif
+
+#if defined(MEM_HOSTED_MMAP_EN) && (MEM_HOSTED_MMAP_EN > 0)
+	if( xHostedPageSize == 0 )
+	{
+		xHostedPageSize = ( size_t ) sysconf( _SC_PAGESIZE );
+	}
+#endif
+
 	pxHeapRegion = &( pxHeapRegions[ xDefinedRegions ] );
 
 	while( pxHeapRegion->xSizeInBytes > 0 )
@@ -430,14 +4119,21 @@ static void memDefineHeapRegions( const MemHeapRegion_t * const pxHeapRegions )
 			xTotalRegionSize -= xAddress - ( size_t ) pxHeapRegion->pucStartAddress;
 		}
 
+	#if defined(MEM_PERSIST_EN) && (MEM_PERSIST_EN > 0)
+		// 区域起始处留给持久化描述信息
+		xAddress += xPersistHeaderSize;
+		xTotalRegionSize -= xPersistHeaderSize;
+	#endif
+
 		xAlignedHeap = xAddress;
 
 		/* Set xStart if it has not already been set. */
 		if( xDefinedRegions == 0 )
 		{
+
 			/* xStart is used to hold a pointer to the first item in the list of
 			free blocks.  The void cast is used to prevent compiler warnings. */
-			xStart.pxNextFreeBlock = ( BlockLink_t * ) xAlignedHeap;
+			heapSET_NEXT( &xStart, ( BlockLink_t * ) xAlignedHeap );
 			xStart.xBlockSize = ( size_t ) 0;
 		}
 		else
@@ -461,24 +4157,40 @@ static void memDefineHeapRegions( const MemHeapRegion_t * const pxHeapRegions )
 		xAddress &= ~memBYTE_ALIGNMENT_MASK;
 		pxEnd = ( BlockLink_t * ) xAddress;
 		pxEnd->xBlockSize = 0;
-		pxEnd->pxNextFreeBlock = NULL;
+		heapSET_NEXT( pxEnd, NULL );
 
 		/* To start with there is a single free block in this region that is
 		sized to take up the entire heap region minus the space taken by the
 		free block structure. */
 		pxFirstFreeBlockInRegion = ( BlockLink_t * ) xAlignedHeap;
 		pxFirstFreeBlockInRegion->xBlockSize = xAddress - ( size_t ) pxFirstFreeBlockInRegion;
-		pxFirstFreeBlockInRegion->pxNextFreeBlock = pxEnd;
+		heapSET_NEXT( pxFirstFreeBlockInRegion, pxEnd );
+	#if defined(MEM_ZERO_EN) && (MEM_ZERO_EN > 0)
+		#if defined(MEM_HOSTED_MMAP_EN) && (MEM_HOSTED_MMAP_EN > 0) && ( !defined(MEM_PERSIST_EN) || (MEM_PERSIST_EN == 0) )
+		// memHostedRegionMap 新映射的区域内容为 0
+		heapZERO_MARK( pxFirstFreeBlockInRegion ) = heapZERO_MAGIC;
+		#else
+		heapZERO_CLEAR( pxFirstFreeBlockInRegion );
+		#endif
+	#endif
 
 		/* If this is not the first region that makes up the entire heap space
 		then link the previous region to this region. */
 		if( pxPreviousFreeBlock != NULL )
 		{
-			pxPreviousFreeBlock->pxNextFreeBlock = pxFirstFreeBlockInRegion;
+			heapSET_NEXT( pxPreviousFreeBlock, pxFirstFreeBlockInRegion );
 		}
 
 		xTotalHeapSize += pxFirstFreeBlockInRegion->xBlockSize;
 
+		configASSERT( xDefinedRegions < MEM_HEAP_REGION_MAX );
+		if( xDefinedRegions < MEM_HEAP_REGION_MAX )
+		{
+			xRegionBounds[ xDefinedRegions ].pxFirstBlock = pxFirstFreeBlockInRegion;
+			xRegionBounds[ xDefinedRegions ].pxEndMarker = pxEnd;
+			xRegionNum = xDefinedRegions + 1;
+		}
+
 		xFreeBlockNum++;
 		/* Move onto the next MemHeapRegion_t structure. */
 		xDefinedRegions++;
@@ -491,12 +4203,166 @@ static void memDefineHeapRegions( const MemHeapRegion_t * const pxHeapRegions )
 	/* Check something was actually defined before it is accessed. */
 	configASSERT( xTotalHeapSize );
 
+#if defined(MEM_OOB_META_EN) && (MEM_OOB_META_EN > 0)
+	prvOobInit();
+#endif
+#if defined(MEM_TREE_INDEX_EN) && (MEM_TREE_INDEX_EN > 0)
+	prvTreeInit();
+#endif
+#if defined(MEM_EXACT_FIT_EN) && (MEM_EXACT_FIT_EN > 0)
+	prvExactInit();
+#endif
+
 	/* Work out the position of the top bit in a size_t variable. */
 	xBlockAllocatedBit = ( ( size_t ) 1 ) << ( ( sizeof( size_t ) * heapBITS_PER_BYTE ) - 1 );
 
+#if defined(MEM_PERSIST_EN) && (MEM_PERSIST_EN > 0)
+	// 新建的堆尚未同步，重启后不会被接管
+	memset( pxPersistHeader, 0, sizeof( MemPersistHeader_t ) );
+	pxPersistHeader->ulMagic = heapPERSIST_MAGIC;
+	pxPersistHeader->ulVersion = heapPERSIST_VERSION;
+	pxPersistHeader->xRegionSize = pxHeapRegions[ 0 ].xSizeInBytes;
+#endif
+
 	memPrintfFreeListLayout();
 }
 
+#if defined(MEM_PERSIST_EN) && (MEM_PERSIST_EN > 0)
+
+static int prvPersistAttach( const MemHeapRegion_t * const pxHeapRegions )
+{
+	size_t xAddress;
+
+	/* 持久化堆只支持一个区域. */
+	configASSERT( pxHeapRegions[ 0 ].xSizeInBytes > 0 );
+	configASSERT( pxHeapRegions[ 1 ].xSizeInBytes == 0 );
+
+	xAddress = ( size_t ) pxHeapRegions[ 0 ].pucStartAddress;
+	xAddress = ( xAddress + ( memBYTE_ALIGNMENT - 1 ) ) & ~memBYTE_ALIGNMENT_MASK;
+	pucPersistBase = ( uint8_t * ) xAddress;
+	pxPersistHeader = ( MemPersistHeader_t * ) pucPersistBase;
+	xPersistWarmStart = 0;
+
+	if( ( pxPersistHeader->ulMagic != heapPERSIST_MAGIC ) || ( pxPersistHeader->ulVersion != heapPERSIST_VERSION )
+		|| ( pxPersistHeader->xRegionSize != pxHeapRegions[ 0 ].xSizeInBytes ) || ( pxPersistHeader->ulClean != 1 ) )
+	{
+		return 0;
+	}
+
+	xStart.xNextFreeOffset = pxPersistHeader->xStartNextOffset;
+	xStart.xBlockSize = ( size_t ) 0;
+	pxEnd = ( BlockLink_t * ) ( pucPersistBase + pxPersistHeader->xEndOffset );
+	xFreeBytesRemaining = pxPersistHeader->xFreeBytesRemaining;
+	xMinimumEverFreeBytesRemaining = pxPersistHeader->xMinimumEverFreeBytesRemaining;
+	xFreeBlockNum = pxPersistHeader->xFreeBlockNum;
+	xBlockAllocatedBit = ( ( size_t ) 1 ) << ( ( sizeof( size_t ) * heapBITS_PER_BYTE ) - 1 );
+	xRegionBounds[ 0 ].pxFirstBlock = ( BlockLink_t * ) ( pucPersistBase + xPersistHeaderSize );
+	xRegionBounds[ 0 ].pxEndMarker = pxEnd;
+	xRegionNum = 1;
+	xPersistWarmStart = 1;
+
+	return 1;
+}
+
+uint8_t *memPersistMapFile( const char *pcPath, size_t xSizeInBytes )
+{
+	struct stat xStat;
+	void *pvRegion;
+	int iFd;
+
+	iFd = open( pcPath, O_RDWR | O_CREAT, 0644 );
+	if( iFd < 0 )
+	{
+		return NULL;
+	}
+
+	if( ( fstat( iFd, &xStat ) != 0 )
+		|| ( ( ( size_t ) xStat.st_size < xSizeInBytes ) && ( ftruncate( iFd, ( off_t ) xSizeInBytes ) != 0 ) ) )
+	{
+		( void ) close( iFd );
+		return NULL;
+	}
+
+	pvRegion = mmap( NULL, xSizeInBytes, PROT_READ | PROT_WRITE, MAP_SHARED, iFd, 0 );
+	( void ) close( iFd );
+	if( pvRegion == MAP_FAILED )
+	{
+		return NULL;
+	}
+
+	return ( uint8_t * ) pvRegion;
+}
+
+void memPersistUnmapFile( uint8_t *pucStartAddress, size_t xSizeInBytes )
+{
+	if( pucStartAddress != NULL )
+	{
+		( void ) munmap( pucStartAddress, xSizeInBytes );
+	}
+}
+
+int memPersistSync( void )
+{
+	if( pxPersistHeader == NULL )
+	{
+		return -1;
+	}
+
+	memHEAP_LOCK();
+	{
+	#if defined(MEM_QUICK_FIT_EN) && (MEM_QUICK_FIT_EN > 0)
+		// 快速链表不在文件中保存，先合并回空闲链表
+		( void ) prvQuickListFlushAll();
+		heapCHECK_TOUCH();
+	#endif
+		pxPersistHeader->xStartNextOffset = xStart.xNextFreeOffset;
+		pxPersistHeader->xEndOffset = heapPERSIST_OFFSET( pxEnd );
+		pxPersistHeader->xFreeBytesRemaining = xFreeBytesRemaining;
+		pxPersistHeader->xMinimumEverFreeBytesRemaining = xMinimumEverFreeBytesRemaining;
+		pxPersistHeader->xFreeBlockNum = xFreeBlockNum;
+		pxPersistHeader->ulClean = 1;
+	}
+	memHEAP_UNLOCK();
+
+	return ( msync( pucPersistBase, pxPersistHeader->xRegionSize, MS_SYNC ) == 0 ) ? 0 : -1;
+}
+
+int memPersistIsWarmStart( void )
+{
+	return xPersistWarmStart;
+}
+
+void memPersistSetRoot( void *pvRoot )
+{
+	if( pxPersistHeader != NULL )
+	{
+		pxPersistHeader->xRootOffset = heapPERSIST_OFFSET( pvRoot );
+	}
+}
+
+void *memPersistGetRoot( void )
+{
+	if( pxPersistHeader == NULL )
+	{
+		return NULL;
+	}
+
+	return heapPERSIST_POINTER( pxPersistHeader->xRootOffset );
+}
+
+size_t memPersistOffsetOf( const void *pv )
+{
+	return heapPERSIST_OFFSET( pv );
+}
+
+void *memPersistPointerOf( size_t xOffset )
+{
+	return heapPERSIST_POINTER( xOffset );
+}
+
+#endif
+/*-----------------------------------------------------------*/
+
 int memManageFunctionInit(mem_manage_t *mem_manage, const MemHeapRegion_t * const pxHeapRegions)
 {
 	if( mem_manage == NULL )
@@ -504,66 +4370,119 @@ int memManageFunctionInit(mem_manage_t *mem_manage, const MemHeapRegion_t * cons
 
 	memcpy(&xMemManage,mem_manage,sizeof(mem_manage_t));
 	memDefineHeapRegions(pxHeapRegions);
+#if defined(MEM_QUICK_FIT_EN) && (MEM_QUICK_FIT_EN > 0) && defined(MEM_QUICK_ADAPT_EN) && (MEM_QUICK_ADAPT_EN > 0)
+	prvQuickAdaptInit();
+#endif
+#if defined(MEM_LATENCY_STAT_EN) && (MEM_LATENCY_STAT_EN > 0)
+	memResetLatencyStat();
+#endif
+#if defined(MEM_TRACE_EN) && (MEM_TRACE_EN > 0)
+	memTraceReset();
+#endif
+#if defined(MEM_PROFILE_EN) && (MEM_PROFILE_EN > 0)
+	memProfileReset();
+#endif
+#if defined(MEM_TAG_EN) && (MEM_TAG_EN > 0)
+	prvTagRecount();
+#endif
+#if defined(MEM_WASTE_STAT_EN) && (MEM_WASTE_STAT_EN > 0)
+	memResetWasteStat();
+#endif
+#if defined(MEM_CHECK_EN) && (MEM_CHECK_EN > 0)
+	prvCheckReset();
+#endif
+#if defined(MEM_ZERO_EN) && (MEM_ZERO_EN > 0)
+	pxZeroCursor = NULL;
+	xZeroDone = 0;
+#endif
+#if defined(MEM_RESERVE_EN) && (MEM_RESERVE_EN > 0)
+	// 在统计类功能初始化之后预留，储备不记入任何标签
+	pxReserveBlock = NULL;
+	xReserveBlockSize = 0;
+	memHEAP_LOCK();
+	prvReserveFill();
+	memHEAP_UNLOCK();
+#endif
 	return 0;
 }
 
-// void* pvPortReAlloc( void *pv,  size_t xWantedSize )
-// {
-// 	BlockLink_t *pxLink;
-// 	unsigned char *puc = ( unsigned char * ) pv;
-
-// 	if( pv )
-// 	{
-// 		if( !xWantedSize )
-// 		{
-// 			memFree( pv );
-// 			return NULL;
-// 		}
-
-// 		void *newArea = memMalloc( xWantedSize );
-// 		if( newArea )
-// 		{
-// 			/* The memory being freed will have an xBlockLink structure immediately
-// 				before it. */
-// 			puc -= xHeapStructSize;
-
-// 			/* This casting is to keep the compiler from issuing warnings. */
-// 			pxLink = ( void * ) puc;
-
-// 			int oldSize =  (pxLink->xBlockSize & ~xBlockAllocatedBit) - xHeapStructSize;
-// 			int copySize = ( oldSize < xWantedSize ) ? oldSize : xWantedSize;
-// 			memcpy( newArea, pv, copySize );
-
-// 			vTaskSuspendAll();
-// 			{
-// 				/* Add this block to the list of free blocks. */
-// 				pxLink->xBlockSize &= ~xBlockAllocatedBit;
-// 				xFreeBytesRemaining += pxLink->xBlockSize;
-// 				prvInsertBlockIntoFreeList( ( ( BlockLink_t * ) pxLink ) );
-// 			}
-// 			xTaskResumeAll();
-// 			return newArea;
-// 		}
-// 	}
-// 	else if( xWantedSize )
-// 		return memMalloc( xWantedSize );
-// 	else
-// 		return NULL;
-
-// 	return NULL;
-// }
+void *pvPortReAlloc( void *pv, size_t xWantedSize )
+{
+	BlockLink_t *pxLink;
+	MemAllocCall_t xCall;
+	void *pvNew;
+	size_t xOldSize;
+#if defined(MEM_TRACE_EN) && (MEM_TRACE_EN > 0)
+	size_t xTraceArgs[ 3 ];
+#endif
+
+	xCall.xCaller = MEM_TRACE_CALLER();
+	xCall.ucTag = MEM_TAG_DEFAULT;
+	xCall.ucFlags = 0;
+
+	if( pv == NULL )
+	{
+		xCall.ucTraceOp = MEM_TRACE_OP_MALLOC;
+		return prvMalloc( xWantedSize, &xCall );
+	}
+
+	if( xWantedSize == 0 )
+	{
+		xCall.ucTraceOp = MEM_TRACE_OP_FREE;
+		prvFree( pv, &xCall );
+		return NULL;
+	}
+
+	/* The memory being freed will have an BlockLink_t structure immediately
+	before it. */
+	pxLink = ( BlockLink_t * ) ( ( uint8_t * ) pv - xHeapStructSize );
+	xOldSize = ( pxLink->xBlockSize & ~heapBLOCK_FLAGS ) - xHeapStructSize;
+#if defined(MEM_TAG_EN) && (MEM_TAG_EN > 0)
+	xCall.ucTag = heapGET_TAG( pxLink );
+#endif
+
+	// 新旧内存块的申请和释放不单独记录，由一条 realloc 记录代替
+	xCall.ucTraceOp = MEM_TRACE_OP_NONE;
+	pvNew = prvMalloc( xWantedSize, &xCall );
+
+#if defined(MEM_TRACE_EN) && (MEM_TRACE_EN > 0)
+	memHEAP_LOCK();
+	{
+		xTraceArgs[ 0 ] = heapTRACE_OFFSET( pv );
+		xTraceArgs[ 1 ] = xWantedSize;
+		xTraceArgs[ 2 ] = heapTRACE_OFFSET( pvNew );
+		prvTraceRecord( MEM_TRACE_OP_REALLOC, heapTRACE_CALLER( xCall.xCaller ), xTraceArgs, 3 );
+	}
+	memHEAP_UNLOCK();
+#endif
+
+	// 申请失败时原内存块保持不变
+	if( pvNew != NULL )
+	{
+		memcpy( pvNew, pv, ( xOldSize < xWantedSize ) ? xOldSize : xWantedSize );
+		prvFree( pv, &xCall );
+	}
+
+	return pvNew;
+}
 
 void *pvPortCalloc(size_t xWantedCnt, size_t xWantedSize)
 {
-	void *p;
+	MemAllocCall_t xCall;
 
-	/* allocate 'xWantedCnt' objects of size 'xWantedSize' */
-	p = memMalloc(xWantedCnt * xWantedSize);
-	if (p) {
-		/* zero the memory */
-		memset(p, 0, xWantedCnt * xWantedSize);
+	xCall.ucTraceOp = MEM_TRACE_OP_CALLOC;
+	xCall.xCaller = MEM_TRACE_CALLER();
+	xCall.ucTag = MEM_TAG_DEFAULT;
+	xCall.ucFlags = 0;
+
+	// 个数与大小的乘积溢出时按申请失败处理
+	if( ( xWantedSize != 0 ) && ( xWantedCnt > ( ( size_t ) -1 ) / xWantedSize ) )
+	{
+		return NULL;
 	}
-	return p;
+
+	/* allocate 'xWantedCnt' objects of size 'xWantedSize', zeroed by prvMalloc */
+	return prvMalloc(xWantedCnt * xWantedSize, &xCall);
 }
 
 
@@ -0,0 +1,387 @@
+/**
+ * @file: mem_workload.c
+ * @author: LinusZhao
+ * @brief: 合成负载生成器的实现
+ * @version: 1.0.0
+ * @date: 2021-01-01
+ **/
+
+#include "mem_workload.h"
+
+/* 生产者/消费者之间的内存屏障: 先写槽位，再移动队列下标 */
+#if defined(__GNUC__) || defined(__clang__)
+	#define memWL_BARRIER()		__sync_synchronize()
+#elif defined(__CC_ARM)
+	#define memWL_BARRIER()		__dmb( 0xF )
+#else
+	#define memWL_BARRIER()
+#endif
+
+#define memWL_LN2_Q16		45426U		// ln(2) * 65536
+
+static uint32_t prvRand( uint32_t *pulState )
+{
+	uint32_t x = *pulState;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*pulState = x;
+	return x;
+}
+
+static uint32_t prvRandRange( uint32_t *pulState, uint32_t ulLow, uint32_t ulHigh )
+{
+	if( ulHigh <= ulLow )
+		return ulLow;
+	return ulLow + prvRand( pulState ) % ( ulHigh - ulLow + 1 );
+}
+
+static uint32_t prvLog2Floor( uint32_t x )
+{
+	uint32_t n = 0;
+
+	while( x > 1 )
+	{
+		x >>= 1;
+		n++;
+	}
+	return n;
+}
+
+/* log2(x)，Q16 定点；小数部分用 log2(1+f) ≈ f + 0.3466*f*(1-f) 近似，误差小于 0.01 */
+static uint32_t prvLog2Q16( uint32_t x )
+{
+	uint32_t ulInt = prvLog2Floor( x );
+	uint32_t ulFrac;
+
+	ulFrac = ( ulInt >= 16 ) ? ( ( x >> ( ulInt - 16 ) ) & 0xFFFFU ) : ( ( x << ( 16 - ulInt ) ) & 0xFFFFU );
+	ulFrac += ( uint32_t )( ( ( ( uint64_t )ulFrac * ( 65536U - ulFrac ) ) >> 16 ) * 22713U >> 16 );
+	return ( ulInt << 16 ) + ulFrac;
+}
+
+static uint32_t prvNextSize( uint32_t *pulState, const MemWorkloadPhase_t *pxPhase )
+{
+	uint32_t ulSize, ulLow, ulHigh, r;
+
+	switch( pxPhase->eSizeDist )
+	{
+	case MEM_WL_SIZE_EXPONENTIAL:
+		// 反函数法: size = -mean * ln(u)，u 取 (0, 1]
+		r = ( prvRand( pulState ) >> 1 ) + 1;
+		ulSize = ( uint32_t )( ( ( uint64_t )pxPhase->ulSizeMean * ( ( 31U << 16 ) - prvLog2Q16( r ) ) * memWL_LN2_Q16 ) >> 32 );
+		break;
+	case MEM_WL_SIZE_BIMODAL:
+		if( ( prvRand( pulState ) % 100 ) < pxPhase->ucLargePercent )
+			ulSize = prvRandRange( pulState, pxPhase->ulSizeLarge, pxPhase->ulSizeMax );
+		else
+			ulSize = prvRandRange( pulState, pxPhase->ulSizeMin, pxPhase->ulSizeSmall );
+		break;
+	case MEM_WL_SIZE_POW2:
+		ulLow = prvLog2Floor( pxPhase->ulSizeMin );
+		if( ( 1UL << ulLow ) < pxPhase->ulSizeMin )
+			ulLow++;
+		ulHigh = prvLog2Floor( pxPhase->ulSizeMax );
+		ulSize = ( uint32_t )1U << prvRandRange( pulState, ulLow, ( ulHigh < ulLow ) ? ulLow : ulHigh );
+		break;
+	case MEM_WL_SIZE_UNIFORM:
+	default:
+		ulSize = prvRandRange( pulState, pxPhase->ulSizeMin, pxPhase->ulSizeMax );
+		break;
+	}
+
+	if( ulSize < pxPhase->ulSizeMin )
+		ulSize = pxPhase->ulSizeMin;
+	if( ulSize > pxPhase->ulSizeMax )
+		ulSize = pxPhase->ulSizeMax;
+	return ( ulSize == 0 ) ? 1 : ulSize;
+}
+
+static uint32_t prvPermille( uint64_t ullPart, uint64_t ullTotal )
+{
+	return ( ullTotal == 0 ) ? 0 : ( uint32_t )( ( ullPart * 1000U ) / ullTotal );
+}
+
+/* 1 - 最大空闲块 / 剩余字节，调用者已加锁 */
+static uint32_t prvFragmentation( const MemWorkloadConfig_t *pxConfig )
+{
+	size_t xFree, xLargest;
+
+	if( ( pxConfig->pfFreeBytes == NULL ) || ( pxConfig->pfLargestFree == NULL ) )
+		return 0;
+	xFree = pxConfig->pfFreeBytes();
+	xLargest = pxConfig->pfLargestFree();
+	if( ( xFree == 0 ) || ( xLargest > xFree ) )
+		return 0;
+	return 1000U - prvPermille( xLargest, xFree );
+}
+
+static void prvLock( const MemWorkloadConfig_t *pxConfig )
+{
+	if( pxConfig->pfLock != NULL )
+		pxConfig->pfLock();
+}
+
+static void prvUnlock( const MemWorkloadConfig_t *pxConfig )
+{
+	if( pxConfig->pfUnlock != NULL )
+		pxConfig->pfUnlock();
+}
+
+/* 申请一块并记录统计，失败返回 NULL；ulOp 为本次操作的序号 */
+static void *prvAlloc( MemWorkload_t *pxWorkload, uint32_t ulSize, uint32_t ulPhase, uint32_t ulOp )
+{
+	const MemWorkloadConfig_t *pxConfig = &pxWorkload->xConfig;
+	MemWorkloadResult_t *pxResult = &pxWorkload->xResult;
+	uint64_t ullLive;
+	size_t xFree;
+	void *pv;
+
+	prvLock( pxConfig );
+	pv = pxConfig->pfMalloc( ulSize );
+	if( ( pv == NULL ) && ( pxResult->ulFails++ == 0 ) )
+	{
+		pxResult->ulFirstFailOp = ulOp;
+		pxResult->ulFirstFailPhase = ulPhase;
+		pxResult->ulFirstFailSize = ulSize;
+		ullLive = pxResult->ullAllocBytes - pxResult->ullFreeBytes;
+		if( pxConfig->pfFreeBytes != NULL )
+		{
+			xFree = pxConfig->pfFreeBytes();
+			pxResult->ulUtilizationAtFail = prvPermille( ullLive, ullLive + xFree );
+		}
+		pxResult->ulFragmentationAtFail = prvFragmentation( pxConfig );
+		if( pxConfig->pfFreeBlockNum != NULL )
+			pxResult->ulFreeBlocksAtFail = ( uint32_t )pxConfig->pfFreeBlockNum();
+	}
+	prvUnlock( pxConfig );
+
+	if( pv == NULL )
+		return NULL;
+
+	if( pxConfig->ucTouch )
+		memset( pv, ( int )( ulSize & 0xFF ), ulSize );
+
+	pxResult->ulAllocs++;
+	pxResult->ullAllocBytes += ulSize;
+	ullLive = pxResult->ullAllocBytes - pxResult->ullFreeBytes;
+	if( ullLive > pxResult->ullPeakLiveBytes )
+		pxResult->ullPeakLiveBytes = ullLive;
+	return pv;
+}
+
+static void prvRelease( MemWorkload_t *pxWorkload, const MemWorkloadSlot_t *pxSlot )
+{
+	const MemWorkloadConfig_t *pxConfig = &pxWorkload->xConfig;
+	const uint8_t *puc = ( const uint8_t * )pxSlot->pvBlock;
+	uint8_t ucFill = ( uint8_t )( pxSlot->ulSize & 0xFF );
+
+	if( pxConfig->ucTouch && ( ( puc[ 0 ] != ucFill ) || ( puc[ pxSlot->ulSize - 1 ] != ucFill ) ) )
+		pxWorkload->xResult.ulCorrupts++;
+
+	prvLock( pxConfig );
+	pxConfig->pfFree( pxSlot->pvBlock );
+	prvUnlock( pxConfig );
+
+	pxWorkload->xResult.ulFrees++;
+	pxWorkload->xResult.ullFreeBytes += pxSlot->ulSize;
+}
+
+/* 按生命周期模型选出一个存活块移到队尾并弹出 */
+static void prvFreeOne( MemWorkload_t *pxWorkload, MemWlLifetime_t eLifetime )
+{
+	MemWorkloadSlot_t *pxSlots = pxWorkload->xConfig.pxSlots;
+	uint32_t ulNum = pxWorkload->xConfig.ulSlotNum;
+	uint32_t ulLive = pxWorkload->ulTail - pxWorkload->ulHead;
+	uint32_t ulPick, ulLast;
+	MemWorkloadSlot_t xTmp;
+
+	if( ( eLifetime == MEM_WL_LIFE_FIFO ) || ( eLifetime == MEM_WL_LIFE_PRODUCER_CONSUMER ) )
+	{
+		prvRelease( pxWorkload, &pxSlots[ pxWorkload->ulHead % ulNum ] );
+		pxWorkload->ulHead++;
+		return;
+	}
+
+	ulLast = ( pxWorkload->ulTail - 1 ) % ulNum;
+	if( eLifetime == MEM_WL_LIFE_RANDOM )
+	{
+		ulPick = ( pxWorkload->ulHead + prvRand( &pxWorkload->ulRand ) % ulLive ) % ulNum;
+		xTmp = pxSlots[ ulPick ];
+		pxSlots[ ulPick ] = pxSlots[ ulLast ];
+		pxSlots[ ulLast ] = xTmp;
+	}
+	prvRelease( pxWorkload, &pxSlots[ ulLast ] );
+	pxWorkload->ulTail--;
+}
+
+static void prvFinish( MemWorkload_t *pxWorkload )
+{
+	const MemWorkloadConfig_t *pxConfig = &pxWorkload->xConfig;
+	MemWorkloadResult_t *pxResult = &pxWorkload->xResult;
+
+	prvLock( pxConfig );
+	pxResult->ulFragmentationFinal = prvFragmentation( pxConfig );
+	if( pxConfig->pfFreeBlockNum != NULL )
+		pxResult->ulFreeBlocksFinal = ( uint32_t )pxConfig->pfFreeBlockNum();
+	prvUnlock( pxConfig );
+
+	pxResult->ulOps = pxResult->ulAllocs + pxResult->ulFrees + pxResult->ulFails;
+	if( pxConfig->pfTick != NULL )
+	{
+		pxResult->ulTicks = pxConfig->pfTick() - pxWorkload->ulStartTick;
+		if( ( pxResult->ulTicks != 0 ) && ( pxConfig->ulTickHz != 0 ) )
+			pxResult->ulOpsPerSec = ( uint32_t )( ( ( uint64_t )pxResult->ulOps * pxConfig->ulTickHz ) / pxResult->ulTicks );
+	}
+}
+
+int memWorkloadInit( MemWorkload_t *pxWorkload, const MemWorkloadConfig_t *pxConfig )
+{
+	if( ( pxWorkload == NULL ) || ( pxConfig == NULL ) || ( pxConfig->pfMalloc == NULL ) || ( pxConfig->pfFree == NULL )
+		|| ( pxConfig->pxPhases == NULL ) || ( pxConfig->ulPhaseNum == 0 ) || ( pxConfig->pxSlots == NULL ) || ( pxConfig->ulSlotNum == 0 ) )
+		return -1;
+
+	memset( pxWorkload, 0, sizeof( MemWorkload_t ) );
+	pxWorkload->xConfig = *pxConfig;
+	pxWorkload->ulRand = ( pxConfig->ulSeed == 0 ) ? 1 : pxConfig->ulSeed;
+	return 0;
+}
+
+int memWorkloadRun( MemWorkload_t *pxWorkload )
+{
+	const MemWorkloadConfig_t *pxConfig = &pxWorkload->xConfig;
+	const MemWorkloadPhase_t *pxPhase;
+	MemWorkloadSlot_t *pxSlot;
+	uint32_t ulPhase, i, ulLive, ulLiveMax, ulSize, ulOp = 0;
+	int ret = 0;
+	void *pv;
+
+	if( pxConfig->pfTick != NULL )
+		pxWorkload->ulStartTick = pxConfig->pfTick();
+
+	for( ulPhase = 0; ( ulPhase < pxConfig->ulPhaseNum ) && ( ret == 0 ); ulPhase++ )
+	{
+		pxPhase = &pxConfig->pxPhases[ ulPhase ];
+		ulLiveMax = ( ( pxPhase->ulLiveMax == 0 ) || ( pxPhase->ulLiveMax > pxConfig->ulSlotNum ) ) ? pxConfig->ulSlotNum : pxPhase->ulLiveMax;
+
+		for( i = 0; i < pxPhase->ulOps; i++ )
+		{
+			ulOp++;
+			ulLive = pxWorkload->ulTail - pxWorkload->ulHead;
+
+			// 上一阶段留下的存活块超过本阶段上限时先释放
+			if( ( ulLive > 0 ) && ( ( ulLive >= ulLiveMax ) || ( ( prvRand( &pxWorkload->ulRand ) % 100 ) >= pxPhase->ucAllocPercent ) ) )
+			{
+				prvFreeOne( pxWorkload, pxPhase->eLifetime );
+				continue;
+			}
+
+			ulSize = prvNextSize( &pxWorkload->ulRand, pxPhase );
+			pv = prvAlloc( pxWorkload, ulSize, ulPhase, ulOp );
+			if( pv == NULL )
+			{
+				if( pxConfig->ucStopOnFail )
+				{
+					ret = -1;
+					break;
+				}
+				continue;
+			}
+
+			pxSlot = &pxConfig->pxSlots[ pxWorkload->ulTail % pxConfig->ulSlotNum ];
+			pxSlot->pvBlock = pv;
+			pxSlot->ulSize = ulSize;
+			pxWorkload->ulTail++;
+		}
+	}
+
+	prvFinish( pxWorkload );
+	return ret;
+}
+
+void memWorkloadRelease( MemWorkload_t *pxWorkload )
+{
+	while( pxWorkload->ulTail != pxWorkload->ulHead )
+		prvFreeOne( pxWorkload, MEM_WL_LIFE_FIFO );
+}
+
+int memWorkloadProducer( MemWorkload_t *pxWorkload )
+{
+	const MemWorkloadConfig_t *pxConfig = &pxWorkload->xConfig;
+	const MemWorkloadPhase_t *pxPhase;
+	MemWorkloadSlot_t *pxSlot;
+	uint32_t ulPhase, i, ulSize, ulOp = 0;
+	int ret = 0;
+	void *pv;
+
+	if( pxConfig->pfTick != NULL )
+		pxWorkload->ulStartTick = pxConfig->pfTick();
+
+	for( ulPhase = 0; ( ulPhase < pxConfig->ulPhaseNum ) && ( ret == 0 ); ulPhase++ )
+	{
+		pxPhase = &pxConfig->pxPhases[ ulPhase ];
+		for( i = 0; i < pxPhase->ulOps; i++ )
+		{
+			// 队列满时等待消费者
+			while( ( pxWorkload->ulTail - pxWorkload->ulHead ) >= pxConfig->ulSlotNum )
+			{
+				if( pxConfig->pfYield != NULL )
+					pxConfig->pfYield();
+			}
+
+			ulOp++;
+			ulSize = prvNextSize( &pxWorkload->ulRand, pxPhase );
+			pv = prvAlloc( pxWorkload, ulSize, ulPhase, ulOp );
+			if( pv == NULL )
+			{
+				if( pxConfig->ucStopOnFail )
+				{
+					ret = -1;
+					break;
+				}
+				if( pxConfig->pfYield != NULL )
+					pxConfig->pfYield();
+				continue;
+			}
+
+			pxSlot = &pxConfig->pxSlots[ pxWorkload->ulTail % pxConfig->ulSlotNum ];
+			pxSlot->pvBlock = pv;
+			pxSlot->ulSize = ulSize;
+			memWL_BARRIER();
+			pxWorkload->ulTail++;
+		}
+	}
+
+	memWL_BARRIER();
+	pxWorkload->ucProducerDone = 1;
+	return ret;
+}
+
+int memWorkloadConsumer( MemWorkload_t *pxWorkload )
+{
+	const MemWorkloadConfig_t *pxConfig = &pxWorkload->xConfig;
+	MemWorkloadSlot_t xSlot;
+	uint8_t ucDone;
+
+	for( ;; )
+	{
+		ucDone = pxWorkload->ucProducerDone;
+		memWL_BARRIER();
+		if( pxWorkload->ulTail == pxWorkload->ulHead )
+		{
+			if( ucDone )
+				break;
+			if( pxConfig->pfYield != NULL )
+				pxConfig->pfYield();
+			continue;
+		}
+
+		xSlot = pxConfig->pxSlots[ pxWorkload->ulHead % pxConfig->ulSlotNum ];
+		memWL_BARRIER();
+		prvRelease( pxWorkload, &xSlot );
+		pxWorkload->ulHead++;
+	}
+
+	prvFinish( pxWorkload );
+	return ( ( pxWorkload->xResult.ulFails != 0 ) && pxConfig->ucStopOnFail ) ? -1 : 0;
+}
@@ -0,0 +1,436 @@
+/**
+ * @file: mem_bench.c
+ * @author: LinusZhao
+ * @brief: 主机工具，对比 mem_manage 与 glibc malloc、FreeRTOS heap_4/heap_5、TLSF 的耗时、吞吐、利用率和碎片
+ * @version: 1.0.0
+ * @date: 2021-01-01
+ * @attention: 编译与使用(一个可执行文件包含全部分配器):
+ *	gcc -O2 -I../include -o mem_bench mem_bench.c mem_bench_heap5.c mem_bench_bestfit.c \
+ *		mem_bench_quickfit.c mem_bench_oob.c mem_bench_tree.c ../src/mem_workload.c
+ *	./mem_bench [-s 每个分配器的堆字节数] [-n 循环次数] [-t trace.bin]
+ * 分配器:
+ *	glibc       系统 malloc，堆大小不受限，不统计利用率与碎片
+ *	heap5       FreeRTOS heap_4/heap_5 的首次适配算法(关闭 TATTER_OPTIME_EN 的 mem_manage，两者算法相同)
+ *	mm-bestfit  mem_manage 默认配置
+ *	mm-quickfit mem_manage + MEM_QUICK_FIT_EN
+ *	mm-oob      mem_manage + MEM_OOB_META_EN
+ *	mm-tree     mem_manage + MEM_TREE_INDEX_EN
+ *	tlsf        可选，本仓库不附带 TLSF 源码，取 https://github.com/mattconte/tlsf 后
+ *	            增加编译参数 -DBENCH_WITH_TLSF -I<tlsf目录> <tlsf目录>/tlsf.c
+ * 测试项:
+ *	pair        同一尺寸申请后立即释放，每对耗时(ns)
+ *	sweep       空闲链表中先造出 N 个不满足请求的小空闲块，再申请/释放 256 字节，每对耗时(ns)
+ *	realloc     从 16 字节每次增长 32 字节直到 8KB，每次 realloc 耗时(ns)
+ *	workload    mem_workload 标准场景: 吞吐(ops/s)、首次失败时利用率、结束时碎片率
+ *	trace       -t 指定时回放调用跟踪数据: 吞吐与首次失败位置
+ **/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <time.h>
+#include <unistd.h>
+
+#include "mem_trace_reader.h"
+#include "mem_workload.h"
+#include "mem_bench.h"
+
+#if defined(BENCH_WITH_TLSF)
+	#include "tlsf.h"
+#endif
+
+#define BENCH_SWEEP_MAX		1024
+#define BENCH_SLOT_NUM		512
+
+static void *glibc_alloc(size_t size) { return malloc(size); }
+static void glibc_release(void *ptr) { free(ptr); }
+static void *glibc_resize(void *ptr, size_t size) { return realloc(ptr, size); }
+static void glibc_init(uint8_t *heap, size_t size) { (void)heap; (void)size; }
+
+static const bench_alloc_t glibc_bench = {
+	"glibc", glibc_init, glibc_alloc, glibc_release, glibc_resize, NULL, NULL, NULL
+};
+
+#if defined(BENCH_WITH_TLSF)
+static tlsf_t tlsf_heap;
+
+typedef struct tlsf_stat_s
+{
+	size_t free_bytes;
+	size_t largest;
+	size_t blocks;
+} tlsf_stat_t;
+
+static void tlsf_stat_walker(void *ptr, size_t size, int used, void *user)
+{
+	tlsf_stat_t *stat = (tlsf_stat_t *)user;
+
+	(void)ptr;
+	if (!used){
+		stat->free_bytes += size;
+		stat->blocks++;
+		if (size > stat->largest)
+			stat->largest = size;
+	}
+}
+
+static tlsf_stat_t tlsf_stat(void)
+{
+	tlsf_stat_t stat = { 0, 0, 0 };
+
+	tlsf_walk_pool(tlsf_get_pool(tlsf_heap), tlsf_stat_walker, &stat);
+	return stat;
+}
+
+static void bench_tlsf_init(uint8_t *heap, size_t size) { tlsf_heap = tlsf_create_with_pool(heap, size); }
+static void *bench_tlsf_alloc(size_t size) { return tlsf_malloc(tlsf_heap, size); }
+static void bench_tlsf_release(void *ptr) { tlsf_free(tlsf_heap, ptr); }
+static void *bench_tlsf_resize(void *ptr, size_t size) { return tlsf_realloc(tlsf_heap, ptr, size); }
+static size_t bench_tlsf_free_bytes(void) { return tlsf_stat().free_bytes; }
+static size_t bench_tlsf_largest(void) { return tlsf_stat().largest; }
+static size_t bench_tlsf_blocks(void) { return tlsf_stat().blocks; }
+
+static const bench_alloc_t tlsf_bench = {
+	"tlsf", bench_tlsf_init, bench_tlsf_alloc, bench_tlsf_release, bench_tlsf_resize,
+	bench_tlsf_free_bytes, bench_tlsf_largest, bench_tlsf_blocks
+};
+#endif
+
+static const bench_alloc_t *bench_allocs[] = {
+	&glibc_bench,
+	&heap5_bench,
+	&bestfit_bench,
+	&quickfit_bench,
+	&oob_bench,
+	&tree_bench,
+#if defined(BENCH_WITH_TLSF)
+	&tlsf_bench,
+#endif
+};
+
+#define BENCH_ALLOC_NUM		(sizeof(bench_allocs) / sizeof(bench_allocs[0]))
+
+static void *bench_ptrs[2 * BENCH_SWEEP_MAX];
+static MemWorkloadSlot_t bench_slots[BENCH_SLOT_NUM];
+static uint32_t bench_ops = 100000;
+
+static uint64_t bench_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t bench_tick_us(void)
+{
+	return (uint32_t)(bench_now_ns() / 1000ULL);
+}
+
+static double bench_pair(const bench_alloc_t *a, size_t size)
+{
+	uint64_t t0;
+	uint32_t i;
+	void *ptr;
+
+	t0 = bench_now_ns();
+	for (i = 0; i < bench_ops; i++){
+		ptr = a->alloc(size);
+		if (ptr != NULL)
+			*(volatile uint8_t *)ptr = 0;
+		a->release(ptr);
+	}
+	return (double)(bench_now_ns() - t0) / bench_ops;
+}
+
+// 交替申请 32 字节的 A/B 块后释放全部 A，空闲链表中留下 holes 个 256 字节放不下的空闲块
+static double bench_sweep(const bench_alloc_t *a, uint32_t holes)
+{
+	uint64_t t0;
+	uint32_t i;
+	void *ptr;
+
+	for (i = 0; i < 2 * holes; i++)
+		bench_ptrs[i] = a->alloc(32);
+	for (i = 0; i < holes; i++)
+		a->release(bench_ptrs[2 * i]);
+
+	t0 = bench_now_ns();
+	for (i = 0; i < bench_ops; i++){
+		ptr = a->alloc(256);
+		a->release(ptr);
+	}
+	t0 = bench_now_ns() - t0;
+
+	for (i = 0; i < holes; i++)
+		a->release(bench_ptrs[2 * i + 1]);
+	return (double)t0 / bench_ops;
+}
+
+static double bench_realloc(const bench_alloc_t *a)
+{
+	uint64_t t0, total = 0;
+	uint32_t n = 0, round;
+	size_t size;
+	void *ptr, *grown;
+
+	for (round = 0; round < bench_ops / 256 + 1; round++){
+		ptr = a->alloc(16);
+		t0 = bench_now_ns();
+		for (size = 48; size <= 8192; size += 32){
+			grown = a->resize(ptr, size);
+			if (grown == NULL)
+				break;
+			ptr = grown;
+			n++;
+		}
+		total += bench_now_ns() - t0;
+		a->release(ptr);
+	}
+	return (n == 0) ? 0.0 : (double)total / n;
+}
+
+static void bench_workload(const bench_alloc_t *a, const MemWorkloadPhase_t *phase, MemWorkloadResult_t *res)
+{
+	MemWorkloadConfig_t config;
+	MemWorkload_t workload;
+
+	memset(&config, 0, sizeof(config));
+	config.pfMalloc = a->alloc;
+	config.pfFree = a->release;
+	config.pfFreeBytes = a->free_bytes;
+	config.pfLargestFree = a->largest_free;
+	config.pfFreeBlockNum = a->free_blocks;
+	config.pfTick = bench_tick_us;
+	config.ulTickHz = 1000000;
+	config.pxPhases = phase;
+	config.ulPhaseNum = 1;
+	config.pxSlots = bench_slots;
+	config.ulSlotNum = BENCH_SLOT_NUM;
+	config.ulSeed = 125;
+	memWorkloadInit(&workload, &config);
+	memWorkloadRun(&workload);
+	*res = workload.xResult;
+	memWorkloadRelease(&workload);
+}
+
+/* 回放调用跟踪数据，跟踪偏移直接作为下标；返回吞吐，*first_fail 为首次失败的操作序号 */
+static double bench_trace(const bench_alloc_t *a, const uint8_t *data, size_t len, unsigned long *first_fail)
+{
+	mem_trace_reader_t reader;
+	mem_trace_record_t record;
+	void **ptrs = NULL, *ptr;
+	size_t cap = 0, i, idx;
+	unsigned long ops = 0;
+	uint64_t t0, total = 0;
+
+	*first_fail = 0;
+	if (mem_trace_reader_init(&reader, data, len) != 0)
+		return 0.0;
+
+	while (mem_trace_reader_next(&reader, &record) > 0){
+		if (record.op == MEM_TRACE_OP_DROPPED)
+			continue;
+		idx = (size_t)record.offset;
+		if ((record.offset >= cap) || (record.old_offset >= cap)){
+			i = cap;
+			cap = (size_t)((record.offset > record.old_offset) ? record.offset : record.old_offset) * 2 + 1024;
+			ptrs = (void **)realloc(ptrs, cap * sizeof(void *));
+			if (ptrs == NULL){
+				printf("out of host memory\n");
+				exit(1);
+			}
+			memset(&ptrs[i], 0, (cap - i) * sizeof(void *));
+		}
+
+		t0 = bench_now_ns();
+		switch (record.op){
+		case MEM_TRACE_OP_MALLOC:
+		case MEM_TRACE_OP_CALLOC:
+			if (record.offset == 0)
+				continue;
+			ptr = a->alloc((size_t)record.size);
+			break;
+		case MEM_TRACE_OP_FREE:
+			if ((record.offset == 0) || (ptrs[idx] == NULL))
+				continue;
+			a->release(ptrs[idx]);
+			ptrs[idx] = NULL;
+			ptr = NULL;
+			break;
+		default:	// MEM_TRACE_OP_REALLOC
+			if ((record.offset == 0) && (record.size != 0))
+				continue;
+			ptr = a->resize(ptrs[record.old_offset], (size_t)record.size);
+			if ((ptr != NULL) || (record.size == 0))
+				ptrs[record.old_offset] = NULL;
+			break;
+		}
+		total += bench_now_ns() - t0;
+		ops++;
+
+		if (record.op != MEM_TRACE_OP_FREE){
+			if (ptr != NULL)
+				ptrs[idx] = ptr;
+			else if ((record.size != 0) && (*first_fail == 0))
+				*first_fail = ops;
+		}
+	}
+
+	for (i = 0; i < cap; i++){
+		if (ptrs[i] != NULL)
+			a->release(ptrs[i]);
+	}
+	free(ptrs);
+	return (total == 0) ? 0.0 : (double)ops * 1e9 / (double)total;
+}
+
+static void bench_header(const char *title)
+{
+	size_t i;
+
+	printf("\n%-22s", title);
+	for (i = 0; i < BENCH_ALLOC_NUM; i++)
+		printf(" %14s", bench_allocs[i]->name);
+	printf("\n");
+}
+
+static void bench_print_permille(const bench_alloc_t *a, uint32_t value)
+{
+	if (a->free_bytes == NULL)
+		printf(" %14s", "-");
+	else
+		printf(" %12lu.%lu", (unsigned long)value / 10, (unsigned long)value % 10);
+}
+
+static int bench_read_file(const char *path, uint8_t **data, size_t *len)
+{
+	FILE *fp = fopen(path, "rb");
+	long size;
+
+	if (fp == NULL)
+		return -1;
+	fseek(fp, 0, SEEK_END);
+	size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	*data = (uint8_t *)malloc(size > 0 ? (size_t)size : 1);
+	if ((*data == NULL) || (fread(*data, 1, (size_t)size, fp) != (size_t)size)){
+		fclose(fp);
+		return -1;
+	}
+	*len = (size_t)size;
+	fclose(fp);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	static const size_t pair_sizes[] = { 16, 64, 256, 1024 };
+	static const uint32_t sweep_holes[] = { 0, 16, 64, 256, 1024 };
+	static const struct {
+		const char *name;
+		MemWorkloadPhase_t phase;
+	} scenarios[] = {
+		{ "uniform-random", { 0, MEM_WL_SIZE_UNIFORM,     1, 210,  0,  0,  0,    0,  MEM_WL_LIFE_RANDOM, 60, 0 } },
+		{ "exp-fifo",       { 0, MEM_WL_SIZE_EXPONENTIAL, 1, 4096, 96, 0,  0,    0,  MEM_WL_LIFE_FIFO,   60, 0 } },
+		{ "bimodal-lifo",   { 0, MEM_WL_SIZE_BIMODAL,     8, 2048, 0,  64, 1024, 10, MEM_WL_LIFE_LIFO,   60, 0 } },
+		{ "pow2-random",    { 0, MEM_WL_SIZE_POW2,        8, 2048, 0,  0,  0,    0,  MEM_WL_LIFE_RANDOM, 60, 0 } },
+	};
+	MemWorkloadResult_t results[BENCH_ALLOC_NUM];
+	MemWorkloadPhase_t phase;
+	const char *trace_path = NULL;
+	uint8_t *heaps[BENCH_ALLOC_NUM], *trace = NULL;
+	size_t heap_size = 256 * 1024, trace_len = 0, i, j;
+	unsigned long trace_fail[BENCH_ALLOC_NUM];
+	double trace_tput[BENCH_ALLOC_NUM];
+	int opt;
+
+	while ((opt = getopt(argc, argv, "s:n:t:")) != -1){
+		switch (opt){
+		case 's': heap_size = (size_t)strtoul(optarg, NULL, 0); break;
+		case 'n': bench_ops = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 't': trace_path = optarg; break;
+		default:
+			printf("usage: %s [-s heap_size] [-n loops] [-t trace.bin]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (bench_ops == 0)
+		bench_ops = 1;
+	if ((trace_path != NULL) && (bench_read_file(trace_path, &trace, &trace_len) != 0)){
+		printf("read %s failed\n", trace_path);
+		return 1;
+	}
+
+	for (i = 0; i < BENCH_ALLOC_NUM; i++){
+		heaps[i] = (uint8_t *)malloc(heap_size);
+		if (heaps[i] == NULL){
+			printf("out of host memory\n");
+			return 1;
+		}
+		bench_allocs[i]->init(heaps[i], heap_size);
+	}
+	printf("heap %lu bytes per allocator, %lu loops\n", (unsigned long)heap_size, (unsigned long)bench_ops);
+
+	bench_header("pair (ns)");
+	for (j = 0; j < sizeof(pair_sizes) / sizeof(pair_sizes[0]); j++){
+		printf("%-22lu", (unsigned long)pair_sizes[j]);
+		for (i = 0; i < BENCH_ALLOC_NUM; i++)
+			printf(" %14.1f", bench_pair(bench_allocs[i], pair_sizes[j]));
+		printf("\n");
+	}
+
+	bench_header("sweep holes (ns)");
+	for (j = 0; j < sizeof(sweep_holes) / sizeof(sweep_holes[0]); j++){
+		printf("%-22lu", (unsigned long)sweep_holes[j]);
+		for (i = 0; i < BENCH_ALLOC_NUM; i++)
+			printf(" %14.1f", bench_sweep(bench_allocs[i], sweep_holes[j]));
+		printf("\n");
+	}
+
+	bench_header("realloc growth (ns)");
+	printf("%-22s", "16..8192 step 32");
+	for (i = 0; i < BENCH_ALLOC_NUM; i++)
+		printf(" %14.1f", bench_realloc(bench_allocs[i]));
+	printf("\n");
+
+	for (j = 0; j < sizeof(scenarios) / sizeof(scenarios[0]); j++){
+		phase = scenarios[j].phase;
+		phase.ulOps = bench_ops;
+		for (i = 0; i < BENCH_ALLOC_NUM; i++)
+			bench_workload(bench_allocs[i], &phase, &results[i]);
+
+		bench_header(scenarios[j].name);
+		printf("%-22s", "  ops/s");
+		for (i = 0; i < BENCH_ALLOC_NUM; i++)
+			printf(" %14lu", (unsigned long)results[i].ulOpsPerSec);
+		printf("\n%-22s", "  first fail op");
+		for (i = 0; i < BENCH_ALLOC_NUM; i++)
+			printf(" %14lu", (unsigned long)results[i].ulFirstFailOp);
+		printf("\n%-22s", "  util@fail %");
+		for (i = 0; i < BENCH_ALLOC_NUM; i++)
+			bench_print_permille(bench_allocs[i], results[i].ulUtilizationAtFail);
+		printf("\n%-22s", "  frag end %");
+		for (i = 0; i < BENCH_ALLOC_NUM; i++)
+			bench_print_permille(bench_allocs[i], results[i].ulFragmentationFinal);
+		printf("\n");
+	}
+
+	if (trace != NULL){
+		for (i = 0; i < BENCH_ALLOC_NUM; i++)
+			trace_tput[i] = bench_trace(bench_allocs[i], trace, trace_len, &trace_fail[i]);
+
+		bench_header("trace");
+		printf("%-22s", "  ops/s");
+		for (i = 0; i < BENCH_ALLOC_NUM; i++)
+			printf(" %14.0f", trace_tput[i]);
+		printf("\n%-22s", "  first fail op");
+		for (i = 0; i < BENCH_ALLOC_NUM; i++)
+			printf(" %14lu", trace_fail[i]);
+		printf("\n");
+		free(trace);
+	}
+
+	for (i = 0; i < BENCH_ALLOC_NUM; i++)
+		free(heaps[i]);
+	return 0;
+}
@@ -0,0 +1,34 @@
+/**
+ * @file: mem_bench.h
+ * @author: LinusZhao
+ * @brief: mem_bench 中各分配器的统一接口
+ * @version: 1.0.0
+ * @date: 2021-01-01
+ **/
+
+#ifndef __MEM_BENCH_H__
+#define __MEM_BENCH_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct bench_alloc_s
+{
+	const char *name;
+	void (*init)(uint8_t *heap, size_t size);	// 启动时调用一次，heap 为该分配器独占的内存
+	void *(*alloc)(size_t size);
+	void (*release)(void *ptr);
+	void *(*resize)(void *ptr, size_t size);
+	size_t (*free_bytes)(void);					// 以下统计接口为 NULL 表示不支持(如堆大小不受限)
+	size_t (*largest_free)(void);
+	size_t (*free_blocks)(void);
+} bench_alloc_t;
+
+/* mem_manage 的各种配置，见 mem_bench_engine.h */
+extern const bench_alloc_t heap5_bench;
+extern const bench_alloc_t bestfit_bench;
+extern const bench_alloc_t quickfit_bench;
+extern const bench_alloc_t oob_bench;
+extern const bench_alloc_t tree_bench;
+
+#endif
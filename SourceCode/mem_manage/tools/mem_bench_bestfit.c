@@ -0,0 +1,5 @@
+/* mem_manage 默认配置: 首次适配基础上继续查找更优内存块 */
+#define BENCH_ENGINE			bestfit
+#define BENCH_ENGINE_NAME		"mm-bestfit"
+#define TATTER_OPTIME_EN		1
+#include "mem_bench_engine.h"
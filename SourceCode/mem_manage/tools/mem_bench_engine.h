@@ -0,0 +1,70 @@
+/**
+ * @file: mem_bench_engine.h
+ * @author: LinusZhao
+ * @brief: 把一份 mem_manage.c 编译为 mem_bench 的一个分配器
+ * @version: 1.0.0
+ * @date: 2021-01-01
+ * @attention: 包含前定义 BENCH_ENGINE(描述符名前缀)、BENCH_ENGINE_NAME 及 mem_manage 配置项；
+ * mem_manage.c 的外部符号统一加上前缀，多份不同配置可以链接进同一个可执行文件；
+ * mem_manage.c 新增外部符号时须在此补充
+ **/
+
+#ifndef __MEM_BENCH_ENGINE_H__
+#define __MEM_BENCH_ENGINE_H__
+
+#define BENCH_CAT2(a, b)		a##_##b
+#define BENCH_CAT(a, b)			BENCH_CAT2(a, b)
+
+#define memManageFunctionInit			BENCH_CAT(BENCH_ENGINE, memManageFunctionInit)
+#define memMalloc						BENCH_CAT(BENCH_ENGINE, memMalloc)
+#define memMallocSite					BENCH_CAT(BENCH_ENGINE, memMallocSite)
+#define memMallocTagged					BENCH_CAT(BENCH_ENGINE, memMallocTagged)
+#define memMallocCritical				BENCH_CAT(BENCH_ENGINE, memMallocCritical)
+#define memFree							BENCH_CAT(BENCH_ENGINE, memFree)
+#define memGetFreeHeapSize				BENCH_CAT(BENCH_ENGINE, memGetFreeHeapSize)
+#define memGetMinimumEverFreeHeapSize	BENCH_CAT(BENCH_ENGINE, memGetMinimumEverFreeHeapSize)
+#define memGetFreeBlockNum				BENCH_CAT(BENCH_ENGINE, memGetFreeBlockNum)
+#define memPrintfFreeListLayout			BENCH_CAT(BENCH_ENGINE, memPrintfFreeListLayout)
+#define memHeapWalk						BENCH_CAT(BENCH_ENGINE, memHeapWalk)
+#define memHeapDumpBinary				BENCH_CAT(BENCH_ENGINE, memHeapDumpBinary)
+#define pvPortReAlloc					BENCH_CAT(BENCH_ENGINE, pvPortReAlloc)
+#define pvPortCalloc					BENCH_CAT(BENCH_ENGINE, pvPortCalloc)
+#define xMemManage						BENCH_CAT(BENCH_ENGINE, xMemManage)
+
+#define MEM_MANAGE_PRINTF(...)			((void)0)
+
+#include "../src/mem_manage.c"
+#include "mem_bench.h"
+
+static int bench_largest_cb(const MemHeapBlockInfo_t *pxInfo, void *pvArg)
+{
+	size_t *largest = (size_t *)pvArg;
+
+	if ((pxInfo->eState == MEM_BLOCK_FREE) && (pxInfo->xSize > *largest))
+		*largest = pxInfo->xSize;
+	return 0;
+}
+
+static size_t bench_largest_free(void)
+{
+	size_t largest = 0;
+
+	memHeapWalk(bench_largest_cb, &largest);
+	return largest;
+}
+
+static void bench_init(uint8_t *heap, size_t size)
+{
+	MemHeapRegion_t regions[2] = { { heap, size }, { NULL, 0 } };
+	mem_manage_t manage;
+
+	memset(&manage, 0, sizeof(manage));
+	memManageFunctionInit(&manage, regions);
+}
+
+const bench_alloc_t BENCH_CAT(BENCH_ENGINE, bench) = {
+	BENCH_ENGINE_NAME, bench_init, memMalloc, memFree, pvPortReAlloc,
+	memGetFreeHeapSize, bench_largest_free, memGetFreeBlockNum
+};
+
+#endif
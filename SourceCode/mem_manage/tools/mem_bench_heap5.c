@@ -0,0 +1,5 @@
+/* FreeRTOS heap_4/heap_5 的首次适配算法，即关闭碎片优化的 mem_manage(heap_4 为单区域的 heap_5) */
+#define BENCH_ENGINE			heap5
+#define BENCH_ENGINE_NAME		"heap5"
+#define TATTER_OPTIME_EN		0
+#include "mem_bench_engine.h"
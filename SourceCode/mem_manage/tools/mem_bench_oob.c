@@ -0,0 +1,7 @@
+/* mem_manage 带外元数据配置，sweep 测试需要同时存活 2048 个块 */
+#define BENCH_ENGINE			oob
+#define BENCH_ENGINE_NAME		"mm-oob"
+#define TATTER_OPTIME_EN		1
+#define MEM_OOB_META_EN			1
+#define MEM_OOB_NODE_NUM		4096
+#include "mem_bench_engine.h"
@@ -0,0 +1,6 @@
+/* mem_manage 快速链表配置 */
+#define BENCH_ENGINE			quickfit
+#define BENCH_ENGINE_NAME		"mm-quickfit"
+#define TATTER_OPTIME_EN		1
+#define MEM_QUICK_FIT_EN		1
+#include "mem_bench_engine.h"
@@ -0,0 +1,5 @@
+/* mem_manage 红黑树空闲块索引配置 */
+#define BENCH_ENGINE			tree
+#define BENCH_ENGINE_NAME		"mm-tree"
+#define MEM_TREE_INDEX_EN		1
+#include "mem_bench_engine.h"
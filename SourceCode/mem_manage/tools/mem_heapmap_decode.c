@@ -0,0 +1,96 @@
+/**
+ * @file: mem_heapmap_decode.c
+ * @author: LinusZhao
+ * @brief: 主机工具，解析 memHeapDumpBinary 输出的二进制堆布局
+ * @version: 1.0.0
+ * @date: 2021-01-01
+ * @attention: 编译与使用:
+ *	gcc -I../include -o mem_heapmap_decode mem_heapmap_decode.c
+ *	./mem_heapmap_decode heapmap.bin [-v]
+ * -v 逐块打印，否则只输出统计
+ **/
+
+#include "mem_manage.h"
+
+static const char *state_name[] = {"free", "used", "cached", "reserved"};
+
+static int read_varint(FILE *fp, unsigned long long *value)
+{
+	int c, shift = 0;
+
+	*value = 0;
+	while ((c = fgetc(fp)) != EOF){
+		*value |= (unsigned long long)(c & 0x7F) << shift;
+		if ((c & 0x80) == 0)
+			return 0;
+		shift += 7;
+		if (shift > 63)
+			return -1;
+	}
+	return -1;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned char head[4];
+	unsigned long long gap, word, offset = 0, size, align;
+	unsigned long long bytes[4] = {0}, count[4] = {0}, largest_free = 0;
+	int verbose, state;
+	FILE *fp;
+
+	if (argc < 2){
+		printf("usage: %s <heapmap.bin> [-v]\n", argv[0]);
+		return 1;
+	}
+	verbose = (argc > 2) && (strcmp(argv[2], "-v") == 0);
+
+	fp = fopen(argv[1], "rb");
+	if (fp == NULL){
+		printf("open %s failed\n", argv[1]);
+		return 1;
+	}
+
+	if ((fread(head, 1, 4, fp) != 4) || (head[0] != 'M') || (head[1] != 'H') || (head[2] != MEM_HEAP_DUMP_VERSION)){
+		printf("not a mem_manage heap map (version %d expected)\n", MEM_HEAP_DUMP_VERSION);
+		fclose(fp);
+		return 2;
+	}
+	align = head[3];
+
+	if (verbose)
+		printf("%-12s %-10s %s\n", "offset", "size", "state");
+
+	for (;;){
+		if ((read_varint(fp, &gap) != 0) || (read_varint(fp, &word) != 0)){
+			printf("truncated heap map\n");
+			fclose(fp);
+			return 2;
+		}
+		if (word == 0)
+			break;
+
+		offset += gap * align;
+		size = (word >> 2) * align;
+		state = (int)(word & 0x3);
+
+		if (verbose)
+			printf("0x%010llx %-10llu %s\n", offset, size, state_name[state]);
+
+		bytes[state] += size;
+		count[state]++;
+		if ((state == MEM_BLOCK_FREE) && (size > largest_free))
+			largest_free = size;
+		offset += size;
+	}
+	fclose(fp);
+
+	printf("used   : %llu blocks, %llu bytes\n", count[MEM_BLOCK_USED], bytes[MEM_BLOCK_USED]);
+	printf("free   : %llu blocks, %llu bytes, largest %llu\n", count[MEM_BLOCK_FREE], bytes[MEM_BLOCK_FREE], largest_free);
+	printf("cached : %llu blocks, %llu bytes\n", count[MEM_BLOCK_CACHED], bytes[MEM_BLOCK_CACHED]);
+	if (count[MEM_BLOCK_RESERVED] > 0)
+		printf("reserve: %llu blocks, %llu bytes\n", count[MEM_BLOCK_RESERVED], bytes[MEM_BLOCK_RESERVED]);
+	if (bytes[MEM_BLOCK_FREE] > 0)
+		printf("fragmentation : %llu%% (1 - largest / free)\n", 100 - (largest_free * 100) / bytes[MEM_BLOCK_FREE]);
+
+	return 0;
+}
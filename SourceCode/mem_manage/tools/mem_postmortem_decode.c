@@ -0,0 +1,146 @@
+/**
+ * @file: mem_postmortem_decode.c
+ * @author: LinusZhao
+ * @brief: 主机工具，解析目标板导出的内存失败快照(MemPostMortem_t)并输出报告
+ * @version: 1.0.0
+ * @date: 2021-01-01
+ * @attention: 快照位于 xMemPostMortem 变量，用调试器按 sizeof(MemPostMortem_t) 导出为二进制文件，例如 J-Link:
+ *	savebin postmortem.bin, <xMemPostMortem 地址>, <长度>
+ * 编译与使用:
+ *	gcc -I../include -o mem_postmortem_decode mem_postmortem_decode.c
+ *	./mem_postmortem_decode postmortem.bin
+ **/
+
+#include "mem_manage.h"
+
+// 快照中各字段的字序号，与 MemPostMortem_t 一致
+#define PM_WORD_MAGIC			0
+#define PM_WORD_VERSION			1
+#define PM_WORD_FAIL_COUNT		2
+#define PM_WORD_WANTED_SIZE		3
+#define PM_WORD_FREE_BYTES		4
+#define PM_WORD_MIN_EVER		5
+#define PM_WORD_FREE_BLOCK_NUM	6
+#define PM_WORD_LARGEST			7
+#define PM_WORD_WALKED			8
+#define PM_WORD_FLAGS			9
+#define PM_WORD_HISTOGRAM		10
+#define PM_WORD_BLOCK_NUM		( PM_WORD_HISTOGRAM + MEM_POSTMORTEM_HIST_NUM )
+#define PM_WORD_BLOCKS			( PM_WORD_BLOCK_NUM + 1 )
+
+static uint32_t read_le32(const uint8_t *p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// 与 mem_manage.c 中的 prvPostMortemChecksum 相同
+static uint32_t calc_checksum(const uint8_t *buf, size_t word_num)
+{
+	uint32_t sum = 0x5A5A5A5AUL;
+	size_t i;
+
+	for (i = 0; i < word_num; i++){
+		sum = ((sum << 5) | (sum >> 27)) ^ read_le32(buf + i * 4);
+	}
+	return sum;
+}
+
+int main(int argc, char **argv)
+{
+	static uint8_t buf[64 * 1024];
+	FILE *fp;
+	size_t len, capacity, tag_word, tag_capacity, tag_num, word_num, block_num, i;
+	uint32_t free_bytes, largest;
+
+	if (argc < 2){
+		printf("usage: %s <postmortem.bin>\n", argv[0]);
+		return 1;
+	}
+
+	fp = fopen(argv[1], "rb");
+	if (fp == NULL){
+		printf("open %s failed\n", argv[1]);
+		return 1;
+	}
+	len = fread(buf, 1, sizeof(buf), fp);
+	fclose(fp);
+
+	if ((len < PM_WORD_BLOCKS * 4) || (read_le32(buf) != MEM_POSTMORTEM_MAGIC)){
+		printf("no valid snapshot: bad magic or file too short\n");
+		return 2;
+	}
+	if ((read_le32(buf + PM_WORD_VERSION * 4) & 0xFFFF) != MEM_POSTMORTEM_VERSION){
+		printf("unsupported snapshot version %u\n", (unsigned)(read_le32(buf + PM_WORD_VERSION * 4) & 0xFFFF));
+		return 2;
+	}
+
+	capacity = read_le32(buf + PM_WORD_VERSION * 4) >> 16;
+	tag_word = PM_WORD_BLOCKS + capacity * 2;
+	if (len < (tag_word + 1) * 4){
+		printf("file too short for %u recorded blocks\n", (unsigned)capacity);
+		return 2;
+	}
+	// 标签部分: 一个字(低 16 位容量，高 16 位有效个数)，之后每个标签 4 个字(标签号、存活字节、存活个数、峰值)
+	tag_capacity = read_le32(buf + tag_word * 4) & 0xFFFF;
+	tag_num = read_le32(buf + tag_word * 4) >> 16;
+	word_num = tag_word + 1 + tag_capacity * 4;
+	if (len < (word_num + 1) * 4){
+		printf("file too short for %u recorded tags\n", (unsigned)tag_capacity);
+		return 2;
+	}
+	if (calc_checksum(buf, word_num) != read_le32(buf + word_num * 4)){
+		printf("checksum mismatch, snapshot is corrupted or was never written\n");
+		return 2;
+	}
+
+	free_bytes = read_le32(buf + PM_WORD_FREE_BYTES * 4);
+	largest = read_le32(buf + PM_WORD_LARGEST * 4);
+
+	printf("== mem_manage post-mortem ==\n");
+	printf("fail count          : %u\n", (unsigned)read_le32(buf + PM_WORD_FAIL_COUNT * 4));
+	printf("last wanted size    : %u bytes (with header and alignment)\n", (unsigned)read_le32(buf + PM_WORD_WANTED_SIZE * 4));
+	printf("free bytes          : %u\n", (unsigned)free_bytes);
+	printf("minimum ever free   : %u\n", (unsigned)read_le32(buf + PM_WORD_MIN_EVER * 4));
+	printf("free block num      : %u\n", (unsigned)read_le32(buf + PM_WORD_FREE_BLOCK_NUM * 4));
+	printf("largest free block  : %u\n", (unsigned)largest);
+	if (free_bytes > 0){
+		printf("fragmentation       : %u%% (1 - largest / free)\n", (unsigned)(100 - ((uint64_t)largest * 100) / free_bytes));
+	}
+	printf("walked blocks       : %u%s\n", (unsigned)read_le32(buf + PM_WORD_WALKED * 4),
+			(read_le32(buf + PM_WORD_FLAGS * 4) & MEM_POSTMORTEM_FLAG_TRUNCATED) ? " (truncated)" : "");
+
+	printf("\nfree block size histogram:\n");
+	for (i = 0; i < MEM_POSTMORTEM_HIST_NUM; i++){
+		uint32_t count = read_le32(buf + (PM_WORD_HISTOGRAM + i) * 4);
+		if (count == 0)
+			continue;
+		if (i == MEM_POSTMORTEM_HIST_NUM - 1)
+			printf("  >= %-8lu     : %u\n", 16UL << i, (unsigned)count);
+		else
+			printf("  %6lu - %-6lu : %u\n", 16UL << i, (32UL << i) - 1, (unsigned)count);
+	}
+
+	block_num = read_le32(buf + PM_WORD_BLOCK_NUM * 4);
+	if (block_num > capacity)
+		block_num = capacity;
+	printf("\nfree list layout (first %u blocks by address):\n", (unsigned)block_num);
+	printf("  %-10s %-10s\n", "offset", "size");
+	for (i = 0; i < block_num; i++){
+		printf("  0x%08x %u\n", (unsigned)read_le32(buf + (PM_WORD_BLOCKS + i * 2) * 4),
+				(unsigned)read_le32(buf + (PM_WORD_BLOCKS + i * 2 + 1) * 4));
+	}
+
+	if (tag_num > tag_capacity)
+		tag_num = tag_capacity;
+	if (tag_num > 0){
+		printf("\ntop %u tags by live bytes (bytes include block headers):\n", (unsigned)tag_num);
+		printf("  %-4s %-10s %-10s %-10s\n", "tag", "live", "count", "peak");
+		for (i = 0; i < tag_num; i++){
+			printf("  %-4u %-10u %-10u %-10u\n", (unsigned)(read_le32(buf + (tag_word + 1 + i * 4) * 4) & 0xFF),
+					(unsigned)read_le32(buf + (tag_word + 2 + i * 4) * 4), (unsigned)read_le32(buf + (tag_word + 3 + i * 4) * 4),
+					(unsigned)read_le32(buf + (tag_word + 4 + i * 4) * 4));
+		}
+	}
+
+	return 0;
+}
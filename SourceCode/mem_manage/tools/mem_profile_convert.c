@@ -0,0 +1,191 @@
+/**
+ * @file: mem_profile_convert.c
+ * @author: LinusZhao
+ * @brief: 主机工具，把 memProfileDump 输出的采样数据转换为 pprof 或火焰图可读的文本
+ * @version: 1.0.0
+ * @date: 2021-01-01
+ * @attention: 编译与使用:
+ *	gcc -I../include -o mem_profile_convert mem_profile_convert.c
+ *	./mem_profile_convert profile.bin > heap.prof              pprof 旧版堆文本格式(heap_v2)
+ *	pprof -top firmware.elf heap.prof
+ *	./mem_profile_convert -f [-e firmware.elf] profile.bin > heap.folded   火焰图折叠格式
+ *	flamegraph.pl heap.folded > heap.svg
+ * pprof 格式输出原始样本，由 pprof 按采样间隔还原；折叠格式直接输出估计字节数，
+ * -e 指定时用 addr2line 把调用者地址换成函数名
+ **/
+
+#include "mem_manage.h"
+
+typedef struct profile_site_s
+{
+	uint64_t site;
+	uint64_t size;				// pprof 格式按 (调用者, 尺寸) 分组，折叠格式只按调用者分组
+	uint64_t count;
+	double estimate;			// 估计字节数
+} profile_site_t;
+
+static int read_varint(const uint8_t *data, size_t len, size_t *pos, uint64_t *value)
+{
+	int shift = 0;
+	uint8_t c;
+
+	*value = 0;
+	while (*pos < len){
+		c = data[(*pos)++];
+		*value |= (uint64_t)(c & 0x7F) << shift;
+		if ((c & 0x80) == 0)
+			return 0;
+		shift += 7;
+		if (shift > 63)
+			return -1;
+	}
+	return -1;
+}
+
+// exp(-x) 的级数计算，避免依赖 libm
+static double exp_neg(double x)
+{
+	double term = 1.0, sum = 1.0;
+	int n, halvings = 0;
+
+	while (x > 0.5){
+		x /= 2.0;
+		halvings++;
+	}
+	for (n = 1; n < 20; n++){
+		term *= -x / n;
+		sum += term;
+	}
+	while (halvings-- > 0)
+		sum *= sum;
+	return sum;
+}
+
+// 一个尺寸为 size 的样本代表的字节数
+static double unsample(uint64_t size, uint64_t interval)
+{
+	double p = 1.0 - exp_neg((double)size / (double)interval);
+	return (p <= 0.0) ? (double)size : (double)size / p;
+}
+
+static void print_symbol(const char *elf, uint64_t site)
+{
+	char cmd[512], name[256];
+	FILE *pp;
+
+	if (elf != NULL){
+		snprintf(cmd, sizeof(cmd), "addr2line -f -e '%s' 0x%llx", elf, (unsigned long long)site);
+		pp = popen(cmd, "r");
+		if (pp != NULL){
+			if ((fgets(name, sizeof(name), pp) != NULL) && (strncmp(name, "??", 2) != 0)){
+				name[strcspn(name, "\r\n")] = '\0';
+				printf("%s", name);
+				pclose(pp);
+				return;
+			}
+			pclose(pp);
+		}
+	}
+	printf("0x%llx", (unsigned long long)site);
+}
+
+int main(int argc, char **argv)
+{
+	profile_site_t *sites;
+	const char *elf = NULL, *path = NULL;
+	uint64_t interval, dropped, num, site, size, i, total_count = 0, total_bytes = 0;
+	size_t len, pos, site_num = 0, j;
+	uint8_t *data;
+	long flen;
+	FILE *fp;
+	int folded = 0, arg;
+
+	for (arg = 1; arg < argc; arg++){
+		if (strcmp(argv[arg], "-f") == 0)
+			folded = 1;
+		else if ((strcmp(argv[arg], "-e") == 0) && (arg + 1 < argc))
+			elf = argv[++arg];
+		else
+			path = argv[arg];
+	}
+	if (path == NULL){
+		printf("usage: %s [-f] [-e firmware.elf] <profile.bin>\n", argv[0]);
+		return 1;
+	}
+
+	fp = fopen(path, "rb");
+	if (fp == NULL){
+		printf("open %s failed\n", path);
+		return 1;
+	}
+	fseek(fp, 0, SEEK_END);
+	flen = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	data = (uint8_t *)malloc(flen > 0 ? (size_t)flen : 1);
+	if ((data == NULL) || (fread(data, 1, (size_t)flen, fp) != (size_t)flen)){
+		printf("read %s failed\n", path);
+		fclose(fp);
+		return 1;
+	}
+	fclose(fp);
+	len = (size_t)flen;
+
+	if ((len < 4) || (data[0] != 'M') || (data[1] != 'P') || (data[2] != MEM_PROFILE_VERSION)){
+		printf("not a mem_manage profile (version %d expected)\n", MEM_PROFILE_VERSION);
+		return 2;
+	}
+	pos = 4;
+	if ((read_varint(data, len, &pos, &interval) != 0) || (read_varint(data, len, &pos, &dropped) != 0)
+		|| (read_varint(data, len, &pos, &num) != 0) || (interval == 0)){
+		printf("profile truncated\n");
+		return 2;
+	}
+
+	sites = (profile_site_t *)calloc((size_t)num + 1, sizeof(profile_site_t));
+	if (sites == NULL)
+		return 1;
+
+	for (i = 0; i < num; i++){
+		if ((read_varint(data, len, &pos, &site) != 0) || (read_varint(data, len, &pos, &size) != 0)){
+			printf("profile truncated after %llu samples\n", (unsigned long long)i);
+			return 2;
+		}
+		for (j = 0; j < site_num; j++){
+			if ((sites[j].site == site) && (folded || (sites[j].size == size)))
+				break;
+		}
+		if (j == site_num){
+			sites[j].site = site;
+			sites[j].size = folded ? 0 : size;
+			site_num++;
+		}
+		sites[j].count++;
+		sites[j].estimate += unsample(size, interval);
+		total_count++;
+		total_bytes += size;
+	}
+
+	if (folded){
+		for (j = 0; j < site_num; j++){
+			print_symbol(elf, sites[j].site);
+			printf(" %.0f\n", sites[j].estimate);
+		}
+	}
+	else{
+		printf("heap profile: %llu: %llu [ %llu: %llu] @ heap_v2/%llu\n", (unsigned long long)total_count,
+				(unsigned long long)total_bytes, (unsigned long long)total_count, (unsigned long long)total_bytes,
+				(unsigned long long)interval);
+		for (j = 0; j < site_num; j++){
+			printf("%6llu: %8llu [%6llu: %8llu] @ 0x%llx\n", (unsigned long long)sites[j].count,
+					(unsigned long long)(sites[j].count * sites[j].size), (unsigned long long)sites[j].count,
+					(unsigned long long)(sites[j].count * sites[j].size), (unsigned long long)sites[j].site);
+		}
+	}
+
+	if (dropped != 0)
+		fprintf(stderr, "%llu samples dropped on target (sample table full)\n", (unsigned long long)dropped);
+
+	free(sites);
+	free(data);
+	return 0;
+}
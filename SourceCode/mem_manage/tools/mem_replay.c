@@ -0,0 +1,402 @@
+/**
+ * @file: mem_replay.c
+ * @author: LinusZhao
+ * @brief: 主机工具，把 memTraceDrain 输出的调用跟踪数据全速回放到 mem_manage，用于比较不同配置/引擎
+ * @version: 1.0.0
+ * @date: 2021-01-01
+ * @attention: 编译与使用(每种配置单独编译一个可执行文件，配置项通过 -D 传入):
+ *	gcc -O2 -I../include -D'MEM_MANAGE_PRINTF(...)=((void)0)' -DTATTER_OPTIME_EN=0 \
+ *		-o mem_replay mem_replay.c ../src/mem_manage.c
+ *	./mem_replay [-s 堆字节数] [-i 采样间隔] [-c frag.csv] [-t] trace.bin
+ * 一次比较多种配置见 mem_replay_configs.sh
+ * 输出: 吞吐(ops/s)、申请/释放耗时百分位、空闲链表最大长度、碎片率随时间的变化、首次申请失败点
+ * 碎片率 = 1 - 最大空闲块 / 空闲字节总数，每隔采样间隔条操作用 memHeapWalk 统计一次
+ * 原始记录中就失败的申请不回放；回放时申请失败的偏移，其后续释放也一并跳过
+ **/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "mem_trace_reader.h"
+
+#if defined(MEM_PERSIST_EN) && (MEM_PERSIST_EN > 0)
+	#error "mem_replay does not support MEM_PERSIST_EN, the heap is not file backed"
+#endif
+
+#ifndef MEM_REPLAY_LABEL
+#define MEM_REPLAY_LABEL	"default"	// 配置名称，出现在输出中
+#endif
+
+/* 跟踪偏移 -> 回放指针 的映射，线性探测开放寻址 */
+typedef struct replay_map_s
+{
+	uint64_t *keys;			// 0 表示空槽
+	void **values;
+	size_t capacity;		// 2 的幂
+	size_t count;
+} replay_map_t;
+
+typedef struct replay_samples_s
+{
+	uint32_t *ns;
+	size_t count;
+	size_t capacity;
+} replay_samples_t;
+
+typedef struct replay_frag_s
+{
+	size_t free_bytes;
+	size_t largest;
+} replay_frag_t;
+
+static size_t replay_hash(uint64_t key, size_t mask)
+{
+	key ^= key >> 33;
+	key *= 0xFF51AFD7ED558CCDULL;
+	key ^= key >> 33;
+	return (size_t)key & mask;
+}
+
+static void replay_map_put(replay_map_t *map, uint64_t key, void *value);
+
+static void replay_map_grow(replay_map_t *map)
+{
+	replay_map_t old = *map;
+	size_t i;
+
+	map->capacity = (old.capacity == 0) ? 1024 : old.capacity * 2;
+	map->keys = (uint64_t *)calloc(map->capacity, sizeof(uint64_t));
+	map->values = (void **)calloc(map->capacity, sizeof(void *));
+	map->count = 0;
+	if ((map->keys == NULL) || (map->values == NULL)){
+		printf("out of host memory\n");
+		exit(1);
+	}
+	for (i = 0; i < old.capacity; i++){
+		if (old.keys[i] != 0)
+			replay_map_put(map, old.keys[i], old.values[i]);
+	}
+	free(old.keys);
+	free(old.values);
+}
+
+static void replay_map_put(replay_map_t *map, uint64_t key, void *value)
+{
+	size_t i;
+
+	if ((map->count + 1) * 2 > map->capacity)
+		replay_map_grow(map);
+
+	for (i = replay_hash(key, map->capacity - 1); map->keys[i] != 0; i = (i + 1) & (map->capacity - 1)){
+		if (map->keys[i] == key)
+			break;
+	}
+	if (map->keys[i] == 0)
+		map->count++;
+	map->keys[i] = key;
+	map->values[i] = value;
+}
+
+// 取出并删除，不存在返回 0
+static int replay_map_take(replay_map_t *map, uint64_t key, void **value)
+{
+	size_t mask = map->capacity - 1;
+	size_t i, j, home;
+
+	if (map->capacity == 0)
+		return 0;
+
+	for (i = replay_hash(key, mask); map->keys[i] != key; i = (i + 1) & mask){
+		if (map->keys[i] == 0)
+			return 0;
+	}
+	*value = map->values[i];
+	map->count--;
+
+	// 后移删除，保持探测链连续
+	for (j = (i + 1) & mask; map->keys[j] != 0; j = (j + 1) & mask){
+		home = replay_hash(map->keys[j], mask);
+		if (((j - home) & mask) >= ((j - i) & mask)){
+			map->keys[i] = map->keys[j];
+			map->values[i] = map->values[j];
+			i = j;
+		}
+	}
+	map->keys[i] = 0;
+	map->values[i] = NULL;
+	return 1;
+}
+
+static void replay_samples_add(replay_samples_t *samples, uint64_t ns)
+{
+	if (samples->count == samples->capacity){
+		samples->capacity = (samples->capacity == 0) ? 4096 : samples->capacity * 2;
+		samples->ns = (uint32_t *)realloc(samples->ns, samples->capacity * sizeof(uint32_t));
+		if (samples->ns == NULL){
+			printf("out of host memory\n");
+			exit(1);
+		}
+	}
+	samples->ns[samples->count++] = (ns > UINT32_MAX) ? UINT32_MAX : (uint32_t)ns;
+}
+
+static int replay_cmp_u32(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+	return (x > y) - (x < y);
+}
+
+// 排序后取百分位，permille 为千分位
+static uint32_t replay_percentile(const replay_samples_t *samples, unsigned permille)
+{
+	size_t idx;
+
+	if (samples->count == 0)
+		return 0;
+	idx = (samples->count * permille) / 1000;
+	if (idx >= samples->count)
+		idx = samples->count - 1;
+	return samples->ns[idx];
+}
+
+static uint64_t replay_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int replay_frag_cb(const MemHeapBlockInfo_t *pxInfo, void *pvArg)
+{
+	replay_frag_t *frag = (replay_frag_t *)pvArg;
+
+	if (pxInfo->eState == MEM_BLOCK_FREE){
+		frag->free_bytes += pxInfo->xSize;
+		if (pxInfo->xSize > frag->largest)
+			frag->largest = pxInfo->xSize;
+	}
+	return 0;
+}
+
+// samples 须已排序
+static void replay_print_latency(const char *name, const replay_samples_t *samples)
+{
+	printf("%-8s n=%lu p50=%u p90=%u p99=%u p99.9=%u max=%u (ns)\n", name, (unsigned long)samples->count,
+			replay_percentile(samples, 500), replay_percentile(samples, 900), replay_percentile(samples, 990),
+			replay_percentile(samples, 999), replay_percentile(samples, 1000));
+}
+
+int main(int argc, char **argv)
+{
+	mem_trace_reader_t reader;
+	mem_trace_record_t record;
+	MemHeapRegion_t regions[2];
+	mem_manage_t manage;
+	replay_map_t map;
+	replay_samples_t alloc_ns, free_ns;
+	replay_frag_t frag;
+	struct stat st;
+	const uint8_t *data;
+	const char *trace_path = NULL, *csv_path = NULL;
+	FILE *csv = NULL;
+	uint8_t *heap;
+	size_t heap_size = 64 * 1024, interval = 1000, peak_blocks = 0, blocks;
+	unsigned long ops = 0, skipped = 0, failed = 0, frag_samples = 0, dropped = 0;
+	unsigned long first_fail_op = 0;
+	size_t first_fail_size = 0, first_fail_free = 0;
+	double frag_now, frag_sum = 0.0, frag_max = 0.0;
+	uint64_t t0, t1, total_ns = 0;
+	void *ptr, *old_ptr;
+	int fd, ret, opt, table = 0;
+
+	while ((opt = getopt(argc, argv, "s:i:c:t")) != -1){
+		switch (opt){
+		case 's': heap_size = (size_t)strtoul(optarg, NULL, 0); break;
+		case 'i': interval = (size_t)strtoul(optarg, NULL, 0); break;
+		case 'c': csv_path = optarg; break;
+		case 't': table = 1; break;
+		default:
+			printf("usage: %s [-s heap_size] [-i sample_interval] [-c frag.csv] [-t] <trace.bin>\n", argv[0]);
+			return 1;
+		}
+	}
+	if (optind >= argc){
+		printf("usage: %s [-s heap_size] [-i sample_interval] [-c frag.csv] [-t] <trace.bin>\n", argv[0]);
+		return 1;
+	}
+	trace_path = argv[optind];
+	if (interval == 0)
+		interval = 1;
+
+	fd = open(trace_path, O_RDONLY);
+	if ((fd < 0) || (fstat(fd, &st) != 0) || (st.st_size == 0)){
+		printf("open %s failed\n", trace_path);
+		return 1;
+	}
+	data = (const uint8_t *)mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED){
+		printf("mmap %s failed\n", trace_path);
+		return 1;
+	}
+	if (mem_trace_reader_init(&reader, data, (size_t)st.st_size) != 0){
+		printf("not a mem_manage trace (version %d expected)\n", MEM_TRACE_VERSION);
+		return 2;
+	}
+
+	if (csv_path != NULL){
+		csv = fopen(csv_path, "w");
+		if (csv == NULL){
+			printf("open %s failed\n", csv_path);
+			return 1;
+		}
+		fprintf(csv, "op,free_bytes,free_blocks,largest_free,frag\n");
+	}
+
+	heap = (uint8_t *)malloc(heap_size);
+	if (heap == NULL){
+		printf("out of host memory\n");
+		return 1;
+	}
+	regions[0].pucStartAddress = heap;
+	regions[0].xSizeInBytes = heap_size;
+	regions[1].pucStartAddress = NULL;
+	regions[1].xSizeInBytes = 0;
+	memset(&manage, 0, sizeof(manage));
+	memManageFunctionInit(&manage, regions);
+
+	memset(&map, 0, sizeof(map));
+	memset(&alloc_ns, 0, sizeof(alloc_ns));
+	memset(&free_ns, 0, sizeof(free_ns));
+
+	while ((ret = mem_trace_reader_next(&reader, &record)) > 0){
+		switch (record.op){
+		case MEM_TRACE_OP_MALLOC:
+		case MEM_TRACE_OP_CALLOC:
+			if (record.offset == 0){
+				skipped++;
+				continue;
+			}
+			t0 = replay_now_ns();
+			ptr = (record.op == MEM_TRACE_OP_MALLOC) ? memMalloc((size_t)record.size) : pvPortCalloc(1, (size_t)record.size);
+			t1 = replay_now_ns();
+			replay_samples_add(&alloc_ns, t1 - t0);
+			break;
+		case MEM_TRACE_OP_FREE:
+			if ((record.offset == 0) || (replay_map_take(&map, record.offset, &old_ptr) == 0)){
+				skipped++;
+				continue;
+			}
+			t0 = replay_now_ns();
+			memFree(old_ptr);
+			t1 = replay_now_ns();
+			replay_samples_add(&free_ns, t1 - t0);
+			ptr = NULL;
+			break;
+		case MEM_TRACE_OP_REALLOC:
+			if ((record.offset == 0) && (record.size != 0)){
+				skipped++;
+				continue;
+			}
+			old_ptr = NULL;
+			if ((record.old_offset != 0) && (replay_map_take(&map, record.old_offset, &old_ptr) == 0)){
+				skipped++;
+				continue;
+			}
+			t0 = replay_now_ns();
+			ptr = pvPortReAlloc(old_ptr, (size_t)record.size);
+			t1 = replay_now_ns();
+			replay_samples_add(&alloc_ns, t1 - t0);
+			// 失败时原内存块仍有效
+			if ((ptr == NULL) && (record.size != 0) && (old_ptr != NULL))
+				replay_map_put(&map, record.old_offset, old_ptr);
+			break;
+		default:	// MEM_TRACE_OP_DROPPED
+			dropped += (unsigned long)record.dropped;
+			continue;
+		}
+
+		total_ns += t1 - t0;
+		ops++;
+
+		if (record.op != MEM_TRACE_OP_FREE){
+			if (ptr != NULL){
+				replay_map_put(&map, record.offset, ptr);
+			}
+			else if (record.size != 0){
+				if (failed == 0){
+					first_fail_op = ops;
+					first_fail_size = (size_t)record.size;
+					first_fail_free = memGetFreeHeapSize();
+				}
+				failed++;
+			}
+		}
+
+		blocks = memGetFreeBlockNum();
+		if (blocks > peak_blocks)
+			peak_blocks = blocks;
+
+		if ((ops % interval) == 0){
+			memset(&frag, 0, sizeof(frag));
+			memHeapWalk(replay_frag_cb, &frag);
+			frag_now = (frag.free_bytes == 0) ? 0.0 : 1.0 - (double)frag.largest / (double)frag.free_bytes;
+			frag_sum += frag_now;
+			if (frag_now > frag_max)
+				frag_max = frag_now;
+			frag_samples++;
+			if (csv != NULL)
+				fprintf(csv, "%lu,%lu,%lu,%lu,%.4f\n", ops, (unsigned long)frag.free_bytes, (unsigned long)blocks,
+						(unsigned long)frag.largest, frag_now);
+		}
+	}
+
+	if (csv != NULL)
+		fclose(csv);
+	if (ret < 0)
+		printf("trace truncated after %lu replayed ops\n", ops);
+
+	qsort(alloc_ns.ns, alloc_ns.count, sizeof(uint32_t), replay_cmp_u32);
+	qsort(free_ns.ns, free_ns.count, sizeof(uint32_t), replay_cmp_u32);
+
+	if (table){
+		// 单行输出，供 mem_replay_configs.sh 拼成对比表
+		printf("%-20s %10lu %12.0f %8u %8u %8u %8u %8u %10lu %8.3f %8.3f %10lu\n", MEM_REPLAY_LABEL, ops,
+				(total_ns == 0) ? 0.0 : (double)ops * 1e9 / (double)total_ns,
+				replay_percentile(&alloc_ns, 500), replay_percentile(&alloc_ns, 990), replay_percentile(&alloc_ns, 1000),
+				replay_percentile(&free_ns, 500), replay_percentile(&free_ns, 990), (unsigned long)peak_blocks,
+				(frag_samples == 0) ? 0.0 : frag_sum / (double)frag_samples, frag_max, first_fail_op);
+	}
+	else{
+		printf("config:      %s (TATTER_OPTIME_EN=%d MEM_SEARCH_DEPTH_MAX=%d MEM_QUICK_FIT_EN=%d)\n", MEM_REPLAY_LABEL,
+				(int)TATTER_OPTIME_EN, (int)MEM_SEARCH_DEPTH_MAX, (int)MEM_QUICK_FIT_EN);
+		printf("heap:        %lu bytes, trace %s\n", (unsigned long)heap_size, trace_path);
+		printf("ops:         %lu replayed, %lu skipped, %lu dropped in trace\n", ops, skipped, dropped);
+		printf("throughput:  %.0f ops/s\n", (total_ns == 0) ? 0.0 : (double)ops * 1e9 / (double)total_ns);
+		replay_print_latency("alloc", &alloc_ns);
+		replay_print_latency("free", &free_ns);
+		printf("free list:   peak %lu blocks, final %lu blocks, %lu bytes free\n", (unsigned long)peak_blocks,
+				(unsigned long)memGetFreeBlockNum(), (unsigned long)memGetFreeHeapSize());
+		printf("frag index:  mean %.3f, max %.3f over %lu samples\n",
+				(frag_samples == 0) ? 0.0 : frag_sum / (double)frag_samples, frag_max, frag_samples);
+		if (failed == 0)
+			printf("first fail:  none\n");
+		else
+			printf("first fail:  op %lu, %lu bytes wanted, %lu bytes free (%lu failures in total)\n", first_fail_op,
+					(unsigned long)first_fail_size, (unsigned long)first_fail_free, failed);
+	}
+
+	munmap((void *)data, (size_t)st.st_size);
+	free(alloc_ns.ns);
+	free(free_ns.ns);
+	free(map.keys);
+	free(map.values);
+	free(heap);
+	return (ret < 0) ? 2 : 0;
+}
@@ -0,0 +1,40 @@
+#!/bin/sh
+# 用同一份调用跟踪数据回放各种配置/引擎，打印对比表
+# 用法: ./mem_replay_configs.sh trace.bin [堆字节数] [采样间隔]
+# 新增配置时在 CONFIGS 中追加一行 "名称:编译选项"
+
+TRACE=$1
+HEAP=${2:-65536}
+INTERVAL=${3:-1000}
+CC=${CC:-gcc}
+OUT=${TMPDIR:-/tmp}/mem_replay.$$
+
+if [ -z "$TRACE" ]; then
+	echo "usage: $0 <trace.bin> [heap_size] [sample_interval]"
+	exit 1
+fi
+
+CONFIGS="first-fit:-DTATTER_OPTIME_EN=0
+best-fit:-DTATTER_OPTIME_EN=1
+best-fit-depth8:-DTATTER_OPTIME_EN=1 -DMEM_SEARCH_DEPTH_MAX=8
+quick-fit:-DTATTER_OPTIME_EN=1 -DMEM_QUICK_FIT_EN=1
+oob:-DMEM_OOB_META_EN=1
+tree:-DMEM_TREE_INDEX_EN=1
+exact-fit:-DMEM_EXACT_FIT_EN=1"
+
+DIR=$(cd "$(dirname "$0")" && pwd)
+mkdir -p "$OUT" || exit 1
+
+printf "%-20s %10s %12s %8s %8s %8s %8s %8s %10s %8s %8s %10s\n" config ops ops/s \
+	a_p50 a_p99 a_max f_p50 f_p99 peak_blks frag_avg frag_max first_fail
+echo "$CONFIGS" | while IFS=: read -r NAME FLAGS; do
+	# shellcheck disable=SC2086
+	if "$CC" -O2 -I"$DIR/../include" -D'MEM_MANAGE_PRINTF(...)=((void)0)' -DMEM_REPLAY_LABEL="\"$NAME\"" $FLAGS \
+		-o "$OUT/$NAME" "$DIR/mem_replay.c" "$DIR/../src/mem_manage.c"; then
+		"$OUT/$NAME" -t -s "$HEAP" -i "$INTERVAL" "$TRACE"
+	else
+		echo "$NAME: build failed"
+	fi
+done
+
+rm -rf "$OUT"
@@ -0,0 +1,456 @@
+/**
+ * @file: mem_sizeclass_gen.c
+ * @author: LinusZhao
+ * @brief: 主机工具，根据调用跟踪数据为精确查找表(MEM_EXACT_FIT_EN)挑选跟踪尺寸，生成可直接编译进 mem_manage 的配置头文件
+ * @version: 1.0.0
+ * @date: 2021-01-01
+ * @attention: 编译与使用:
+ *	gcc -O2 -I../include -D'MEM_MANAGE_PRINTF(...)=((void)0)' -DMEM_EXACT_FIT_EN=1 -DMEM_WASTE_STAT_EN=1 \
+ *		-o mem_sizeclass_gen mem_sizeclass_gen.c ../src/mem_manage.c
+ *	./mem_sizeclass_gen [-s 堆字节数] [-n 最多尺寸个数] [-i 采样间隔] [-o mem_sizeclass.h] trace.bin
+ * 生成的头文件通过 -DMEM_CONFIG_HEADER='"mem_sizeclass.h"' 编译进 mem_manage，运行时不再有任何开销；
+ * 编译本工具时的 MEM_EXACT_SLOT_NUM 须与目标相同，尺寸是否映射到同一个槽与槽个数有关
+ * 查找方法: 出现次数最多的 4 * n 个申请尺寸作为候选，从空表开始每次加入使代价下降最多的一个，直到代价不再下降或达到 n 个；
+ * 每个候选组合都在指定大小的堆上完整回放一遍跟踪数据
+ * 代价 = 内部碎片率(1 - 申请字节数 / 分配字节数) + 外部碎片率均值(1 - 最大空闲块 / 空闲字节总数，按采样间隔统计)
+ *	   + 10 * 申请失败率 - 0.01 * 精确命中率，碎片相同时优先命中多的组合
+ **/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mem_trace_reader.h"
+
+#if !defined(MEM_EXACT_FIT_EN) || (MEM_EXACT_FIT_EN == 0) || !defined(MEM_WASTE_STAT_EN) || (MEM_WASTE_STAT_EN == 0)
+	#error "mem_sizeclass_gen must be built with -DMEM_EXACT_FIT_EN=1 -DMEM_WASTE_STAT_EN=1"
+#endif
+
+#define GEN_MAX_CLASSES		MEM_EXACT_SLOT_NUM
+
+/* 预处理后的一条操作，跟踪中的偏移换成连续编号 */
+typedef struct gen_op_s
+{
+	uint8_t op;				// MEM_TRACE_OP_MALLOC/CALLOC/FREE/REALLOC
+	uint32_t id;			// 申请得到(REALLOC 为新)的内存块编号，FREE 为释放的编号
+	uint32_t old_id;		// REALLOC 的原内存块编号，0 表示空指针
+	size_t size;
+} gen_op_t;
+
+typedef struct gen_size_s
+{
+	size_t size;			// 按 memBYTE_ALIGNMENT 对齐的申请字节数
+	unsigned long count;
+} gen_size_t;
+
+typedef struct gen_result_s
+{
+	double cost;
+	double internal;
+	double external;
+	unsigned long failed;
+	unsigned long hits;
+} gen_result_t;
+
+typedef struct gen_frag_s
+{
+	size_t free_bytes;
+	size_t largest;
+} gen_frag_t;
+
+/* 跟踪偏移 -> 内存块编号，线性探测开放寻址，容量固定为跟踪记录数的 2 倍以上 */
+static uint64_t *map_keys;
+static uint32_t *map_values;
+static size_t map_mask;
+
+static gen_op_t *ops;
+static size_t op_num;
+static uint32_t id_num;
+static gen_size_t *sizes;
+static size_t size_num;
+static unsigned long alloc_num;
+
+static size_t map_slot(uint64_t key)
+{
+	key ^= key >> 33;
+	key *= 0xFF51AFD7ED558CCDULL;
+	key ^= key >> 33;
+	return (size_t)key & map_mask;
+}
+
+static void map_put(uint64_t key, uint32_t value)
+{
+	size_t i;
+
+	for (i = map_slot(key); (map_keys[i] != 0) && (map_keys[i] != key); i = (i + 1) & map_mask)
+		;
+	map_keys[i] = key;
+	map_values[i] = value;
+}
+
+// 取出并删除，不存在返回 0
+static uint32_t map_take(uint64_t key)
+{
+	size_t i, j, home;
+	uint32_t value;
+
+	for (i = map_slot(key); map_keys[i] != key; i = (i + 1) & map_mask){
+		if (map_keys[i] == 0)
+			return 0;
+	}
+	value = map_values[i];
+
+	// 后移删除，保持探测链连续
+	for (j = (i + 1) & map_mask; map_keys[j] != 0; j = (j + 1) & map_mask){
+		home = map_slot(map_keys[j]);
+		if (((j - home) & map_mask) >= ((j - i) & map_mask)){
+			map_keys[i] = map_keys[j];
+			map_values[i] = map_values[j];
+			i = j;
+		}
+	}
+	map_keys[i] = 0;
+	return value;
+}
+
+static void count_size(size_t size)
+{
+	size_t i;
+
+	size = (size + memBYTE_ALIGNMENT - 1) & ~((size_t)memBYTE_ALIGNMENT - 1);
+	alloc_num++;
+	for (i = 0; i < size_num; i++){
+		if (sizes[i].size == size){
+			sizes[i].count++;
+			return;
+		}
+	}
+	sizes[size_num].size = size;
+	sizes[size_num].count = 1;
+	size_num++;
+}
+
+static int cmp_size_count(const void *a, const void *b)
+{
+	const gen_size_t *x = (const gen_size_t *)a, *y = (const gen_size_t *)b;
+
+	if (x->count != y->count)
+		return (x->count < y->count) ? 1 : -1;
+	return (x->size > y->size) - (x->size < y->size);
+}
+
+// 解析跟踪数据，得到操作序列和尺寸分布，返回 0 成功
+static int load_trace(const uint8_t *data, size_t len)
+{
+	mem_trace_reader_t reader;
+	mem_trace_record_t record;
+	size_t capacity = 0;
+	int ret;
+
+	if (mem_trace_reader_init(&reader, data, len) != 0)
+		return -1;
+
+	// 每条记录至少 3 字节，按此估计容量
+	capacity = len / 3 + 1;
+	for (map_mask = 1; map_mask < capacity * 2; map_mask <<= 1)
+		;
+	map_keys = (uint64_t *)calloc(map_mask, sizeof(uint64_t));
+	map_values = (uint32_t *)calloc(map_mask, sizeof(uint32_t));
+	ops = (gen_op_t *)calloc(capacity, sizeof(gen_op_t));
+	sizes = (gen_size_t *)calloc(capacity, sizeof(gen_size_t));
+	if ((map_keys == NULL) || (map_values == NULL) || (ops == NULL) || (sizes == NULL)){
+		printf("out of host memory\n");
+		exit(1);
+	}
+	map_mask--;
+
+	while ((ret = mem_trace_reader_next(&reader, &record)) > 0){
+		gen_op_t *op = &ops[op_num];
+
+		op->op = record.op;
+		switch (record.op){
+		case MEM_TRACE_OP_MALLOC:
+		case MEM_TRACE_OP_CALLOC:
+			// 原始记录中就失败的申请不回放
+			if ((record.offset == 0) || (record.size == 0))
+				continue;
+			op->id = ++id_num;
+			op->size = (size_t)record.size;
+			map_put(record.offset, op->id);
+			count_size(op->size);
+			break;
+		case MEM_TRACE_OP_FREE:
+			op->id = (record.offset != 0) ? map_take(record.offset) : 0;
+			if (op->id == 0)
+				continue;
+			break;
+		case MEM_TRACE_OP_REALLOC:
+			if ((record.offset == 0) && (record.size != 0))
+				continue;
+			op->old_id = (record.old_offset != 0) ? map_take(record.old_offset) : 0;
+			op->size = (size_t)record.size;
+			if (record.size != 0){
+				op->id = ++id_num;
+				map_put(record.offset, op->id);
+				count_size(op->size);
+			}
+			break;
+		default:	// MEM_TRACE_OP_DROPPED
+			continue;
+		}
+		op_num++;
+	}
+
+	free(map_keys);
+	free(map_values);
+	qsort(sizes, size_num, sizeof(gen_size_t), cmp_size_count);
+	return (ret < 0) ? -1 : 0;
+}
+
+static int frag_cb(const MemHeapBlockInfo_t *pxInfo, void *pvArg)
+{
+	gen_frag_t *frag = (gen_frag_t *)pvArg;
+
+	if (pxInfo->eState == MEM_BLOCK_FREE){
+		frag->free_bytes += pxInfo->xSize;
+		if (pxInfo->xSize > frag->largest)
+			frag->largest = pxInfo->xSize;
+	}
+	return 0;
+}
+
+// 堆只能初始化一次，每次回放结束后释放全部存活内存块，空闲块合并回初始状态
+static void heap_init(uint8_t *heap, size_t heap_size)
+{
+	MemHeapRegion_t regions[2];
+	mem_manage_t manage;
+
+	regions[0].pucStartAddress = heap;
+	regions[0].xSizeInBytes = heap_size;
+	regions[1].pucStartAddress = NULL;
+	regions[1].xSizeInBytes = 0;
+	memset(&manage, 0, sizeof(manage));
+	memManageFunctionInit(&manage, regions);
+}
+
+// 跟踪 set 中的尺寸回放一遍，set 中有尺寸映射到同一个槽时返回 -1
+static int replay(void **ptrs, const size_t *set, size_t set_num, size_t interval, gen_result_t *result)
+{
+	MemExactSlotInfo_t info;
+	gen_frag_t frag;
+	double frag_sum = 0.0;
+	unsigned long frag_samples = 0, tracked = 0;
+	size_t i;
+
+	memset(result, 0, sizeof(gen_result_t));
+	memExactFitClear();
+	for (i = 0; i < set_num; i++)
+		(void)memExactFitSetSize(set[i]);
+	for (i = 0; i < MEM_EXACT_SLOT_NUM; i++){
+		if ((memExactFitGetSlot(i, &info) == 0) && (info.xSize != 0))
+			tracked++;
+	}
+	if (tracked != set_num)
+		return -1;
+	memResetWasteStat();
+
+	for (i = 0; i < op_num; i++){
+		const gen_op_t *op = &ops[i];
+
+		switch (op->op){
+		case MEM_TRACE_OP_MALLOC:
+			ptrs[op->id] = memMalloc(op->size);
+			break;
+		case MEM_TRACE_OP_CALLOC:
+			ptrs[op->id] = pvPortCalloc(1, op->size);
+			break;
+		case MEM_TRACE_OP_FREE:
+			memFree(ptrs[op->id]);
+			ptrs[op->id] = NULL;
+			break;
+		default:	// MEM_TRACE_OP_REALLOC
+			if (op->size == 0){
+				memFree(ptrs[op->old_id]);
+				ptrs[op->old_id] = NULL;
+				continue;
+			}
+			ptrs[op->id] = pvPortReAlloc(ptrs[op->old_id], op->size);
+			// 失败时原内存块仍有效，按已释放处理，避免影响后续回放
+			if (ptrs[op->id] == NULL)
+				memFree(ptrs[op->old_id]);
+			ptrs[op->old_id] = NULL;
+			break;
+		}
+
+		if ((op->op != MEM_TRACE_OP_FREE) && (ptrs[op->id] == NULL))
+			result->failed++;
+
+		if (((i + 1) % interval) == 0){
+			memset(&frag, 0, sizeof(frag));
+			memHeapWalk(frag_cb, &frag);
+			frag_sum += (frag.free_bytes == 0) ? 0.0 : 1.0 - (double)frag.largest / (double)frag.free_bytes;
+			frag_samples++;
+		}
+	}
+
+	for (i = 0; i < MEM_EXACT_SLOT_NUM; i++){
+		if (memExactFitGetSlot(i, &info) == 0)
+			result->hits += info.ulHits;
+	}
+	result->internal = 1.0 - (double)memGetWasteEfficiency() / 1000.0;
+	for (i = 1; i <= id_num; i++){
+		if (ptrs[i] != NULL){
+			memFree(ptrs[i]);
+			ptrs[i] = NULL;
+		}
+	}
+	result->external = (frag_samples == 0) ? 0.0 : frag_sum / (double)frag_samples;
+	result->cost = result->internal + result->external;
+	if (alloc_num > 0){
+		result->cost += 10.0 * (double)result->failed / (double)alloc_num;
+		result->cost -= 0.01 * (double)result->hits / (double)alloc_num;
+	}
+	return 0;
+}
+
+static void print_result(FILE *fp, const char *prefix, const gen_result_t *result)
+{
+	fprintf(fp, "%sinternal %.2f%%, external %.2f%%, %lu failed, exact hits %.1f%%\n", prefix, result->internal * 100.0,
+			result->external * 100.0, result->failed, (alloc_num == 0) ? 0.0 : (double)result->hits * 100.0 / (double)alloc_num);
+}
+
+int main(int argc, char **argv)
+{
+	struct stat st;
+	const uint8_t *data;
+	const char *trace_path, *out_path = NULL;
+	size_t heap_size = 64 * 1024, max_classes = 8, interval = 1000, cand_num, set_num = 0, i, j, best_idx;
+	size_t set[GEN_MAX_CLASSES] = { 0 };
+	uint8_t *used, *heap;
+	void **ptrs;
+	gen_result_t base, best, trial;
+	FILE *out = stdout;
+	int fd, opt;
+
+	while ((opt = getopt(argc, argv, "s:n:i:o:")) != -1){
+		switch (opt){
+		case 's': heap_size = (size_t)strtoul(optarg, NULL, 0); break;
+		case 'n': max_classes = (size_t)strtoul(optarg, NULL, 0); break;
+		case 'i': interval = (size_t)strtoul(optarg, NULL, 0); break;
+		case 'o': out_path = optarg; break;
+		default:
+			printf("usage: %s [-s heap_size] [-n max_classes] [-i sample_interval] [-o out.h] <trace.bin>\n", argv[0]);
+			return 1;
+		}
+	}
+	if (optind >= argc){
+		printf("usage: %s [-s heap_size] [-n max_classes] [-i sample_interval] [-o out.h] <trace.bin>\n", argv[0]);
+		return 1;
+	}
+	trace_path = argv[optind];
+	if (interval == 0)
+		interval = 1;
+	if ((max_classes == 0) || (max_classes > GEN_MAX_CLASSES))
+		max_classes = GEN_MAX_CLASSES;
+
+	fd = open(trace_path, O_RDONLY);
+	if ((fd < 0) || (fstat(fd, &st) != 0) || (st.st_size == 0)){
+		printf("open %s failed\n", trace_path);
+		return 1;
+	}
+	data = (const uint8_t *)mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED){
+		printf("mmap %s failed\n", trace_path);
+		return 1;
+	}
+	if (load_trace(data, (size_t)st.st_size) != 0){
+		printf("not a mem_manage trace (version %d expected) or trace truncated\n", MEM_TRACE_VERSION);
+		return 2;
+	}
+	munmap((void *)data, (size_t)st.st_size);
+
+	heap = (uint8_t *)malloc(heap_size);
+	ptrs = (void **)calloc(id_num + 1, sizeof(void *));
+	cand_num = (size_num < max_classes * 4) ? size_num : max_classes * 4;
+	used = (uint8_t *)calloc(cand_num + 1, 1);
+	if ((heap == NULL) || (ptrs == NULL) || (used == NULL)){
+		printf("out of host memory\n");
+		return 1;
+	}
+	heap_init(heap, heap_size);
+
+	fprintf(stderr, "%lu ops, %lu allocations, %lu distinct sizes, %lu candidates\n", (unsigned long)op_num, alloc_num,
+			(unsigned long)size_num, (unsigned long)cand_num);
+	(void)replay(ptrs, set, 0, interval, &base);
+	print_result(stderr, "no table:  ", &base);
+	best = base;
+
+	// 贪心前向选择
+	while (set_num < max_classes){
+		gen_result_t step_best = best;
+
+		best_idx = cand_num;
+		for (i = 0; i < cand_num; i++){
+			if (used[i])
+				continue;
+			set[set_num] = sizes[i].size;
+			if ((replay(ptrs, set, set_num + 1, interval, &trial) == 0) && (trial.cost < step_best.cost)){
+				step_best = trial;
+				best_idx = i;
+			}
+		}
+		if (best_idx == cand_num)
+			break;
+		used[best_idx] = 1;
+		set[set_num++] = sizes[best_idx].size;
+		best = step_best;
+		fprintf(stderr, "add %-8lu ", (unsigned long)sizes[best_idx].size);
+		print_result(stderr, "", &best);
+	}
+
+	if (out_path != NULL){
+		out = fopen(out_path, "w");
+		if (out == NULL){
+			printf("open %s failed\n", out_path);
+			return 1;
+		}
+	}
+
+	fprintf(out, "/* 由 mem_sizeclass_gen 根据调用跟踪 %s 生成，堆 %lu 字节，请勿手工修改\n", trace_path, (unsigned long)heap_size);
+	fprintf(out, " * 编译 mem_manage 时加 -DMEM_CONFIG_HEADER='\"<本文件名>\"'\n");
+	fprintf(out, " * 尺寸(字节)  申请次数\n");
+	for (i = 0; i < set_num; i++){
+		for (j = 0; (j < cand_num) && (sizes[j].size != set[i]); j++)
+			;
+		fprintf(out, " *   %-10lu %lu (%.1f%%)\n", (unsigned long)set[i], sizes[j].count,
+				(alloc_num == 0) ? 0.0 : (double)sizes[j].count * 100.0 / (double)alloc_num);
+	}
+	print_result(out, " * 不使用精确查找表: ", &base);
+	print_result(out, " * 使用精确查找表:   ", &best);
+	fprintf(out, " */\n\n#ifndef __MEM_SIZECLASS_H__\n#define __MEM_SIZECLASS_H__\n\n");
+	if (set_num > 0){
+		fprintf(out, "#define MEM_EXACT_FIT_EN		1\n");
+		fprintf(out, "#define MEM_EXACT_SLOT_NUM		%d\n", (int)MEM_EXACT_SLOT_NUM);
+		fprintf(out, "#define MEM_EXACT_SIZES			{");
+		for (i = 0; i < set_num; i++)
+			fprintf(out, "%s %lu", (i == 0) ? "" : ",", (unsigned long)set[i]);
+		fprintf(out, " }\n");
+	}
+	else{
+		fprintf(out, "/* 精确查找表不能降低该跟踪的碎片，保持关闭 */\n");
+	}
+	fprintf(out, "\n#endif\n");
+
+	if (out != stdout)
+		fclose(out);
+	free(ops);
+	free(sizes);
+	free(used);
+	free(ptrs);
+	free(heap);
+	return 0;
+}
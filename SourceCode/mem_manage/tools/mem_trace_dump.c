@@ -0,0 +1,89 @@
+/**
+ * @file: mem_trace_dump.c
+ * @author: LinusZhao
+ * @brief: 主机工具，把 memTraceDrain 输出的调用跟踪数据打印为文本
+ * @version: 1.0.0
+ * @date: 2021-01-01
+ * @attention: 编译与使用:
+ *	gcc -I../include -o mem_trace_dump mem_trace_dump.c
+ *	./mem_trace_dump trace.bin
+ * 输出每行一条记录: 时间戳 操作 参数 [调用者]，偏移已换算为相对第一个堆区域的字节偏移
+ **/
+
+#include "mem_trace_reader.h"
+
+// 跟踪记录中的偏移换算为字节偏移，-1 表示空指针
+static long long to_byte_offset(const mem_trace_reader_t *reader, uint64_t offset)
+{
+	return (offset == 0) ? -1 : (long long)((offset - 1) * reader->align);
+}
+
+int main(int argc, char **argv)
+{
+	mem_trace_reader_t reader;
+	mem_trace_record_t record;
+	uint8_t *data;
+	long len;
+	FILE *fp;
+	int ret;
+	unsigned long count = 0;
+
+	if (argc < 2){
+		printf("usage: %s <trace.bin>\n", argv[0]);
+		return 1;
+	}
+
+	fp = fopen(argv[1], "rb");
+	if (fp == NULL){
+		printf("open %s failed\n", argv[1]);
+		return 1;
+	}
+	fseek(fp, 0, SEEK_END);
+	len = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	data = (uint8_t *)malloc(len > 0 ? (size_t)len : 1);
+	if ((data == NULL) || (fread(data, 1, (size_t)len, fp) != (size_t)len)){
+		printf("read %s failed\n", argv[1]);
+		fclose(fp);
+		return 1;
+	}
+	fclose(fp);
+
+	if (mem_trace_reader_init(&reader, data, (size_t)len) != 0){
+		printf("not a mem_manage trace (version %d expected)\n", MEM_TRACE_VERSION);
+		free(data);
+		return 2;
+	}
+
+	while ((ret = mem_trace_reader_next(&reader, &record)) > 0){
+		count++;
+		printf("%llu ", (unsigned long long)record.timestamp);
+		switch (record.op){
+		case MEM_TRACE_OP_MALLOC:
+			printf("malloc %llu -> %lld", (unsigned long long)record.size, to_byte_offset(&reader, record.offset));
+			break;
+		case MEM_TRACE_OP_CALLOC:
+			printf("calloc %llu -> %lld", (unsigned long long)record.size, to_byte_offset(&reader, record.offset));
+			break;
+		case MEM_TRACE_OP_FREE:
+			printf("free %lld", to_byte_offset(&reader, record.offset));
+			break;
+		case MEM_TRACE_OP_REALLOC:
+			printf("realloc %lld %llu -> %lld", to_byte_offset(&reader, record.old_offset),
+					(unsigned long long)record.size, to_byte_offset(&reader, record.offset));
+			break;
+		case MEM_TRACE_OP_DROPPED:
+			printf("dropped %llu", (unsigned long long)record.dropped);
+			break;
+		}
+		if (record.caller != 0)
+			printf(" @0x%llx", (unsigned long long)record.caller);
+		printf("\n");
+	}
+
+	if (ret < 0)
+		printf("trace truncated after %lu records\n", count);
+
+	free(data);
+	return (ret < 0) ? 2 : 0;
+}
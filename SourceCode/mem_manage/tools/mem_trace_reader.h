@@ -0,0 +1,120 @@
+/**
+ * @file: mem_trace_reader.h
+ * @author: LinusZhao
+ * @brief: 主机工具共用的调用跟踪数据解析，数据格式见 mem_manage.h 中 MEM_TRACE_VERSION 的说明
+ * @version: 1.0.0
+ * @date: 2021-01-01
+ **/
+
+#ifndef __MEM_TRACE_READER_H__
+#define __MEM_TRACE_READER_H__
+
+#include "mem_manage.h"
+
+typedef struct mem_trace_record_s
+{
+	uint8_t op;					// MEM_TRACE_OP_xxx
+	uint64_t timestamp;			// 自流开始累计的时间戳
+	uint64_t size;				// MALLOC/CALLOC/REALLOC 的申请字节数
+	uint64_t offset;			// 返回偏移(FREE 为释放的偏移)，0 表示空指针
+	uint64_t old_offset;		// REALLOC 的原偏移
+	uint64_t dropped;			// DROPPED 记录的丢弃条数
+	uint64_t caller;			// 调用者地址，未记录时为 0
+} mem_trace_record_t;
+
+typedef struct mem_trace_reader_s
+{
+	const uint8_t *data;
+	size_t len;
+	size_t pos;
+	uint8_t align;
+	uint64_t timestamp;
+} mem_trace_reader_t;
+
+static int mem_trace_read_varint(mem_trace_reader_t *reader, uint64_t *value)
+{
+	int shift = 0;
+	uint8_t c;
+
+	*value = 0;
+	while (reader->pos < reader->len){
+		c = reader->data[reader->pos++];
+		*value |= (uint64_t)(c & 0x7F) << shift;
+		if ((c & 0x80) == 0)
+			return 0;
+		shift += 7;
+		if (shift > 63)
+			return -1;
+	}
+	return -1;
+}
+
+/************************************
+ * @brief: 		检查流头并初始化解析器
+ * @return 		0-成功，其他为格式错误
+ *************************************/
+static int mem_trace_reader_init(mem_trace_reader_t *reader, const uint8_t *data, size_t len)
+{
+	memset(reader, 0, sizeof(mem_trace_reader_t));
+	if ((len < 4) || (data[0] != 'M') || (data[1] != 'T') || (data[2] != MEM_TRACE_VERSION) || (data[3] == 0))
+		return -1;
+
+	reader->data = data;
+	reader->len = len;
+	reader->pos = 4;
+	reader->align = data[3];
+	return 0;
+}
+
+/************************************
+ * @brief: 		解析下一条记录
+ * @return 		1-得到一条记录，0-数据结束，-1-数据截断或格式错误
+ *************************************/
+static int mem_trace_reader_next(mem_trace_reader_t *reader, mem_trace_record_t *record)
+{
+	uint64_t delta;
+	uint8_t head;
+
+	if (reader->pos >= reader->len)
+		return 0;
+
+	memset(record, 0, sizeof(mem_trace_record_t));
+	head = reader->data[reader->pos++];
+	record->op = head & MEM_TRACE_OP_MASK;
+
+	if (record->op == MEM_TRACE_OP_DROPPED){
+		record->timestamp = reader->timestamp;
+		return (mem_trace_read_varint(reader, &record->dropped) == 0) ? 1 : -1;
+	}
+
+	if (mem_trace_read_varint(reader, &delta) != 0)
+		return -1;
+	reader->timestamp += delta;
+	record->timestamp = reader->timestamp;
+
+	switch (record->op){
+	case MEM_TRACE_OP_MALLOC:
+	case MEM_TRACE_OP_CALLOC:
+		if ((mem_trace_read_varint(reader, &record->size) != 0) || (mem_trace_read_varint(reader, &record->offset) != 0))
+			return -1;
+		break;
+	case MEM_TRACE_OP_FREE:
+		if (mem_trace_read_varint(reader, &record->offset) != 0)
+			return -1;
+		break;
+	case MEM_TRACE_OP_REALLOC:
+		if ((mem_trace_read_varint(reader, &record->old_offset) != 0) || (mem_trace_read_varint(reader, &record->size) != 0)
+			|| (mem_trace_read_varint(reader, &record->offset) != 0))
+			return -1;
+		break;
+	default:
+		return -1;
+	}
+
+	if ((head & MEM_TRACE_FLAG_CALLER) && (mem_trace_read_varint(reader, &record->caller) != 0))
+		return -1;
+
+	return 1;
+}
+
+#endif
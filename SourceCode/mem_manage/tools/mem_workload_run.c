@@ -0,0 +1,174 @@
+/**
+ * @file: mem_workload_run.c
+ * @author: LinusZhao
+ * @brief: 主机工具，用 mem_workload 的一组标准场景压测 mem_manage，输出可跨引擎/配置对比的结果表
+ * @version: 1.0.0
+ * @date: 2021-01-01
+ * @attention: 编译与使用(配置项通过 -D 传入，与 mem_replay 相同):
+ *	gcc -O2 -I../include -D'MEM_MANAGE_PRINTF(...)=((void)0)' -o mem_workload_run \
+ *		mem_workload_run.c ../src/mem_workload.c ../src/mem_manage.c -lpthread
+ *	./mem_workload_run [-s 堆字节数] [-n 每阶段操作数] [-S 随机种子]
+ * 每个场景在同一个堆上运行，场景结束后释放全部存活块；producer-consumer 场景使用两个线程，
+ * mem_manage 在 SYSTEM_NO 下不带锁，由 pthread 互斥锁保护
+ **/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "mem_manage.h"
+#include "mem_workload.h"
+
+#define RUN_SLOT_NUM		512
+
+typedef struct run_scenario_s
+{
+	const char *name;
+	MemWorkloadPhase_t phases[3];
+	uint32_t phase_num;
+	int threaded;
+} run_scenario_t;
+
+static pthread_mutex_t run_lock = PTHREAD_MUTEX_INITIALIZER;
+static MemWorkloadSlot_t run_slots[RUN_SLOT_NUM];
+
+static void run_lock_take(void) { pthread_mutex_lock(&run_lock); }
+static void run_lock_give(void) { pthread_mutex_unlock(&run_lock); }
+static void run_yield(void) { sched_yield(); }
+
+static uint32_t run_tick_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)((uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL);
+}
+
+static int run_largest_cb(const MemHeapBlockInfo_t *pxInfo, void *pvArg)
+{
+	size_t *largest = (size_t *)pvArg;
+
+	if ((pxInfo->eState == MEM_BLOCK_FREE) && (pxInfo->xSize > *largest))
+		*largest = pxInfo->xSize;
+	return 0;
+}
+
+static size_t run_largest_free(void)
+{
+	size_t largest = 0;
+
+	memHeapWalk(run_largest_cb, &largest);
+	return largest;
+}
+
+static void *run_consumer(void *arg)
+{
+	memWorkloadConsumer((MemWorkload_t *)arg);
+	return NULL;
+}
+
+int main(int argc, char **argv)
+{
+	static uint8_t *heap;
+	MemHeapRegion_t regions[2];
+	mem_manage_t manage;
+	MemWorkloadConfig_t config;
+	MemWorkload_t workload;
+	MemWorkloadResult_t *res = &workload.xResult;
+	pthread_t consumer;
+	size_t heap_size = 64 * 1024;
+	uint32_t ops = 20000, seed = 125, i, p;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "s:n:S:")) != -1){
+		switch (opt){
+		case 's': heap_size = (size_t)strtoul(optarg, NULL, 0); break;
+		case 'n': ops = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'S': seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+		default:
+			printf("usage: %s [-s heap_size] [-n ops_per_phase] [-S seed]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	{
+		// 操作数在运行前按 -n 填入
+		run_scenario_t scenarios[] = {
+			{ "uniform-random",  { { 0, MEM_WL_SIZE_UNIFORM,     1, 210,  0,  0,   0,   0,  MEM_WL_LIFE_RANDOM, 60, 0 } }, 1, 0 },
+			{ "exp-fifo",        { { 0, MEM_WL_SIZE_EXPONENTIAL, 1, 4096, 96, 0,   0,   0,  MEM_WL_LIFE_FIFO,   60, 0 } }, 1, 0 },
+			{ "bimodal-lifo",    { { 0, MEM_WL_SIZE_BIMODAL,     8, 2048, 0,  64,  1024, 10, MEM_WL_LIFE_LIFO,  60, 0 } }, 1, 0 },
+			{ "pow2-random",     { { 0, MEM_WL_SIZE_POW2,        8, 2048, 0,  0,   0,   0,  MEM_WL_LIFE_RANDOM, 60, 0 } }, 1, 0 },
+			{ "phased",          { { 0, MEM_WL_SIZE_UNIFORM,     16, 64,  0,  0,   0,   0,  MEM_WL_LIFE_RANDOM, 70, 0 },
+								   { 0, MEM_WL_SIZE_BIMODAL,     16, 2048, 0, 64,  1024, 20, MEM_WL_LIFE_FIFO,  50, 64 },
+								   { 0, MEM_WL_SIZE_POW2,        16, 512, 0,  0,   0,   0,  MEM_WL_LIFE_LIFO,   65, 0 } }, 3, 0 },
+			{ "producer-consumer", { { 0, MEM_WL_SIZE_EXPONENTIAL, 1, 4096, 128, 0, 0,   0,  MEM_WL_LIFE_PRODUCER_CONSUMER, 100, 0 } }, 1, 1 },
+		};
+
+		heap = (uint8_t *)malloc(heap_size);
+		if (heap == NULL){
+			printf("out of host memory\n");
+			return 1;
+		}
+		regions[0].pucStartAddress = heap;
+		regions[0].xSizeInBytes = heap_size;
+		regions[1].pucStartAddress = NULL;
+		regions[1].xSizeInBytes = 0;
+		memset(&manage, 0, sizeof(manage));
+		memManageFunctionInit(&manage, regions);
+
+		printf("heap %lu bytes, %lu ops per phase, seed %lu\n", (unsigned long)heap_size, (unsigned long)ops, (unsigned long)seed);
+		printf("%-18s %9s %11s %7s %10s %9s %8s %9s %8s %8s\n", "scenario", "ops", "ops/s", "fails",
+				"first_fail", "util@fail", "frag@fail", "frag_end", "blk_end", "corrupt");
+
+		for (i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++){
+			for (p = 0; p < scenarios[i].phase_num; p++)
+				scenarios[i].phases[p].ulOps = ops;
+
+			memset(&config, 0, sizeof(config));
+			config.pfMalloc = memMalloc;
+			config.pfFree = memFree;
+			config.pfFreeBytes = memGetFreeHeapSize;
+			config.pfLargestFree = run_largest_free;
+			config.pfFreeBlockNum = memGetFreeBlockNum;
+			config.pfTick = run_tick_us;
+			config.ulTickHz = 1000000;
+			config.pxPhases = scenarios[i].phases;
+			config.ulPhaseNum = scenarios[i].phase_num;
+			config.pxSlots = run_slots;
+			config.ulSlotNum = RUN_SLOT_NUM;
+			config.ulSeed = seed;
+			config.ucTouch = 1;
+			if (scenarios[i].threaded){
+				config.pfLock = run_lock_take;
+				config.pfUnlock = run_lock_give;
+				config.pfYield = run_yield;
+			}
+			memWorkloadInit(&workload, &config);
+
+			if (scenarios[i].threaded){
+				pthread_create(&consumer, NULL, run_consumer, &workload);
+				memWorkloadProducer(&workload);
+				pthread_join(consumer, NULL);
+			}
+			else{
+				memWorkloadRun(&workload);
+			}
+
+			// 千分比显示为百分比
+			printf("%-18s %9lu %11lu %7lu %10lu %8lu.%lu %7lu.%lu %7lu.%lu %8lu %8lu\n", scenarios[i].name,
+					(unsigned long)res->ulOps, (unsigned long)res->ulOpsPerSec, (unsigned long)res->ulFails,
+					(unsigned long)res->ulFirstFailOp,
+					(unsigned long)res->ulUtilizationAtFail / 10, (unsigned long)res->ulUtilizationAtFail % 10,
+					(unsigned long)res->ulFragmentationAtFail / 10, (unsigned long)res->ulFragmentationAtFail % 10,
+					(unsigned long)res->ulFragmentationFinal / 10, (unsigned long)res->ulFragmentationFinal % 10,
+					(unsigned long)res->ulFreeBlocksFinal, (unsigned long)res->ulCorrupts);
+
+			memWorkloadRelease(&workload);
+		}
+	}
+
+	free(heap);
+	return 0;
+}